@@ -70,12 +70,15 @@ NurseRostering::ObjValue rebuildSolution( const string &logFileName, const strin
         return -1;
     }
 
-    NurseRostering::AssignTable assign( problem.scenario.nurseNum );
+    NurseRostering::AssignTable assign( problem.scenario->nurseNum );
+    NurseRostering::ShiftID shift;
+    NurseRostering::SkillID skill;
     double totalObj = obj;
 
-    for (NurseRostering::NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    for (NurseRostering::NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         for (int weekday = NurseRostering::Weekday::Mon; weekday <= NurseRostering::Weekday::Sun; ++weekday) {
-            csvFile >> assign[nurse][weekday].shift >> assign[nurse][weekday].skill;
+            csvFile >> shift >> skill;
+            assign[nurse][weekday] = NurseRostering::Assign( shift, skill );
         }
     }
 
@@ -89,7 +92,7 @@ NurseRostering::ObjValue rebuildSolution( const string &logFileName, const strin
 
     // handle rest weeks
     for (++problem.history.pastWeekCount, ++week;
-        problem.history.pastWeekCount < problem.scenario.totalWeekNum;
+        problem.history.pastWeekCount < problem.scenario->totalWeekNum;
         ++problem.history.pastWeekCount, ++week) {
         // locate the line
         do {
@@ -123,9 +126,10 @@ NurseRostering::ObjValue rebuildSolution( const string &logFileName, const strin
             >> obj >> c >> accObj >> c;
         totalObj += obj;
 
-        for (NurseRostering::NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+        for (NurseRostering::NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
             for (int weekday = NurseRostering::Weekday::Mon; weekday <= NurseRostering::Weekday::Sun; ++weekday) {
-                csvFile >> assign[nurse][weekday].shift >> assign[nurse][weekday].skill;
+                csvFile >> shift >> skill;
+                assign[nurse][weekday] = NurseRostering::Assign( shift, skill );
             }
         }
 
@@ -84,73 +84,134 @@ const std::string hisPrefix( "/history-week" );
 const std::string solPrefix( "/sol-week" );
 const std::string fileSuffix( ".txt" );
 const std::string cusPrefix( "/custom-week" );
+const std::string bundlePrefix( "/Bd-" );
+const std::string bundleSuffix( ".bin" );
 
 const char *FeasibleCheckerHost = "themis.playhost.be";
 
 
-void testAllInstancesParallel( int threadNum, int round )
+void runJobs( std::vector<Job> jobs, int threadNum )
 {
-    struct Inst
+    class CmpDuration
     {
-        int index;
-        double timeout;
+    public:
+        // sort to (greatest ... least)
+        bool operator()( const Job &l, const Job &r )
+        {
+            return (l.duration() > r.duration());
+        }
     };
 
-    class CmpTime
+    class Worker
     {
     public:
-        // sort to (least ... greatest)
-        bool operator()( const Inst &l, const Inst &r )
+        Worker() : load( 0 ) {}
+
+        std::mutex mtx;
+        std::deque<Job> jobs;   // longest job in the front
+        double load;            // total duration of jobs
+    };
+
+    class Scheduler
+    {
+    public:
+        Scheduler( int threadNum ) : workers( threadNum ) {}
+
+        // the longest job of its own, or of the most loaded thread
+        bool pop( int threadIndex, Job &job )
         {
-            return (l.timeout > r.timeout);
+            if (popFront( threadIndex, job )) { return true; }
+
+            for (;;) {
+                int victim = -1;
+                double maxLoad = 0;
+                for (int t = 0; t < static_cast<int>(workers.size()); ++t) {
+                    lock_guard<mutex> lock( workers[t].mtx );
+                    if (!workers[t].jobs.empty() && ((victim < 0) || (workers[t].load > maxLoad))) {
+                        victim = t;
+                        maxLoad = workers[t].load;
+                    }
+                }
+                // no one adds jobs while running
+                if (victim < 0) { return false; }
+                // retry if the victim has taken its last job meanwhile
+                if (popFront( victim, job )) { return true; }
+            }
+        }
+
+        void work( int threadIndex )
+        {
+            ostringstream id;
+            id << threadIndex;
+            Job job( 0, '0', string(), 0, 0 );
+            while (pop( threadIndex, job )) {
+                runJob( id.str(), job );
+            }
+        }
+
+        std::vector<Worker> workers;
+
+    private:
+        bool popFront( int threadIndex, Job &job )
+        {
+            Worker &worker( workers[threadIndex] );
+            lock_guard<mutex> lock( worker.mtx );
+            if (worker.jobs.empty()) { return false; }
+            job = worker.jobs.front();
+            worker.jobs.pop_front();
+            worker.load -= job.duration();
+            return true;
         }
     };
 
-    vector<Inst> inst( testCases.size() );
-    for (unsigned i = 0; i < inst.size(); ++i) {
-        int instIndex = instIndexMap.at( testCases[i].instName );
-        inst[i].index = i;
-        inst[i].timeout = instTimeout[getNurseNum( instIndex )] * getWeekNum( instIndex );
-    }
-    sort( inst.begin(), inst.end(), CmpTime() );
+    if (threadNum < 1) { threadNum = 1; }
+    sort( jobs.begin(), jobs.end(), CmpDuration() );
 
-    vector<double> timespend( threadNum, 0 );
-    vector<thread> vt( threadNum );
+    Scheduler scheduler( threadNum );
+    for (auto iter = jobs.begin(); iter != jobs.end(); ++iter) {
+        int leastLoaded = 0;
+        for (int t = 1; t < threadNum; ++t) {
+            if (scheduler.workers[t].load < scheduler.workers[leastLoaded].load) {
+                leastLoaded = t;
+            }
+        }
+        scheduler.workers[leastLoaded].jobs.push_back( *iter );
+        scheduler.workers[leastLoaded].load += iter->duration();
+    }
 
-    queue<int> idleThread;
+    vector<thread> vt;
     for (int i = 0; i < threadNum; ++i) {
-        idleThread.push( i );
+        vt.push_back( thread( &Scheduler::work, &scheduler, i ) );
     }
+    for (int i = 0; i < threadNum; ++i) {
+        vt[i].join();
+    }
+}
+
+double Job::duration() const
+{
+    return timeoutInSec * getWeekNum( instIndex );
+}
+
+void runJob( const std::string &id, const Job &job )
+{
+    test_inProcess_r( id, outputDirPrefix + id, job.instIndex,
+        job.initHis, job.weekdataSeq.c_str(), job.timeoutInSec, job.randSeed );
+}
+
+void testAllInstancesParallel( int threadNum, int round )
+{
+    vector<Job> jobs;
     for (; round > 0; --round) {
-        for (auto iter = inst.begin(); iter != inst.end();) {
-            if (!idleThread.empty()) {
-                int newThread = idleThread.front();
-                idleThread.pop();
-                timespend[newThread] += iter->timeout;
-
-                ostringstream id;
-                id << newThread;
-                int randSeed = static_cast<int>(rand() + time( NULL ) + clock());
-                if (vt[newThread].joinable()) { vt[newThread].join(); }
-                int instIndex = instIndexMap.at( testCases[iter->index].instName );
-                vt[newThread] = thread( test_customIO_r, id.str(), outputDirPrefix + id.str(), instIndex,
-                    testCases[iter->index].initHis, testCases[iter->index].weekdataSeq.c_str(), instTimeout[getNurseNum( instIndex )], randSeed );
-                ++iter;
-            } else {
-                int firstFinishThread = 0;
-                for (int t = 0; t < threadNum; ++t) {
-                    if (timespend[t] < timespend[firstFinishThread]) {
-                        firstFinishThread = t;
-                    }
-                }
-                vt[firstFinishThread].join();
-                idleThread.push( firstFinishThread );
-            }
+        for (auto iter = testCases.begin(); iter != testCases.end(); ++iter) {
+            int instIndex = instIndexMap.at( iter->instName );
+            int randSeed = static_cast<int>(rand() + time( NULL ) + clock());
+            jobs.push_back( Job( instIndex, iter->initHis, iter->weekdataSeq,
+                instTimeout[getNurseNum( instIndex )], randSeed ) );
         }
     }
-    for (int i = 0; i < threadNum; ++i) {
-        if (vt[i].joinable()) { vt[i].join(); }
-    }
+
+    runJobs( jobs, threadNum );
 }
 
 void testHeterogeneousInstancesWithPreloadedInstSeq( const std::string &id, int runCount )
@@ -299,6 +360,22 @@ void genInstanceSequence( int instIndex, char &initHis, char weekdata[WEEKDATA_S
     } while (!feasible);
 }
 
+bool makeBundle( int instIndex )
+{
+    string dir( instanceDir + instance[instIndex] );
+    string sce = dir + scePrefix + instance[instIndex] + fileSuffix;
+    vector<string> hisFiles;
+    for (char h = '0'; h < '0' + INIT_HIS_NUM; ++h) {
+        hisFiles.push_back( dir + initHisPrefix + instance[instIndex] + '-' + h + fileSuffix );
+    }
+    vector<string> weekdataFiles;
+    for (char w = '0'; w < '0' + WEEKDATA_NUM; ++w) {
+        weekdataFiles.push_back( dir + weekPrefix + instance[instIndex] + '-' + w + fileSuffix );
+    }
+
+    return writeBundle( dir + bundlePrefix + instance[instIndex] + bundleSuffix, sce, hisFiles, weekdataFiles );
+}
+
 void makeSureDirExist( const string &dir )
 {
 #ifdef WIN32
@@ -406,6 +483,203 @@ void test_customIO_r( const std::string &id, const std::string &outputDir, int i
     run( argc, argv );
 }
 
+void test_inProcess_r( const std::string &id, const std::string &outputDir, int instIndex, char initHis, const char *weeks, double timeoutInSec, int randSeed )
+{
+    makeSureDirExist( outputDir );
+
+    // refer to the records in bundle by "bundle#/Sc-nXXXwX.txt" and so on
+    string dir( instanceDir + instance[instIndex] );
+    string bundle( dir + bundlePrefix + instance[instIndex] + bundleSuffix );
+    if (ifstream( bundle ).is_open()) {
+        dir = bundle + BUNDLE_RECORD_SEPARATOR;
+    }
+
+    string sce = dir + scePrefix + instance[instIndex] + fileSuffix;
+    string his = dir + initHisPrefix + instance[instIndex] + '-' + initHis + fileSuffix;
+    vector<string> weekdata;
+    for (int w = 0; w < getWeekNum( instIndex ); ++w) {
+        weekdata.push_back( dir + weekPrefix + instance[instIndex] + '-' + weeks[w] + fileSuffix );
+    }
+
+    runWeeks( id, configString, sce, his, weekdata, timeoutInSec, randSeed, outputDir + solPrefix );
+}
+
+void testIterationSpeed( int instIndex, char initHis, char week, double timeoutInSec, int randSeed )
+{
+    string sce = instanceDir + instance[instIndex] + scePrefix + instance[instIndex] + fileSuffix;
+    string his = instanceDir + instance[instIndex] + initHisPrefix + instance[instIndex] + '-' + initHis + fileSuffix;
+    string weekdata = instanceDir + instance[instIndex] + weekPrefix + instance[instIndex] + '-' + week + fileSuffix;
+
+    NurseRostering input;
+    if (!(readScenario( sce, input ) && readWeekData( weekdata, input ) && readHistory( his, input ))) {
+        return;
+    }
+    input.randSeed = randSeed;
+    input.timeout = Timer::Duration( static_cast<int>(timeoutInSec *
+        chrono::duration_cast<Timer::Duration>(chrono::seconds( 1 )).count()) );
+    input.maxIterCount = NurseRostering::MAX_ITER_COUNT;
+    input.adjustRangeOfTotalAssignByWorkload();
+
+    Timer::TimePoint startTime = Timer::Clock::now();
+    NurseRostering::TabuSolver solver( input, startTime );
+    solver.init( parseConfig( configString ) );
+    solver.solve();
+    double duration = chrono::duration_cast<chrono::milliseconds>(Timer::Clock::now() - startTime).count() / 1000.0;
+
+    cout << "[SPEED] " << instance[instIndex] << ' '
+        << "iter: " << solver.getIterationCount() << ' '
+        << "gen: " << solver.getGenerationCount() << ' '
+        << "time: " << duration << "s "
+        << "speed: " << (solver.getIterationCount() / duration) << " iter/s "
+        << (solver.getGenerationCount() / duration) << " gen/s "
+        << "obj: " << (solver.getOptima().getObjValue() / static_cast<double>(NurseRostering::DefaultPenalty::AMP)) << endl;
+}
+
+// compare the data read from scenario files, assist data generated by solver is not compared
+bool isSameScenario( const NurseRostering &l, const NurseRostering &r )
+{
+    const NurseRostering::Scenario &ls( *l.scenario );
+    const NurseRostering::Scenario &rs( *r.scenario );
+    if ((ls.maxWeekCount != rs.maxWeekCount) || (ls.totalWeekNum != rs.totalWeekNum)
+        || (ls.shiftTypeNum != rs.shiftTypeNum) || (ls.shiftSize != rs.shiftSize)
+        || (ls.skillTypeNum != rs.skillTypeNum) || (ls.skillSize != rs.skillSize)
+        || (ls.nurseNum != rs.nurseNum) || (ls.shifts.size() != rs.shifts.size())
+        || (ls.contracts.size() != rs.contracts.size()) || (ls.nurses.size() != rs.nurses.size())) {
+        return false;
+    }
+    for (unsigned i = NurseRostering::Scenario::Shift::ID_BEGIN; i < ls.shifts.size(); ++i) {
+        const NurseRostering::Scenario::Shift &lsh( ls.shifts[i] );
+        const NurseRostering::Scenario::Shift &rsh( rs.shifts[i] );
+        if ((lsh.minConsecutiveShiftNum != rsh.minConsecutiveShiftNum)
+            || (lsh.maxConsecutiveShiftNum != rsh.maxConsecutiveShiftNum)
+            || (lsh.legalNextShifts != rsh.legalNextShifts)
+            || (lsh.illegalNextShiftNum != rsh.illegalNextShiftNum)) {
+            return false;
+        }
+    }
+    for (unsigned i = 0; i < ls.contracts.size(); ++i) {
+        const NurseRostering::Scenario::Contract &lc( ls.contracts[i] );
+        const NurseRostering::Scenario::Contract &rc( rs.contracts[i] );
+        if ((lc.minShiftNum != rc.minShiftNum) || (lc.maxShiftNum != rc.maxShiftNum)
+            || (lc.minConsecutiveDayNum != rc.minConsecutiveDayNum)
+            || (lc.maxConsecutiveDayNum != rc.maxConsecutiveDayNum)
+            || (lc.minConsecutiveDayoffNum != rc.minConsecutiveDayoffNum)
+            || (lc.maxConsecutiveDayoffNum != rc.maxConsecutiveDayoffNum)
+            || (lc.maxWorkingWeekendNum != rc.maxWorkingWeekendNum)
+            || (lc.completeWeekend != rc.completeWeekend) || (lc.nurses != rc.nurses)) {
+            return false;
+        }
+    }
+    for (unsigned i = 0; i < ls.nurses.size(); ++i) {
+        const NurseRostering::Scenario::Nurse &ln( ls.nurses[i] );
+        const NurseRostering::Scenario::Nurse &rn( rs.nurses[i] );
+        if ((ln.contract != rn.contract) || (ln.skillNum != rn.skillNum) || (ln.skills != rn.skills)) {
+            return false;
+        }
+    }
+
+    const NurseRostering::Names &lnm( *l.names );
+    const NurseRostering::Names &rnm( *r.names );
+    return ((lnm.scenarioName == rnm.scenarioName)
+        && (lnm.skillNames == rnm.skillNames) && (lnm.skillMap == rnm.skillMap)
+        && (lnm.shiftNames == rnm.shiftNames) && (lnm.shiftMap == rnm.shiftMap)
+        && (lnm.contractNames == rnm.contractNames) && (lnm.contractMap == rnm.contractMap)
+        && (lnm.nurseNames == rnm.nurseNames) && (lnm.nurseMap == rnm.nurseMap));
+}
+
+bool isSameWeekData( const NurseRostering &l, const NurseRostering &r )
+{
+    const NurseRostering::WeekData &lw( l.weekData );
+    const NurseRostering::WeekData &rw( r.weekData );
+    return ((lw.shiftOffs == rw.shiftOffs) && (lw.optNurseNums == rw.optNurseNums)
+        && (lw.minNurseNums == rw.minNurseNums));
+}
+
+bool isSameHistory( const NurseRostering &l, const NurseRostering &r )
+{
+    const NurseRostering::History &lh( l.history );
+    const NurseRostering::History &rh( r.history );
+    return ((lh.accObjValue == rh.accObjValue) && (lh.pastWeekCount == rh.pastWeekCount)
+        && (lh.currentWeek == rh.currentWeek) && (lh.restWeekCount == rh.restWeekCount)
+        && (lh.totalAssignNums == rh.totalAssignNums)
+        && (lh.totalWorkingWeekendNums == rh.totalWorkingWeekendNums)
+        && (lh.lastShifts == rh.lastShifts)
+        && (lh.consecutiveShiftNums == rh.consecutiveShiftNums)
+        && (lh.consecutiveDayNums == rh.consecutiveDayNums)
+        && (lh.consecutiveDayoffNums == rh.consecutiveDayoffNums));
+}
+
+void testParseSpeed( int instIndex, int round )
+{
+    string dir( instanceDir + instance[instIndex] );
+    string sce = dir + scePrefix + instance[instIndex] + fileSuffix;
+    vector<string> hisFiles;
+    for (char h = '0'; h < '0' + INIT_HIS_NUM; ++h) {
+        hisFiles.push_back( dir + initHisPrefix + instance[instIndex] + '-' + h + fileSuffix );
+    }
+    vector<string> weekdataFiles;
+    for (char w = '0'; w < '0' + WEEKDATA_NUM; ++w) {
+        weekdataFiles.push_back( dir + weekPrefix + instance[instIndex] + '-' + w + fileSuffix );
+    }
+
+    NurseRostering streamScenario;
+    NurseRostering fastScenario;
+    if (!(parseScenario( sce, streamScenario ) && parseScenario_Fast( sce, fastScenario ))) {
+        return;
+    }
+
+    chrono::nanoseconds streamTime( 0 );
+    chrono::nanoseconds fastTime( 0 );
+    for (int i = 0; i < round; ++i) {
+        Timer::TimePoint startTime = Timer::Clock::now();
+        NurseRostering streamInput;
+        parseScenario( sce, streamInput );
+        for (unsigned h = 0; h < hisFiles.size(); ++h) {
+            readHistory( hisFiles[h], streamInput );
+        }
+        for (unsigned w = 0; w < weekdataFiles.size(); ++w) {
+            readWeekData( weekdataFiles[w], streamInput );
+        }
+        Timer::TimePoint endTime = Timer::Clock::now();
+        streamTime += (endTime - startTime);
+
+        startTime = Timer::Clock::now();
+        NurseRostering fastInput;
+        parseScenario_Fast( sce, fastInput );
+        fastInput.nameTables = genNameTables( *fastInput.names );
+        for (unsigned h = 0; h < hisFiles.size(); ++h) {
+            readHistory_Fast( hisFiles[h], fastInput );
+        }
+        for (unsigned w = 0; w < weekdataFiles.size(); ++w) {
+            readWeekData_Fast( weekdataFiles[w], fastInput );
+        }
+        endTime = Timer::Clock::now();
+        fastTime += (endTime - startTime);
+    }
+
+    // compare each file on the same scenario
+    bool isSame = isSameScenario( streamScenario, fastScenario );
+    for (unsigned h = 0; isSame && (h < hisFiles.size()); ++h) {
+        NurseRostering streamInput( streamScenario );
+        NurseRostering fastInput( streamScenario );
+        isSame = (readHistory( hisFiles[h], streamInput ) == readHistory_Fast( hisFiles[h], fastInput ))
+            && isSameHistory( streamInput, fastInput );
+    }
+    for (unsigned w = 0; isSame && (w < weekdataFiles.size()); ++w) {
+        NurseRostering streamInput( streamScenario );
+        NurseRostering fastInput( streamScenario );
+        isSame = (readWeekData( weekdataFiles[w], streamInput ) == readWeekData_Fast( weekdataFiles[w], fastInput ))
+            && isSameWeekData( streamInput, fastInput );
+    }
+
+    double fileNum = static_cast<double>(round * (1 + hisFiles.size() + weekdataFiles.size()));
+    cout << "[PARSE] " << instance[instIndex] << ' '
+        << "stream: " << (chrono::duration_cast<chrono::microseconds>(streamTime).count() / fileNum) << "us/file "
+        << "fast: " << (chrono::duration_cast<chrono::microseconds>(fastTime).count() / fileNum) << "us/file "
+        << "speedup: " << (static_cast<double>(streamTime.count()) / fastTime.count()) << ' '
+        << (isSame ? "same" : "DIFFERENT") << endl;
+}
+
 void prepareArgv_FirstWeek( const std::string &id, const std::string &outputDir, char *argv[], char argvBuf[][MAX_ARGV_LEN], int i, char h, char w, const std::string &t, const std::string &r, const std::string &co )
 {
     string sce = instanceDir + instance[i] + scePrefix + instance[i] + fileSuffix;
@@ -18,6 +18,8 @@
 #include <chrono>
 #include <algorithm>
 #include <queue>
+#include <deque>
+#include <mutex>
 #include <cstring>
 #include <cstdlib>
 
@@ -74,6 +76,25 @@ public:
     std::string weekdataSeq;
 };
 
+// one run on a weekdata sequence of an instance
+struct Job
+{
+public:
+    Job( int inst, char his, const std::string &seq, double timeout, int seed )
+        : instIndex( inst ), initHis( his ), weekdataSeq( seq ), timeoutInSec( timeout ), randSeed( seed )
+    {
+    }
+
+    // estimated running time of all weeks
+    double duration() const;
+
+    int instIndex;
+    char initHis;
+    std::string weekdataSeq;
+    double timeoutInSec;    // for each week
+    int randSeed;
+};
+
 static const int MAX_ARGV_LEN = 256;
 static const int INIT_HIS_NUM = 3;
 static const int WEEKDATA_NUM = 10;
@@ -102,6 +123,8 @@ extern const std::string hisPrefix;
 extern const std::string solPrefix;
 extern const std::string fileSuffix;
 extern const std::string cusPrefix;
+extern const std::string bundlePrefix;
+extern const std::string bundleSuffix;
 
 extern const char *FeasibleCheckerHost;
 
@@ -125,6 +148,15 @@ void genInstanceSequence( int instIndex, char &initHis, char weekdata[WEEKDATA_S
 
 void makeSureDirExist( const std::string &dir );
 
+// bundle all input files of an instance into the instance directory
+bool makeBundle( int instIndex );
+// run jobs on threadNum threads with id from 0 to (threadNum - 1).
+// jobs are dealt to the least loaded thread in longest-job-first order,
+// and a thread steals the longest job of the most loaded one when idle
+void runJobs( std::vector<Job> jobs, int threadNum );
+// run job on the thread with certain id
+void runJob( const std::string &id, const Job &job );
+
 void testAllInstancesParallel( int threadNum, int round );
 void testHeterogeneousInstancesWithPreloadedInstSeq( const std::string &id, int runCount );
 void testAllInstancesWithPreloadedInstSeq( const std::string &id, int runCount );
@@ -133,6 +165,14 @@ void test( const std::string &id, const std::string &outputDir, int instIndex, c
 void test_r( const std::string &id, const std::string &outputDir, int instIndex, char initHis, const char *weeks, double timeoutInSec, int randSeed );
 void test_customIO( const std::string &id, const std::string &outputDir, int instIndex, char initHis, const char *weeks, double timeoutInSec );
 void test_customIO_r( const std::string &id, const std::string &outputDir, int instIndex, char initHis, const char *weeks, double timeoutInSec, int randSeed );
+// solve all weeks in current process without reading history from files.
+// the input files are read from the bundle of the instance if it exists
+void test_inProcess_r( const std::string &id, const std::string &outputDir, int instIndex, char initHis, const char *weeks, double timeoutInSec, int randSeed );
+// solve the first week of an instance in current thread and print iterations per second
+void testIterationSpeed( int instIndex, char initHis, char week, double timeoutInSec, int randSeed );
+// parse all input files of an instance by iostream and by tokenizer for round times,
+// print the parse time of each parser and whether they produce the same input
+void testParseSpeed( int instIndex, int round );
 void prepareArgv_FirstWeek( const std::string &id, const std::string &outputDir, char *argv[], char argvBuf[][MAX_ARGV_LEN], int instIndex, char initHis,
     char week, const std::string &timeoutInSec, const std::string &randSeed = "", const std::string &cusOut = "" );
 void prepareArgv( const std::string &id, const std::string &outputDir, char *argv[], char argvBuf[][MAX_ARGV_LEN], int instIndex, const char *weeks, char week,
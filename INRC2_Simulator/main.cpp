@@ -35,66 +35,75 @@ void debugRun()
 // repeat many times to fully judge the performance
 void realRun()
 {
-    ostringstream id;
-
     int runCount = 8;
     int seedForInstSeq = 222;
-    int threadBeginInterval = 3;
-    vector<thread> vt;
     int threadNum = thread::hardware_concurrency() / 2;
     threadNum += (threadNum == 0);
-    for (int i = 0; i < threadNum; ++i) {
-        id.str( string() );
-        id << i;
-        vt.push_back( thread( testAllInstances, id.str(), runCount, seedForInstSeq ) );
-        this_thread::sleep_for( chrono::seconds( threadBeginInterval ) );
-    }
-    for (int i = 0; i < threadNum; ++i) {
-        vt[i].join();
+
+    // each sequence is run threadNum times with different rand seeds
+    vector<Job> jobs;
+    char initHis;
+    char weekdata[WEEKDATA_SEQ_SIZE];
+    for (int i = runCount; i > 0; --i) {
+        for (int instIndex = InstIndex::n005w4; instIndex <= InstIndex::n120w8; ++instIndex) {
+            srand( seedForInstSeq );
+            seedForInstSeq = rand();
+            genInstanceSequence( instIndex, initHis, weekdata );
+            for (int t = 0; t < threadNum; ++t) {
+                int randSeed = static_cast<int>(rand() + time( NULL ) + clock());
+                jobs.push_back( Job( instIndex, initHis, string( weekdata, WEEKDATA_SEQ_SIZE ),
+                    instTimeout[getNurseNum( instIndex )], randSeed ) );
+            }
+        }
     }
+
+    runJobs( jobs, threadNum );
 }
 
 // all instances with fixed weekdata sequence on multi-threads
 // repeat less times to compare performance on certain sequence
 void benchmarkRun()
 {
-    ostringstream id;
-
     int runCount = 512;
-    int threadBeginInterval = 3;
     int threadNum = 8;
-    vector<thread> vt;
-    for (int i = 0; i < threadNum; ++i) {
-        id.str( string() );
-        id << i;
-        vt.push_back( thread( testAllInstancesWithPreloadedInstSeq, id.str(), runCount ) );
-        this_thread::sleep_for( chrono::seconds( threadBeginInterval ) );
-    }
-    for (int i = 0; i < threadNum; ++i) {
-        vt[i].join();
+
+    vector<Job> jobs;
+    for (int i = runCount * threadNum; i > 0; --i) {
+        for (auto iter = testCases.begin(); iter != testCases.end(); ++iter) {
+            int instIndex = instIndexMap.at( iter->instName );
+            int randSeed = static_cast<int>(rand() + time( NULL ) + clock());
+            jobs.push_back( Job( instIndex, iter->initHis, iter->weekdataSeq,
+                instTimeout[getNurseNum( instIndex )], randSeed ) );
+        }
     }
+
+    runJobs( jobs, threadNum );
 }
 
 // heterogeneous instances with fixed weekdata sequence on multi-threads
 // repeat even less times to adjust arguments
 void sprintRun()
 {
-    ostringstream id;
-
     int runCount = 3;
-    int threadBeginInterval = 3;
     int threadNum = 2;
     threadNum += (threadNum == 0);
-    vector<thread> vt;
-    for (int i = 0; i < threadNum; ++i) {
-        id.str( string() );
-        id << i;
-        vt.push_back( thread( testHeterogeneousInstancesWithPreloadedInstSeq, id.str(), runCount ) );
-        this_thread::sleep_for( chrono::seconds( threadBeginInterval ) );
-    }
-    for (int i = 0; i < threadNum; ++i) {
-        vt[i].join();
+
+    vector<Job> jobs;
+    for (int i = runCount * threadNum; i > 0; --i) {
+        for (auto iter = testCases.begin(); iter != testCases.end(); ++iter) {
+            int instIndex = instIndexMap.at( iter->instName );
+            // instances which have no need for test
+            if ((instIndex == InstIndex::n120w8)
+                || (instIndex == InstIndex::n100w8)) {
+                continue;
+            }
+            int randSeed = static_cast<int>(rand() + time( NULL ) + clock());
+            jobs.push_back( Job( instIndex, iter->initHis, iter->weekdataSeq,
+                instTimeout[getNurseNum( instIndex )], randSeed ) );
+        }
     }
+
+    runJobs( jobs, threadNum );
 }
 
 // make use of hardware concurrency in a single round rather than between rounds
@@ -106,6 +115,44 @@ void parallelRun()
     testAllInstancesParallel( threadNum, round );
 }
 
+// fixed week of the largest instance with fixed seed in a single thread
+// compare iterations per second between different implementations
+void speedRun()
+{
+    int runCount = 2;
+    int randSeed = 1;
+    double runningTime = 4;
+
+    // cover all instance sizes
+    for (int instIndex = InstIndex::n005w4; instIndex <= InstIndex::n120w8; ++instIndex) {
+        for (int i = 0; i < runCount; ++i) {
+            testIterationSpeed( instIndex, '0', '0', runningTime, randSeed );
+        }
+    }
+}
+
+// all input files of all instances in a single thread
+// compare the parse time of iostream and tokenizer
+void parseRun()
+{
+    int round = 64;
+
+    for (int instIndex = InstIndex::n005w4; instIndex <= InstIndex::n120w8; ++instIndex) {
+        testParseSpeed( instIndex, round );
+    }
+}
+
+// bundle input files of all instances, so the following runs
+// read a single binary file rather than parsing text files
+void bundleRun()
+{
+    for (int instIndex = InstIndex::n005w4; instIndex <= InstIndex::n120w8; ++instIndex) {
+        if (!makeBundle( instIndex )) {
+            cout << "[BUNDLE] fail to bundle " << instance[instIndex] << endl;
+        }
+    }
+}
+
 int main()
 {
     loadConfig();
@@ -119,6 +166,9 @@ int main()
     benchmarkRun();
     //sprintRun();
     //parallelRun();
+    //speedRun();
+    //parseRun();
+    //bundleRun();
 
     //system( "pause" );
     return 0;
@@ -31,6 +31,11 @@
 //#define INRC2_TRAJECTORY_REPORT
 #endif // INRC2_TRAJECTORY_REPORT
 
+// comment to compare packed assign tables without SSE2/AVX2 intrinsics
+#ifndef INRC2_USE_SIMD
+#define INRC2_USE_SIMD
+#endif
+
 
 // input switch
 // uncomment to check the feasibility of the instance from the online feasible checker
@@ -45,6 +50,11 @@
 #define INRC2_USE_TABU  // repair() has simple move only, will no tabu effect its execution?
 #endif
 
+// uncomment to store tabu stamps in 16 bits relative to an epoch which is re-based on overflow
+#ifndef INRC2_COMPACT_TABU_STAMP
+//#define INRC2_COMPACT_TABU_STAMP
+#endif
+
 // [fix] comment to start to consider min shift at the first week
 #ifndef INRC2_IGNORE_MIN_SHIFT_IN_EARLY_WEEKS
 #define INRC2_IGNORE_MIN_SHIFT_IN_EARLY_WEEKS
@@ -105,9 +115,20 @@
 #define INRC2_BLOCK_SWAP_PART 2
 #define INRC2_BLOCK_SWAP_RAND 3
 #define INRC2_BLOCK_SWAP_CACHED 4
+#define INRC2_BLOCK_SWAP_INDEXED 5
 
 #ifndef INRC2_BLOCK_SWAP_FIND_BEST
-#define INRC2_BLOCK_SWAP_FIND_BEST INRC2_BLOCK_SWAP_CACHED
+#define INRC2_BLOCK_SWAP_FIND_BEST INRC2_BLOCK_SWAP_INDEXED
+#endif
+
+// comment to re-evaluate swap without delta cache
+#ifndef INRC2_USE_SWAP_DELTA_CACHE
+#define INRC2_USE_SWAP_DELTA_CACHE
+#endif
+
+// comment to re-evaluate add, change and remove without delta cache
+#ifndef INRC2_USE_ASSIGN_DELTA_CACHE
+#define INRC2_USE_ASSIGN_DELTA_CACHE
 #endif
 
 // uncomment to use double head version of swap chain 
@@ -15,7 +15,12 @@
 #include <string>
 #include <sstream>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <sys/stat.h>
+#include <thread>
+#include <mutex>
+#include <memory>
 
 #include "DebugFlag.h"
 #include "NurseRostering.h"
@@ -30,6 +35,21 @@ namespace INRC2
 
     extern const std::string LOG_FILE_NAME;
 
+    // a file name like (bundleFileName + BUNDLE_RECORD_SEPARATOR + recordName)
+    // refers to the record in the bundle which is built from file recordName,
+    // if bundleFileName is an existing file and the file name itself does not
+    // exist, so ordinary paths with '#' are still opened as they are.
+    // directory in recordName is ignored
+    const char BUNDLE_RECORD_SEPARATOR = '#';
+    // all data in bundle file are int, the first one is BUNDLE_MAGIC
+    const int BUNDLE_MAGIC = 0x3242524e;    // "NRB2" in little-endian
+    const int BUNDLE_VERSION = 1;
+    // custom input/output carries the state from a week to the next one. all data are int,
+    // header { CUSTOM_MAGIC, CUSTOM_VERSION, nurseNum, flags, checksum, payloadSize } is
+    // followed by accObjValue, pastWeekCount, arrays in History and optionally the roster
+    const int CUSTOM_MAGIC = 0x3253524e;    // "NRS2" in little-endian
+    const int CUSTOM_VERSION = 1;
+
     extern const std::string ARGV_ID;
     extern const std::string ARGV_SCENARIO;
     extern const std::string ARGV_HISTORY;
@@ -41,6 +61,9 @@ namespace INRC2
     extern const std::string ARGV_TIME;  // in seconds
     extern const std::string ARGV_ITER;
     extern const std::string ARGV_CONFIG;
+    extern const std::string ARGV_SCAN_THREAD;
+    extern const std::string ARGV_THREAD;
+    extern const std::string ARGV_RESTART;
     extern const std::string ARGV_HELP;
 
     extern const std::string weekdayNames[NurseRostering::Weekday::SIZE];
@@ -50,10 +73,63 @@ namespace INRC2
     void help();
 
     int run( int argc, char *argv[] );
+    // init and solve, for running a solver in a thread of the portfolio
+    void solve( NurseRostering::TabuSolver &solver, const NurseRostering::Solver::Config &cfg, const std::string &runID );
+
+    // solve the weeks of an instance in current process. the scenario is read once
+    // and the history generated by each week is passed to the next week in memory.
+    // the solution of week w is written to (solutionFilePrefix + w + ".txt") in
+    // background if solutionFilePrefix is not empty. return false if any input fails
+    bool runWeeks( const std::string &id, const std::string &configString,
+        const std::string &scenarioFileName, const std::string &initHistoryFileName,
+        const std::vector<std::string> &weekDataFileNames, double timeoutInSec, int randSeed,
+        const std::string &solutionFilePrefix = std::string() );
+    // write solution and log of a week solved by runWeeks(), then delete the solver
+    // and its input. writing is skipped if solutionFileName is empty
+    void writeWeek( NurseRostering::TabuSolver *solver, const NurseRostering *input,
+        const std::string &solutionFileName, const std::string &instanceName );
 
+    // share scenario and names in the cache of loadScenario() with input
     bool readScenario( const std::string &scenarioFileName, NurseRostering &input );
+    // return the scenario parsed from file with its nurse-skill relation, which is
+    // shared by all runs in the process until the file is modified. the cache is
+    // keyed by canonical path, so "./a" and "a" share the same item. NULL if fails
+    std::shared_ptr<const NurseRostering> loadScenario( const std::string &scenarioFileName );
+    // parse scenario file by iostream without cache
+    bool parseScenario( const std::string &scenarioFileName, NurseRostering &input );
     bool readHistory( const std::string &historyFileName, NurseRostering &input );
     bool readWeekData( const std::string &weekDataFileName, NurseRostering &input );
+    // same as the ones above, but the file is read at once and tokenized in place,
+    // and names are resolved by NameTable rather than std::map.
+    // return false on unknown names instead of mapping them to 0
+    bool parseScenario_Fast( const std::string &scenarioFileName, NurseRostering &input );
+    bool readHistory_Fast( const std::string &historyFileName, NurseRostering &input );
+    bool readWeekData_Fast( const std::string &weekDataFileName, NurseRostering &input );
+    // build the name tables of input.names for readHistory_Fast() and readWeekData_Fast()
+    std::shared_ptr<const NurseRostering::NameTables> genNameTables( const NurseRostering::Names &names );
+
+    // instance bundle holds the scenario, histories and weekdata of an instance in
+    // a single binary file. it starts with header { BUNDLE_MAGIC, BUNDLE_VERSION,
+    // recordNum } followed by recordNum entries { type, nameOffset, nameLength,
+    // dataOffset, dataSize } where offsets and sizes are counted in int.
+    // the arrays in records follow the layout of Scenario, History and WeekData.
+    // the _Fast parsers above also accept records in bundle (see BUNDLE_RECORD_SEPARATOR).
+    // the bundle is mapped into memory, but the records are copied out of it into
+    // the vectors of NurseRostering, so only the parsing is saved rather than the copy.
+    // return false if any file fails to be read
+    bool writeBundle( const std::string &bundleFileName, const std::string &scenarioFileName,
+        const std::vector<std::string> &historyFileNames, const std::vector<std::string> &weekDataFileNames );
+    // return true if fileName refers to a record in bundle
+    bool isBundleRecord( const std::string &fileName, std::string &bundleFileName, std::string &recordName );
+    // return the record name if fileName refers to a record in bundle,
+    // or the file name without directory otherwise
+    std::string getShortFileName( const std::string &fileName );
+    // return the bundle mapped into memory, which is shared by all
+    // runs in the process until the file is modified. NULL if fails
+    std::shared_ptr<const MappedFile> loadBundle( const std::string &bundleFileName );
+    bool parseScenario_Bundle( const std::string &scenarioFileName, NurseRostering &input );
+    bool readHistory_Bundle( const std::string &historyFileName, NurseRostering &input );
+    bool readWeekData_Bundle( const std::string &weekDataFileName, NurseRostering &input );
     bool readCustomInput( const std::string &customInputFileName, NurseRostering &input );
     bool writeSolution( const std::string &solutionFileName, const NurseRostering::Solver &solver );
     bool writeCustomOutput( const std::string &customOutputFileName, const NurseRostering::Solver &solver );
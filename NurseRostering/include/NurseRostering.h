@@ -13,6 +13,9 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <memory>
+#include <cstring>
+#include <cassert>
 
 #include "DebugFlag.h"
 #include "utility.h"
@@ -58,6 +61,11 @@ public:
     typedef int ShiftID;    // NONE, ANY or non-negative number for a certain kind of shift
     typedef int SkillID;    // non-negative number for a certain kind of skill
 
+    // (ShiftMask >> shift) & 1 is the flag of that shift (shiftSize should not exceed 32)
+    typedef unsigned ShiftMask;
+    // (SkillMask >> skill) & 1 is the flag of that skill (skillSize should not exceed 32)
+    typedef unsigned SkillMask;
+
     // NurseNumsOnSingleAssign[day][shift][skill] is a number of nurse
     typedef std::vector< std::vector< std::vector<int> > > NurseNumsOnSingleAssign;
 
@@ -82,11 +90,16 @@ public:
             static const std::string NAME_NONE;
             static const ShiftID ID_BEGIN;
 
+            // isLegalNextShift( nextShift ) means nextShift
+            // is available to be succession of this shift
+            bool isLegalNextShift( ShiftID nextShift ) const
+            {
+                return (((legalNextShifts >> nextShift) & 1) != 0);
+            }
+
             int minConsecutiveShiftNum;
             int maxConsecutiveShiftNum;
-            // (legalNextShift[nextShift] == true) means nextShift 
-            // is available to be succession of this shift
-            std::vector<bool> legalNextShifts;
+            ShiftMask legalNextShifts;
             int illegalNextShiftNum;
         };
         std::vector<Shift> shifts;
@@ -119,13 +132,15 @@ public:
             static const NurseID ID_NONE;
 
             ContractID contract;
-            int restMinShiftNum;    // total assignments in the planning horizon
-            int restMaxShiftNum;    // total assignments in the planning horizon
-            int restMaxWorkingWeekendNum;   // total assignments in the planning horizon
+
+            // hasSkill( skill ) means the nurse have that skill
+            bool hasSkill( SkillID skill ) const
+            {
+                return (((skills >> skill) & 1) != 0);
+            }
 
             int skillNum;
-            // (skills[skill] == true) means the nurse have that skill
-            std::vector<bool> skills;
+            SkillMask skills;
         };
         std::vector<Nurse> nurses;
     };
@@ -133,8 +148,18 @@ public:
     class WeekData
     {
     public:
-        // (shiftOffs[day][shift][nurse] == true) means shiftOff required
-        std::vector< std::vector< std::vector<bool> > > shiftOffs;
+        // isShiftOff( nurse, day, shift ) means shiftOff required
+        bool isShiftOff( NurseID nurse, int weekday, ShiftID shift ) const
+        {
+            return (((shiftOffs[nurse * Weekday::SIZE + weekday] >> shift) & 1) != 0);
+        }
+        void addShiftOff( NurseID nurse, int weekday, ShiftID shift )
+        {
+            shiftOffs[nurse * Weekday::SIZE + weekday] |= (1U << shift);
+        }
+
+        // shiftOffs[nurse * Weekday::SIZE + day] is the mask of shiftOff requests
+        std::vector<ShiftMask> shiftOffs;
         // optNurseNums[day][shift][skill] is a number of nurse
         NurseNumsOnSingleAssign optNurseNums;
         // minNurseNums[day][shift][skill] is a number of nurse
@@ -161,6 +186,16 @@ public:
     class Names
     {
     public:
+        // shiftMap contains NAME_ANY and NAME_NONE
+        Names();
+
+        // return the id of name in nameMap, or 0 if it is not in the map
+        static int getID( const std::map<std::string, int> &nameMap, const std::string &name )
+        {
+            std::map<std::string, int>::const_iterator iter = nameMap.find( name );
+            return ((iter != nameMap.end()) ? iter->second : 0);
+        }
+
         std::string scenarioName;
 
         std::vector<std::string> skillNames;    // skillMap[skillNames[skillID]] == skillID
@@ -179,8 +214,14 @@ public:
     class Assign
     {
     public:
-        // the default constructor means there is no assignment
-        Assign( ShiftID sh = Scenario::Shift::ID_NONE, SkillID sk = Scenario::Skill::ID_BEGIN ) :shift( sh ), skill( sk ) {}
+        // each assign is packed into 16 bits, so the table is compact
+        // and can be compared cell by cell with 16-bit SIMD lanes
+        typedef signed char PackedID;
+
+        // the default constructor means there is no assignment.
+        // explicit to keep an int from being taken as an Assign silently
+        explicit Assign( ShiftID sh = Scenario::Shift::ID_NONE, SkillID sk = Scenario::Skill::ID_BEGIN )
+            :shift( static_cast<PackedID>(sh) ), skill( static_cast<PackedID>(sk) ) {}
 
         static bool isWorking( ShiftID shift )
         {
@@ -192,52 +233,73 @@ public:
             return isWorking( shift );
         }
 
-        ShiftID shift;
-        SkillID skill;
+        bool operator==( const Assign &a ) const { return ((shift == a.shift) && (skill == a.skill)); }
+        bool operator!=( const Assign &a ) const { return !(*this == a); }
+
+        PackedID shift;
+        PackedID skill;
     };
     // AssignTable[nurse][day] is a SingleAssign
-    class AssignTable : public std::vector < std::vector< Assign > >
+    // all assigns are stored in a single nurse-major buffer with a fixed
+    // stride of Weekday::SIZE, so AssignTable[nurse] is a pointer to the row
+    class AssignTable
     {
     public:
-        AssignTable() {}
+        static const int STRIDE = Weekday::SIZE;
+
+        AssignTable() : nurseNum( 0 ) {}
         // weekdayNum should be (actual weekday number + 1)
-        // to let it allocate an additional day for history
+        // to let it allocate an additional day for history.
+        // each row always has STRIDE slots, so weekdayNum must be Weekday::SIZE
         AssignTable( int nurseNum, int weekdayNum = Weekday::SIZE, const Assign &singleAssign = Assign() )
-            : std::vector< std::vector< Assign > >( nurseNum, std::vector< Assign >( weekdayNum, singleAssign ) ) {}
+            : nurseNum( nurseNum ), assigns( nurseNum * STRIDE, singleAssign )
+        {
+            assert( weekdayNum == Weekday::SIZE );
+            (void)weekdayNum;   // only checked in debug build
+        }
         AssignTable( int nurseNum, int weekdayNum, const std::string &assignString )
-            : std::vector< std::vector< Assign > >( nurseNum, std::vector< Assign >( weekdayNum ) )
+            : nurseNum( nurseNum ), assigns( nurseNum * STRIDE )
         {
+            assert( weekdayNum == Weekday::SIZE );
+            (void)weekdayNum;   // only checked in debug build
+
             std::istringstream iss( assignString );
 
+            ShiftID shift;
+            SkillID skill;
             for (NurseID nurse = 0; nurse < nurseNum; ++nurse) {
                 for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
-                    iss >> at( nurse ).at( weekday ).shift
-                        >> at( nurse ).at( weekday ).skill;
+                    iss >> shift >> skill;
+                    (*this)[nurse][weekday] = Assign( shift, skill );
                 }
             }
         }
 
-        static int distance( const AssignTable &l, const AssignTable &r )
-        {
-            int dist = 0;
-            int nurseNum = l.size();
-
-            for (int n = 0; n < nurseNum; ++n) {
-                for (int w = Weekday::Mon; w <= Weekday::Sun; ++w) {
-                    dist += ((l[n][w].shift != r[n][w].shift) || (l[n][w].skill != r[n][w].skill));
-                }
-            }
+        // number of different assigns from Mon to Sun
+        static int distance( const AssignTable &l, const AssignTable &r );
 
-            return dist;
+        // compare the whole buffer including history and next week slots
+        bool operator==( const AssignTable &r ) const
+        {
+            return ((nurseNum == r.nurseNum)
+                && (memcmp( assigns.data(), r.assigns.data(), assigns.size() * sizeof( Assign ) ) == 0));
         }
+        bool operator!=( const AssignTable &r ) const { return !(*this == r); }
 
         bool isWorking( NurseID nurse, int weekday ) const
         {
-            return Assign::isWorking( at( nurse ).at( weekday ).shift );
+            return Assign::isWorking( (*this)[nurse][weekday].shift );
         }
 
-    private:
+        // number of nurses
+        int size() const { return nurseNum; }
 
+        Assign* operator[]( NurseID nurse ) { return (assigns.data() + nurse * STRIDE); }
+        const Assign* operator[]( NurseID nurse ) const { return (assigns.data() + nurse * STRIDE); }
+
+    private:
+        int nurseNum;
+        std::vector<Assign> assigns;
     };
 
     class PenaltyMode
@@ -303,7 +365,68 @@ public:
         ObjValue TotalAssign() const { return pm.totalAssign; }
         ObjValue TotalWorkingWeekend() const { return pm.totalWorkingWeekend; }
 
+        // true if no mode is set on top of the default one
+        bool isDefaultMode() const { return modeStack.empty(); }
+
+        // return a standalone penalty with the mode set on top of current one
+        // while this one is left untouched, so they can be shared by threads
+        Penalty withSwapMode() const;
+        Penalty withBlockSwapMode() const;
+        Penalty withExchangeMode() const;
+
+        // compile-time counterparts of the modes above which share the
+        // same accessors, so the weights can be folded into try kernels
+        // and terms with zero weight are eliminated by the compiler
+        class DefaultMode
+        {
+        public:
+            static ObjValue UnderStaff() { return DefaultPenalty::UnderStaff; }
+            static ObjValue SingleAssign() { return DefaultPenalty::SingleAssign; }
+            static ObjValue Succession() { return DefaultPenalty::Succession; }
+            static ObjValue MissSkill() { return DefaultPenalty::MissSkill; }
+
+            static ObjValue InsufficientStaff() { return DefaultPenalty::InsufficientStaff; }
+            static ObjValue ConsecutiveShift() { return DefaultPenalty::ConsecutiveShift; }
+            static ObjValue ConsecutiveDay() { return DefaultPenalty::ConsecutiveDay; }
+            static ObjValue ConsecutiveDayOff() { return DefaultPenalty::ConsecutiveDayOff; }
+            static ObjValue Preference() { return DefaultPenalty::Preference; }
+            static ObjValue CompleteWeekend() { return DefaultPenalty::CompleteWeekend; }
+            static ObjValue TotalAssign() { return DefaultPenalty::TotalAssign; }
+            static ObjValue TotalWorkingWeekend() { return DefaultPenalty::TotalWorkingWeekend; }
+        };
+
+        // same as setSwapMode() over default mode
+        class SwapMode : public DefaultMode
+        {
+        public:
+            static ObjValue UnderStaff() { return 0; }
+            static ObjValue InsufficientStaff() { return 0; }
+        };
+
+        // same as setBlockSwapMode() over default mode
+        class BlockSwapMode : public SwapMode
+        {
+        public:
+            static ObjValue Succession() { return 0; }
+            static ObjValue MissSkill() { return 0; }
+        };
+
+        // same as setExchangeMode() over default mode
+        class ExchangeMode : public DefaultMode
+        {
+        public:
+            static ObjValue Succession() { return 0; }
+            static ObjValue MissSkill() { return 0; }
+            static ObjValue TotalAssign() { return 0; }
+        };
+
     private:
+        explicit Penalty( const PenaltyMode &mode ) : pm( mode ) {}
+
+        static void applySwapMode( PenaltyMode &mode );
+        static void applyBlockSwapMode( PenaltyMode &mode );
+        static void applyExchangeMode( PenaltyMode &mode );
+
         PenaltyMode pm;
         std::vector<PenaltyMode> modeStack;
     };
@@ -313,6 +436,9 @@ public:
 
     class Solver;
     class TabuSolver;
+    class SharedOptima;
+    class ElitePool;
+    class Portfolio;
 
 
     // nurseNumOfSkill[skill] is the number of nurses with that skill
@@ -320,8 +446,35 @@ public:
     // NurseWithSkill[skill][skillNum-1] is a set of nurses 
     // who have that skill and have skillNum skills in total
     typedef std::vector< std::vector<std::vector<NurseID> > > NurseWithSkill;
-    // NursesHasSameSkill[nurse][nurse2] == true if both of them has certain skill
-    typedef std::vector< std::vector<bool> > NursesHasSameSkill;
+
+    // range of total assignments in the rest weeks of a nurse, which
+    // depends on history, so it is kept out of the shared scenario
+    class RestRange
+    {
+    public:
+        int restMinShiftNum;    // total assignments in the planning horizon
+        int restMaxShiftNum;    // total assignments in the planning horizon
+        int restMaxWorkingWeekendNum;   // total assignments in the planning horizon
+    };
+
+    // nurse-skill relation depends on scenario only, so it can be shared
+    // by all runs on the same scenario
+    class NurseSkillRelation
+    {
+    public:
+        NurseNumOfSkill nurseNumOfSkill;
+        NurseWithSkill nurseWithSkill;
+    };
+
+    // name tables used by the _Fast parsers to resolve names in history and
+    // weekdata, which depend on scenario only like NurseSkillRelation
+    class NameTables
+    {
+    public:
+        NameTable nurseTable;
+        NameTable shiftTable;
+        NameTable skillTable;
+    };
 
 
     // timeout for generating a feasible solution (if there is)
@@ -334,33 +487,49 @@ public:
     // must set all data members by direct accessing!
     NurseRostering();
 
+    // set restRanges by history.
     // do not count min shift number in early weeks
     // max increase with same delta each week
     void adjustRangeOfTotalAssignByWorkload();
+    // initialize assist data about nurse-skill relation
+    std::shared_ptr<const NurseSkillRelation> discoverNurseSkillRelation() const;
     // return true if two nurses have same skill
     bool haveSameSkill( NurseID nurse, NurseID nurse2 ) const
     {
-        for (SkillID sk = Scenario::Skill::ID_BEGIN; sk < scenario.skillSize; ++sk) {
-            if (scenario.nurses[nurse].skills[sk] && scenario.nurses[nurse2].skills[sk]) {
-                return true;
-            }
-        }
-
-        return false;
+        return ((scenario->nurses[nurse].skills & scenario->nurses[nurse2].skills) != 0);
     }
 
 
-    // data to identify a nurse rostering problem
-    Scenario scenario;
+    // data to identify a nurse rostering problem.
+    // scenario and names are read only after parsing, so they are
+    // shared by all inputs parsed from the same scenario file
+    std::shared_ptr<const Scenario> scenario;
     WeekData weekData;
     History history;
-
-    Names names;
+    // best roster of last week carried by custom input for warm start,
+    // there is no nurse in it if it is not available
+    AssignTable lastWeekAssign;
+    // restRanges[nurse] is set by adjustRangeOfTotalAssignByWorkload()
+    std::vector<RestRange> restRanges;
+
+    std::shared_ptr<const Names> names;
+    // shared by inputs of the same scenario, NULL to be discovered by solver
+    std::shared_ptr<const NurseSkillRelation> nurseSkillRelation;
+    // shared by inputs of the same scenario, NULL to be built by each parser
+    std::shared_ptr<const NameTables> nameTables;
 
     int randSeed;
     // the solver will exit either timeout or maxIterCount is reached
     Timer::Duration timeout;
     IterCount maxIterCount;
+    // number of threads scanning a neighborhood (including the solver thread)
+    int scanThreadNum;
+    // number of perturbed restarts searched at once on the scan threads
+    // in each generation of tabu search and swap chain search
+    int restartNum;
+
+    // declared since the forbidden operator= deprecates the implicit one
+    NurseRostering( const NurseRostering & ) = default;
 
 private:    // forbidden operators
     NurseRostering& operator=(const NurseRostering&) { return *this; }
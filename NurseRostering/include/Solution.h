@@ -102,17 +102,42 @@ public:
         Assign assign;
     };
 
-    typedef ObjValue( Solution::*TryMove )(const Move &move) const;
-    typedef bool (Solution::*FindBestMove)(Move &move) const;
-    typedef void (Solution::*ApplyMove)(const Move &move);
-    typedef void (Solution::*UpdateTabu)(const Move &move);
+    // neighborhoods to search, each entrance is a Move::Mode which
+    // will be dispatched statically by findBestMove()
+    typedef std::vector<int> ModeSeqPattern;
 
-    typedef std::vector<TryMove> TryMoveTable;
-    typedef std::vector<FindBestMove> FindBestMoveTable;
-    typedef std::vector<ApplyMove> ApplyMoveTable;
-    typedef std::vector<UpdateTabu> UpdateTabuTable;
+    typedef void (Solution::*TabuSearch)(const Timer &timer, const ModeSeqPattern &modeSeqPat, IterCount maxNoImproveCount);
 
-    typedef void (Solution::*TabuSearch)(const Timer &timer, const FindBestMoveTable &findBestMoveTable, IterCount maxNoImproveCount);
+    // scratch of neighborhood evaluation and the random generator for
+    // selection, which are owned by the thread scanning the neighborhood.
+    // the solution itself is only read during a scan
+    class EvalContext
+    {
+    public:
+        EvalContext( NurseID nurseNum = 0 ) { reset( nurseNum ); }
+
+        void reset( NurseID nurseNum )
+        {
+            findBestARLoop_flag = true;
+            findBestARLoopOnBlockBorder_flag = true;
+            findBestBlockSwap_startNurse = nurseNum;
+            isPossibilitySelect = false;
+            isBlockSwapSelected = false;
+        }
+
+        std::mt19937 randGen;
+
+        // for switching between add and remove
+        // 1 for no improvement which is opposite in localSearch
+        bool findBestARLoop_flag;
+        bool findBestARLoopOnBlockBorder_flag;
+        // for controlling start point of the search of best block swap
+        NurseID findBestBlockSwap_startNurse;
+        // TODO : remove following two variables if TSP is not used
+        // for controlling swap and block swap will not be selected both in possibility select
+        bool isPossibilitySelect;
+        bool isBlockSwapSelected;
+    };
 
 
     enum ModeSeq
@@ -126,17 +151,12 @@ public:
     };
 
     static const std::vector<std::string> modeSeqNames;
-    static const std::vector<std::vector<int> > modeSeqPatterns;
-
-    // entrance in this table should have the same sequence
-    // as move mode enum defined in Move::Mode
-    static const TryMoveTable tryMove;
-    static const FindBestMoveTable findBestMove;
-    static const FindBestMoveTable findBestMoveOnBlockBorder;
-    static const ApplyMoveTable applyMove;
-    static const UpdateTabuTable updateTabu;
+    static const std::vector<ModeSeqPattern> modeSeqPatterns;
 
     static const double NO_DIFF;    // for building same assign in rebuild()
+    // invalidated block swap pairs are refreshed in this number of chunks, which
+    // is also the max number of workers that can refresh them concurrently
+    static const int BLOCK_SWAP_REFRESH_CHUNK_NUM = 16;
 
     const TabuSolver &solver;
     const NurseRostering &problem;
@@ -147,6 +167,14 @@ public:
 
     // get local optima in the search trajectory
     const Output& getOptima() const { return optima; }
+    // seed the random generator used by the search on this solution
+    void setRandSeed( unsigned seed )
+    {
+        evalContext.randGen.seed( seed );
+        blockSwapRefreshContexts.clear();   // reseeded on next refresh
+    }
+    // share threads for scanning neighborhoods, NULL for scanning in current thread only
+    void setScanPool( ThreadPool *pool ) { scanPool = pool; }
 
     // set assign to output.assignTable and rebuild assist data, at must be build from same problem
     void rebuild( const Output &output, double diff );  // objValue will be recalculated
@@ -171,6 +199,8 @@ public:
     bool genInitAssign( int greedyRetryCount );
     bool genInitAssign_Greedy();
     bool genInitAssign_BranchAndCut();
+    // start from the roster of last week and repair it for this week
+    bool genInitAssign_WarmStart( const AssignTable &lastWeekAssign );
     bool repair( const Timer &timer );  // make infeasible solution feasible
 
     // set weights of nurses with less penalty to 0
@@ -195,12 +225,12 @@ public:
     // the random select process is a discrete distribution
     // the possibility to be selected will increase if the neighborhood
     // improve the solution, else decrease it. the sum of possibilities is 1.0
-    void tabuSearch_Rand( const Timer &timer, const FindBestMoveTable &findBestMoveTable, IterCount maxNoImproveCount );
+    void tabuSearch_Rand( const Timer &timer, const ModeSeqPattern &modeSeqPat, IterCount maxNoImproveCount );
     // loop to select neighborhood to search until timeout or there is no
     // improvement on (NeighborhoodNum + 2) neighborhood consecutively.
     // switch neighborhood when maxNoImproveForSingleNeighborhood has
     // been reach, then restart from optima in current trajectory.
-    void tabuSearch_Loop( const Timer &timer, const FindBestMoveTable &findBestMoveTable, IterCount maxNoImproveCount );
+    void tabuSearch_Loop( const Timer &timer, const ModeSeqPattern &modeSeqPat, IterCount maxNoImproveCount );
     // randomly select neighborhood to search until timeout or
     // no improve move count reaches maxNoImproveForAllNeighborhood.
     // for each neighborhood i, the possibility to select is P[i].
@@ -215,16 +245,24 @@ public:
     // if no neighborhood has been selected, prepare a loop queue.
     // select the one by one in the queue until a valid move is found.
     // move the head to the tail of the queue if it makes no improvement.
-    void tabuSearch_Possibility( const Timer &timer, const FindBestMoveTable &findBestMoveTable, IterCount maxNoImproveCount );
+    void tabuSearch_Possibility( const Timer &timer, const ModeSeqPattern &modeSeqPat, IterCount maxNoImproveCount );
     // try add shift until there is no improvement , then try change shift,
     // then try remove shift, then try add shift again. if all of them
     // can't improve or time is out, return.
-    void localSearch( const Timer &timer, const FindBestMoveTable &findBestMoveTable );
+    // search on block border only if onBlockBorder is true.
+    void localSearch( const Timer &timer, const ModeSeqPattern &modeSeqPat, bool onBlockBorder = false );
     // randomly select add, change or remove shift until timeout
     void randomWalk( const Timer &timer, IterCount stepNum );
 
     // change solution structure in certain complexity
     void perturb( double strength );
+    // walk towards target by the cheapest add, change or remove on a day which
+    // differs from target until one day is left or the rest are all forbidden.
+    // return false if no solution is passed by, else record the best in bestOnPath
+    bool pathRelinking( const Timer &timer, const AssignTable &target, Output &bestOnPath );
+    // inherit each nurse row (or day column) from either parent by turns of a
+    // coin, then repair the child. return true if the child is feasible
+    bool crossover( const Timer &timer, const AssignTable &parent, const AssignTable &parent2, bool isRowWise );
 
     // check if the result of incremental update, evaluate and checkObjValue is the same
     bool checkIncrementalUpdate();
@@ -265,9 +303,10 @@ private:
         // always get an available nurse and update validation information
         NurseID getNurse();
 
-        AvailableNurses( const Solution &s );
+        AvailableNurses( const Solution &s, std::mt19937 &rgen );
     private:
         const Solution &sln;
+        std::mt19937 &randGen;
         NurseWithSkill nurseWithSkill;
 
         int weekday;
@@ -353,12 +392,85 @@ private:
         int shiftHigh[SIZE];
     };
 
+    // flat table of the last iteration each item keeps tabu
+    // in compact mode, stamps are relative to epoch and all of them
+    // will be shifted towards 0 before the end of a new tabu overflows
+    class TabuTable
+    {
+    public:
+#ifdef INRC2_COMPACT_TABU_STAMP
+        typedef unsigned short Stamp;
+#else
+        typedef IterCount Stamp;
+#endif
+        static const IterCount MAX_STAMP = static_cast<Stamp>(-1) & 0x7fffffff;
+
+        TabuTable( int size = 0 ) : epoch( 0 ), stamps( size, 0 ) {}
+
+        bool empty() const { return stamps.empty(); }
+        // (iterCount <= tabu end) means forbid to be changed
+        bool noTabu( int index, IterCount iterCount ) const
+        {
+            return ((iterCount - epoch) > stamps[index]);
+        }
+        void update( int index, IterCount iterCount, IterCount tenure )
+        {
+#ifdef INRC2_COMPACT_TABU_STAMP
+            if ((iterCount + tenure - epoch) > MAX_STAMP) { rebase( iterCount ); }
+#endif
+            stamps[index] = static_cast<Stamp>(iterCount + tenure - epoch);
+        }
+
+    private:
+        // make (iterCount - 1) the new epoch so that expired items
+        // are clamped to 0 and still no tabu in current iteration
+        void rebase( IterCount iterCount )
+        {
+            IterCount offset = iterCount - 1 - epoch;
+            for (auto s = stamps.begin(); s != stamps.end(); ++s) {
+                *s = (*s > offset) ? static_cast<Stamp>(*s - offset) : 0;
+            }
+            epoch += offset;
+        }
+
+        IterCount epoch;
+        std::vector<Stamp> stamps;
+    };
     // fine-grained tabu list for add or remove on each shift
     // (iterCount <= ShiftTabu[nurse][weekday][shift][skill]) means forbid to be added
-    typedef std::vector< std::vector< std::vector< std::vector<IterCount> > > > ShiftTabu;
+    class ShiftTabu : public TabuTable
+    {
+    public:
+        ShiftTabu() {}
+        ShiftTabu( int nurseNum, int shiftSize, int skillSize )
+            : TabuTable( nurseNum * Weekday::NUM * shiftSize * skillSize ),
+            weekdayStride( shiftSize * skillSize ), nurseStride( Weekday::NUM * weekdayStride ),
+            shiftStride( skillSize ) {}
+
+        int index( NurseID nurse, int weekday, const Assign &a ) const
+        {
+            return (nurse * nurseStride + (weekday - Weekday::Mon) * weekdayStride
+                + a.shift * shiftStride + a.skill);
+        }
+
+    private:
+        int weekdayStride;
+        int nurseStride;
+        int shiftStride;
+    };
     // coarse-grained tabu list for add or remove on each day
     // (iterCount <= DayTabu[nurse][weekday]) means forbid to be removed
-    typedef std::vector< std::vector<IterCount> > DayTabu;
+    class DayTabu : public TabuTable
+    {
+    public:
+        DayTabu() {}
+        DayTabu( int nurseNum ) : TabuTable( nurseNum * Weekday::NUM ) {}
+
+        int index( NurseID nurse, int weekday ) const
+        {
+            return (nurse * Weekday::NUM + (weekday - Weekday::Mon));
+        }
+    };
 
     // information for update delta and assignment
     struct BlockSwapCacheItem
@@ -372,6 +484,147 @@ private:
     // delta of best block swap with nurse and nurse2
     typedef std::vector< std::vector< BlockSwapCacheItem > > BlockSwapCache;
 
+    // consecutive blocks of a nurse for evaluating block swap in a single sweep.
+    // blocks are split by shift (ShiftBlock) or by working or not (DayBlock)
+    struct BlockSwapRow
+    {
+    public:
+        enum BlockKind { ShiftBlock, DayBlock, BlockKindNum };
+
+        // closed blocks and the open block [low, current day]
+        struct BlockState
+        {
+        public:
+            ObjValue closedObj;
+            int low;
+            int key;
+        };
+
+        // objective on the nurse except preference
+        ObjValue obj;
+        // shift or whether working on each day
+        int key[BlockKindNum][Weekday::SIZE];
+        // the block starting from day w ends at high[w]
+        int high[BlockKindNum][Weekday::SIZE];
+        // objective of blocks in [w, Sun] if a block starts from day w
+        ObjValue suffixObj[BlockKindNum][Weekday::SIZE];
+        // blocks in [Mon, w - 1]
+        BlockState prefix[BlockKindNum][Weekday::SIZE];
+    };
+
+    // delta of a swap and its parts on each nurse
+    struct SwapDelta
+    {
+    public:
+        SwapDelta( ObjValue swapDelta = DefaultPenalty::FORBIDDEN_MOVE,
+            ObjValue swapNurseDelta = 0, ObjValue swapNurse2Delta = 0 )
+            : delta( swapDelta ), nurseDelta( swapNurseDelta ), nurse2Delta( swapNurse2Delta ) {}
+
+        ObjValue delta;
+        ObjValue nurseDelta;
+        ObjValue nurse2Delta;
+    };
+
+    // select the block swap with minimal delta among the ones enumerated by
+    // sweepBlockSwap(), a tabu one is selected if it meets aspiration criteria
+    class BlockSwapSelector
+    {
+    public:
+        BlockSwapSelector( const Solution &solution, std::mt19937 &rgen )
+            : sln( solution ), randGen( rgen ), weekday( Weekday::Mon ), weekday2( Weekday::Mon )
+#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
+            , weekday_tabu( Weekday::Mon ), weekday2_tabu( Weekday::Mon )
+#endif
+        {
+        }
+
+        void operator()( int w, int w2, const SwapDelta &swapDelta, bool isNoTabu );
+
+        // return the selected block swap and record the block into w and w2
+        SwapDelta getBest( int &w, int &w2 ) const;
+
+    private:
+        const Solution &sln;
+        std::mt19937 &randGen;
+
+        RandSelect<ObjValue> rs;
+        SwapDelta best;
+        int weekday;
+        int weekday2;
+#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
+        RandSelect<ObjValue> rs_tabu;
+        SwapDelta best_tabu;
+        int weekday_tabu;
+        int weekday2_tabu;
+#endif
+    };
+
+    // delta of swap with nurse and nurse2 on each day
+    struct SwapCacheItem
+    {
+    public:
+        ObjValue delta[Weekday::SIZE];
+    };
+    // SwapCache[nurse][nurse2] stores
+    // delta of swap with nurse and nurse2 on each day
+    typedef std::vector< std::vector< SwapCacheItem > > SwapCache;
+
+    // delta of add (on day off) or change (on working day) for each
+    // (nurse, weekday, shift, skill) and delta of remove for each (nurse, weekday).
+    // the terms depending on staffing (UnderStaff and InsufficientStaff) are
+    // left out since they are changed by other nurses and evaluated on the fly
+    class AssignDeltaCache
+    {
+    public:
+        AssignDeltaCache( int nurseNum = 0, int shiftSize = 0, int skillSize = 0 )
+            : isAddValid( nurseNum, false ), isChangeValid( nurseNum, false ),
+            isRemoveValid( nurseNum, false ),
+            assignDeltas( nurseNum * Weekday::NUM * shiftSize * skillSize ),
+            removeDeltas( nurseNum * Weekday::NUM ),
+            weekdayStride( shiftSize * skillSize ),
+            nurseStride( Weekday::NUM * shiftSize * skillSize ),
+            shiftStride( skillSize ) {}
+
+        bool empty() const { return removeDeltas.empty(); }
+
+        ObjValue& assignDelta( NurseID nurse, int weekday, const Assign &a )
+        {
+            return assignDeltas[nurse * nurseStride + (weekday - Weekday::Mon) * weekdayStride
+                + a.shift * shiftStride + a.skill];
+        }
+        ObjValue& removeDelta( NurseID nurse, int weekday )
+        {
+            return removeDeltas[nurse * Weekday::NUM + (weekday - Weekday::Mon)];
+        }
+
+        void invalidate( NurseID nurse )
+        {
+            isAddValid[nurse] = false;
+            isChangeValid[nurse] = false;
+            isRemoveValid[nurse] = false;
+        }
+        void invalidateAll()
+        {
+            std::fill( isAddValid.begin(), isAddValid.end(), false );
+            std::fill( isChangeValid.begin(), isChangeValid.end(), false );
+            std::fill( isRemoveValid.begin(), isRemoveValid.end(), false );
+        }
+
+        // (isXXXValid[nurse] == false) means the XXX deltas
+        // related to nurse can not be reused
+        std::vector<bool> isAddValid;
+        std::vector<bool> isChangeValid;
+        std::vector<bool> isRemoveValid;
+
+    private:
+        std::vector<ObjValue> assignDeltas;
+        std::vector<ObjValue> removeDeltas;
+
+        int weekdayStride;
+        int nurseStride;
+        int shiftStride;
+    };
+
 
     // find day number to be punished for a single block
     // work for shift, day and day-off
@@ -392,20 +645,24 @@ private:
 
     bool isValidSuccession( NurseID nurse, ShiftID shift, int weekday ) const
     {
-        return problem.scenario.shifts[assign[nurse][weekday - 1].shift].legalNextShifts[shift];
+        return problem.scenario->shifts[assign[nurse][weekday - 1].shift].isLegalNextShift( shift );
     }
     bool isValidPrior( NurseID nurse, ShiftID shift, int weekday ) const
     {
-        return problem.scenario.shifts[shift].legalNextShifts[assign[nurse][weekday + 1].shift];
+        return problem.scenario->shifts[shift].isLegalNextShift( assign[nurse][weekday + 1].shift );
     }
 
     // reset all cache valid flag of corresponding nurses to false
     void invalidateCacheFlag( const Move &move )
     {
         isBlockSwapCacheValid[move.nurse] = false;
+        isSwapCacheValid[move.nurse] = false;
+        assignDeltaCache.invalidate( move.nurse );
         if ((move.mode == Move::Mode::BlockSwap)
             || (move.mode == Move::Mode::Swap)) {
             isBlockSwapCacheValid[move.nurse2] = false;
+            isSwapCacheValid[move.nurse2] = false;
+            assignDeltaCache.invalidate( move.nurse2 );
         }
     }
 
@@ -413,7 +670,7 @@ private:
     // update objective value and update cache valid flags
     void applyBasicMove( const Move &move )
     {
-        (this->*applyMove[move.mode])(move);
+        applyMove( move );
         objValue += move.delta;
         invalidateCacheFlag( move );
 
@@ -429,10 +686,10 @@ private:
 #ifdef INRC2_SECONDARY_OBJ_VALUE
         if (objValue <= optima.getObjValue()) {
             secondaryObjValue = 0;
-            for (NurseID n = 0; n < problem.scenario.nurseNum; ++n) {
-                const NurseRostering::Scenario::Nurse &nurse( problem.scenario.nurses[n] );
+            for (NurseID n = 0; n < problem.scenario->nurseNum; ++n) {
+                const NurseRostering::Scenario::Nurse &nurse( problem.scenario->nurses[n] );
                 secondaryObjValue += (static_cast<double>(totalAssignNums[n]) / (1 + abs(
-                    nurse.restMaxShiftNum + problem.scenario.contracts[nurse.contract].maxShiftNum )));
+                    problem.restRanges[n].restMaxShiftNum + problem.scenario->contracts[nurse.contract].maxShiftNum )));
             }
         }
 #endif
@@ -444,7 +701,7 @@ private:
 #ifdef INRC2_SECONDARY_OBJ_VALUE
             bool isSelected = (secondaryObjValue < optima.getSecondaryObjValue());
 #else
-            bool isSelected = ((solver.randGen() % 2) == 0);
+            bool isSelected = ((evalContext.randGen() % 2) == 0);
 #endif
             if (isSelected) {
                 findTime = Timer::Clock::now();
@@ -456,55 +713,131 @@ private:
         return false;
     }
 
+    // dispatch on move.mode or mode (one of Move::Mode) with a switch
+    // instead of member function pointer, so that the neighborhood
+    // search can be inlined into the search loops
+    ObjValue tryMove( EvalContext &ctx, const Move &move ) const;
+    bool findBestMove( EvalContext &ctx, int mode, Move &bestMove ) const;
+    bool findBestMoveOnBlockBorder( EvalContext &ctx, int mode, Move &bestMove ) const;
+    void applyMove( const Move &move );
+#ifdef INRC2_USE_TABU
+    void updateTabu( const Move &move );
+#endif
+
     // return true if the solution will be improved (delta < 0)
     // BlockBorder means the start or end day of a consecutive block
-    bool findBestAdd( Move &bestMove ) const;
-    bool findBestChange( Move &bestMove ) const;
-    bool findBestRemove( Move &bestMove ) const;
-    bool findBestSwap( Move &bestMove ) const;
-    bool findBestBlockSwap( Move &bestMove ) const;         // try all nurses
-    bool findBestBlockSwap_cached( Move &bestMove ) const;         // try all nurses
-    bool findBestBlockSwap_fast( Move &bestMove ) const;    // try all nurses
-    bool findBestBlockSwap_part( Move &bestMove ) const;    // try some nurses following index
-    bool findBestBlockSwap_rand( Move &bestMove ) const;    // try randomly picked nurses 
-    bool findBestExchange( Move &bestMove ) const;
-    bool findBestBlockShift( Move &bestMove ) const;
-    bool findBestARLoop( Move &bestMove ) const;
-    bool findBestARRand( Move &bestMove ) const;
-    bool findBestARBoth( Move &bestMove ) const;
-    bool findBestAddOnBlockBorder( Move &bestMove ) const;
-    bool findBestChangeOnBlockBorder( Move &bestMove ) const;
-    bool findBestRemoveOnBlockBorder( Move &bestMove ) const;
-    bool findBestSwapOnBlockBorder( Move &bestMove ) const;
-    bool findBestExchangeOnBlockBorder( Move &bestMove ) const;
-    bool findBestARLoopOnBlockBorder( Move &bestMove ) const;
-    bool findBestARRandOnBlockBorder( Move &bestMove ) const;
-    bool findBestARBothOnBlockBorder( Move &bestMove ) const;
+    bool findBestAdd( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestChange( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestRemove( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestSwap( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestBlockSwap( EvalContext &ctx, Move &bestMove ) const;         // try all nurses
+    bool findBestBlockSwap_cached( EvalContext &ctx, Move &bestMove ) const;         // try all nurses
+    bool findBestBlockSwap_indexed( EvalContext &ctx, Move &bestMove ) const; // try pairs with invalidated nurses on scanPool
+    // re-evaluate best block swap between nurse and nurse2 (nurse < nurse2) over all weekdays
+    void updateBlockSwapCache( EvalContext &ctx, NurseID nurse, NurseID nurse2 ) const;
+    bool findBestBlockSwap_fast( EvalContext &ctx, Move &bestMove ) const;    // try all nurses
+    bool findBestBlockSwap_part( EvalContext &ctx, Move &bestMove ) const;    // try some nurses following index
+    bool findBestBlockSwap_rand( EvalContext &ctx, Move &bestMove ) const;    // try randomly picked nurses 
+    bool findBestExchange( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestBlockShift( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestARLoop( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestARRand( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestARBoth( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestAddOnBlockBorder( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestChangeOnBlockBorder( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestRemoveOnBlockBorder( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestSwapOnBlockBorder( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestExchangeOnBlockBorder( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestARLoopOnBlockBorder( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestARRandOnBlockBorder( EvalContext &ctx, Move &bestMove ) const;
+    bool findBestARBothOnBlockBorder( EvalContext &ctx, Move &bestMove ) const;
+
+    // try kernels are instantiated with a compile-time penalty policy
+    // (Penalty::DefaultMode, SwapMode, BlockSwapMode, ExchangeMode) in hot
+    // loops, or with a snapshot of the runtime penalty when other mode is set.
+    // overloads without policy select the policy according to penalty mode.
+    // all of them are read-only on the solution so that they can be called
+    // on a shared solution concurrently
+
+    // evaluate add, change and remove in default penalty mode with the part
+    // only related to the nurse reused from assignDeltaCache if it is valid
+    bool isAssignDeltaCacheEnabled() const;
+    ObjValue tryAddAssign_cached( const Move &move ) const;
+    ObjValue tryChangeAssign_cached( const Move &move ) const;
+    ObjValue tryRemoveAssign_cached( const Move &move ) const;
 
     // evaluate cost of adding a Assign to nurse without Assign in weekday
+    template <typename PenaltyPolicy>
+    ObjValue tryAddAssign( const PenaltyPolicy &pm, int weekday, NurseID nurse, const Assign &a ) const;
     ObjValue tryAddAssign( int weekday, NurseID nurse, const Assign &a ) const;
     ObjValue tryAddAssign( const Move &move ) const;
     // evaluate cost of assigning another Assign or skill to nurse already assigned in weekday
+    template <typename PenaltyPolicy>
+    ObjValue tryChangeAssign( const PenaltyPolicy &pm, int weekday, NurseID nurse, const Assign &a ) const;
     ObjValue tryChangeAssign( int weekday, NurseID nurse, const Assign &a ) const;
     ObjValue tryChangeAssign( const Move &move ) const;
     // evaluate cost of removing the Assign from nurse already assigned in weekday
+    template <typename PenaltyPolicy>
+    ObjValue tryRemoveAssign( const PenaltyPolicy &pm, int weekday, NurseID nurse ) const;
     ObjValue tryRemoveAssign( int weekday, NurseID nurse ) const;
     ObjValue tryRemoveAssign( const Move &move ) const;
     // evaluate cost of swapping Assign of two nurses in the same day
-    ObjValue trySwapNurse( int weekday, NurseID nurse, NurseID nurse2 ) const;
+    template <typename PenaltyPolicy>
+    SwapDelta trySwapNurse( const PenaltyPolicy &pm, int weekday, NurseID nurse, NurseID nurse2 ) const;
     ObjValue trySwapNurse( const Move &move ) const;
     // evaluate cost of swapping Assign of two nurses in consecutive days start from weekday
     // and record the selected end of the block into weekday2
     // the recorded move will always be no tabu move or meet aspiration criteria
-    ObjValue trySwapBlock( int weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const;
-    ObjValue trySwapBlock( const Move &move ) const;
+    template <typename PenaltyPolicy>
+    SwapDelta trySwapBlock( EvalContext &ctx, const PenaltyPolicy &pm, int weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const;
+    // same as above with rows built by buildBlockSwapRow() under the same policy
+    template <typename PenaltyPolicy>
+    SwapDelta trySwapBlock( EvalContext &ctx, const PenaltyPolicy &pm, const BlockSwapRow &row, const BlockSwapRow &row2,
+        int weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const;
+    ObjValue trySwapBlock( EvalContext &ctx, const Move &move ) const;
     // evaluate cost of swapping Assign of two nurses in consecutive days in a week
     // and record the block information into weekday and weekday2
     // the recorded move will always be no tabu move or meet aspiration criteria
-    ObjValue trySwapBlock_fast( int &weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const;
-    ObjValue trySwapBlock_fast( const Move &move ) const;
+    template <typename PenaltyPolicy>
+    SwapDelta trySwapBlock_fast( EvalContext &ctx, const PenaltyPolicy &pm, int &weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const;
+    ObjValue trySwapBlock_fast( EvalContext &ctx, const Move &move ) const;
+    // same as trySwapBlock_fast() in block swap mode with rows looked up
+    // in blockSwapRows which must be updated
+    ObjValue trySwapBlock_sweep( EvalContext &ctx, int &weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const;
+    // evaluate swapping Assign of nurse and nurse2 in all consecutive days starting in
+    // [firstDay, lastDay] in a single forward sweep without applying any swap, and pass
+    // each valid block to select( weekday, weekday2, swapDelta, isNoTabu ).
+    // blocks on the left are accumulated during the sweep and the ones on the right
+    // are looked up in the rows built by buildBlockSwapRow() under the same policy
+    template <typename PenaltyPolicy, typename BlockSelector>
+    void sweepBlockSwap( const PenaltyPolicy &pm, const BlockSwapRow &row, const BlockSwapRow &row2,
+        NurseID nurse, NurseID nurse2, int firstDay, int lastDay, BlockSelector &select ) const;
+    // build the blocks of nurse from current assignments
+    template <typename PenaltyPolicy>
+    void buildBlockSwapRow( const PenaltyPolicy &pm, NurseID nurse, BlockSwapRow &row ) const;
+    template <typename PenaltyPolicy>
+    void buildBlockSwapRows( const PenaltyPolicy &pm, std::vector<BlockSwapRow> &rows ) const;
+    // rebuild blockSwapRows[nurse] from current assignments
+    void updateBlockSwapRow( NurseID nurse ) const;
+    // append a day with key to the right of the blocks of nurse in state
+    template <typename PenaltyPolicy>
+    void appendBlockDay( const PenaltyPolicy &pm, NurseID nurse, int kind, int weekday, int key, BlockSwapRow::BlockState &state ) const;
+    // evaluate consecutive shift (isShiftBlock) or consecutive day and day-off constraints
+    // of nurse on a single block in [low, high] with key (shift or whether working)
+    template <typename PenaltyPolicy>
+    ObjValue evaluateConsecutiveBlock( const PenaltyPolicy &pm, NurseID nurse, bool isShiftBlock, int low, int high, int key ) const;
+    // evaluate complete weekend and total working weekend constraints of nurse
+    template <typename PenaltyPolicy>
+    ObjValue evaluateWeekend( const PenaltyPolicy &pm, NurseID nurse, bool isSatWorking, bool isSunWorking ) const;
+    // evaluate total assign constraint of nurse with assignNum shifts in this week
+    template <typename PenaltyPolicy>
+    ObjValue evaluateTotalAssign( const PenaltyPolicy &pm, NurseID nurse, int assignNum ) const;
+    // evaluate all constraints only related to nurse if its Assign in this week is a[]
+    template <typename PenaltyPolicy>
+    ObjValue evaluateNurseRow( const PenaltyPolicy &pm, NurseID nurse, const Assign a[] ) const;
     // evaluate cost of exchanging Assign of a nurse on two days
-    ObjValue tryExchangeDay( int weekday, NurseID nurse, int weekday2 ) const;
+    template <typename PenaltyPolicy>
+    ObjValue tryExchangeDay( const PenaltyPolicy &pm, int weekday, NurseID nurse, int weekday2 ) const;
     ObjValue tryExchangeDay( const Move &move ) const;
 
     // apply assigning a Assign to nurse without Assign in weekday
@@ -539,15 +872,15 @@ private:
 #ifdef INRC2_USE_TABU
     bool noAddTabu( const Move &move ) const
     {
-        return (iterCount > shiftTabu[move.nurse][move.weekday][move.assign.shift][move.assign.skill]);
+        return shiftTabu.noTabu( shiftTabu.index( move.nurse, move.weekday, move.assign ), iterCount );
     }
     bool noChangeTabu( const Move &move ) const
     {
-        return (iterCount > shiftTabu[move.nurse][move.weekday][move.assign.shift][move.assign.skill]);
+        return shiftTabu.noTabu( shiftTabu.index( move.nurse, move.weekday, move.assign ), iterCount );
     }
     bool noRemoveTabu( const Move &move ) const
     {
-        return (iterCount > dayTabu[move.nurse][move.weekday]);
+        return dayTabu.noTabu( dayTabu.index( move.nurse, move.weekday ), iterCount );
     }
     bool noSwapTabu( int weekday, NurseID nurse, NurseID nurse2 ) const
     {
@@ -556,16 +889,16 @@ private:
 
         if (a.isWorking()) {
             if (a2.isWorking()) {
-                return ((iterCount > shiftTabu[nurse][weekday][a2.shift][a2.skill])
-                    || (iterCount > shiftTabu[nurse2][weekday][a.shift][a.skill]));
+                return (shiftTabu.noTabu( shiftTabu.index( nurse, weekday, a2 ), iterCount )
+                    || shiftTabu.noTabu( shiftTabu.index( nurse2, weekday, a ), iterCount ));
             } else {
-                return ((iterCount > dayTabu[nurse][weekday])
-                    || (iterCount > shiftTabu[nurse2][weekday][a.shift][a.skill]));
+                return (dayTabu.noTabu( dayTabu.index( nurse, weekday ), iterCount )
+                    || shiftTabu.noTabu( shiftTabu.index( nurse2, weekday, a ), iterCount ));
             }
         } else {
             if (a2.isWorking()) {
-                return ((iterCount > shiftTabu[nurse][weekday][a2.shift][a2.skill])
-                    || (iterCount > dayTabu[nurse2][weekday]));
+                return (shiftTabu.noTabu( shiftTabu.index( nurse, weekday, a2 ), iterCount )
+                    || dayTabu.noTabu( dayTabu.index( nurse2, weekday ), iterCount ));
             } else {    // no change
                 return true;
             }
@@ -582,16 +915,16 @@ private:
 
         if (a.isWorking()) {
             if (a2.isWorking()) {
-                return ((iterCount > shiftTabu[move.nurse][move.weekday][a2.shift][a2.skill])
-                    || (iterCount > shiftTabu[move.nurse][move.weekday2][a.shift][a.skill]));
+                return (shiftTabu.noTabu( shiftTabu.index( move.nurse, move.weekday, a2 ), iterCount )
+                    || shiftTabu.noTabu( shiftTabu.index( move.nurse, move.weekday2, a ), iterCount ));
             } else {
-                return ((iterCount > dayTabu[move.nurse][move.weekday])
-                    || (iterCount > shiftTabu[move.nurse][move.weekday2][a.shift][a.skill]));
+                return (dayTabu.noTabu( dayTabu.index( move.nurse, move.weekday ), iterCount )
+                    || shiftTabu.noTabu( shiftTabu.index( move.nurse, move.weekday2, a ), iterCount ));
             }
         } else {
             if (a2.isWorking()) {
-                return ((iterCount > shiftTabu[move.nurse][move.weekday][a2.shift][a2.skill])
-                    || (iterCount > dayTabu[move.nurse][move.weekday2]));
+                return (shiftTabu.noTabu( shiftTabu.index( move.nurse, move.weekday, a2 ), iterCount )
+                    || dayTabu.noTabu( dayTabu.index( move.nurse, move.weekday2 ), iterCount ));
             } else {    // no change
                 return true;
             }
@@ -687,23 +1020,14 @@ private:
 
 
     // control penalty calculation on each constraint
-    mutable Penalty penalty;    // trySwapNurse() will modify it
+    Penalty penalty;
     // control penalty calculation on each nurse
     std::vector<ObjValue> nurseWeights;
 
-    // for switching between add and remove
-    // 1 for no improvement which is opposite in localSearch
-    mutable bool findBestARLoop_flag;    // findBestARLoop() will modify it
-    mutable bool findBestARLoopOnBlockBorder_flag;   // findBestARLoopOnBlockBorder() will modify it
-    // for controlling start point of the search of best block swap
-    mutable NurseID findBestBlockSwap_startNurse;    // findBestBlockSwap() will modify it
-    // TODO : remove following two variables if TSP is not used
-    // for controlling swap and block swap will not be selected both in possibility select
-    bool isPossibilitySelect;
-    mutable bool isBlockSwapSelected;    // tabuSearch_Possibility() and findBestBlockSwap() wil modify it
-    // trySwapNurse() and trySwapBlock() will guarantee they are always corresponding to the selected swap
-    mutable ObjValue nurseDelta;    // trySwapNurse() and trySwapBlock() will modify it
-    mutable ObjValue nurse2Delta;   // trySwapNurse() and trySwapBlock() will modify it
+    // context of the thread running the search on this solution
+    EvalContext evalContext;
+    // threads joining in the scan of some neighborhoods
+    ThreadPool *scanPool;
 
 #ifdef INRC2_USE_TABU
     ShiftTabu shiftTabu;
@@ -723,6 +1047,23 @@ private:
     // (blockSwapDeltaCacheValidFlag[nurse] == false) means 
     // the delta related to nurse can not be reused
     mutable std::vector<bool> isBlockSwapCacheValid;
+    // blockSwapRows[nurse] is up to date if isBlockSwapCacheValid[nurse]
+    mutable std::vector<BlockSwapRow> blockSwapRows;
+    // blockSwapIndex[nurse * nurseNum + nurse2] competes with blockSwapCache[nurse][nurse2]
+    // for pairs (nurse < nurse2) which are considered in block swap
+    mutable TournamentTree<ObjValue> blockSwapIndex;
+    // pairs re-evaluated in findBestBlockSwap_indexed(), kept to avoid reallocation
+    mutable std::vector<int> blockSwapRefreshPairs;
+    // blockSwapRefreshContexts[k] refreshes the k-th chunk of blockSwapRefreshPairs.
+    // they are seeded once on the first refresh and kept across iterations
+    mutable std::vector<EvalContext> blockSwapRefreshContexts;
+    // rebuild() and weight adjustment will invalidate all items
+    mutable SwapCache swapCache;
+    // (isSwapCacheValid[nurse] == false) means
+    // the swap delta related to nurse can not be reused
+    mutable std::vector<bool> isSwapCacheValid;
+    // rebuild(), weight adjustment and applyBasicMove() will invalidate items
+    mutable AssignDeltaCache assignDeltaCache;
 
     ObjValue objInsufficientStaff;
     ObjValue objConsecutiveShift;
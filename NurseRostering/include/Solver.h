@@ -33,6 +33,7 @@
 #include <vector>
 #include <string>
 #include <thread>
+#include <atomic>
 #include <chrono>
 #include <random>
 #include <cstdio>
@@ -57,17 +58,19 @@ public:
     static const double INIT_PERTURB_STRENGTH;
     static const double PERTURB_STRENGTH_DELTA;
     static const double MAX_PERTURB_STRENGTH;
+    // inverse possibility of taking the shared optima when it is better
+    static const int SHARED_OPTIMA_SELECT = 2;
 
     enum InitAlgorithm
     {
-        Greedy, Exact
+        Greedy, Exact, WarmStart
     };
 
     enum SolveAlgorithm
     {
         RandomWalk, IterativeLocalSearch,
         TabuSearch_Possibility, TabuSearch_Loop, TabuSearch_Rand,
-        BiasTabuSearch, SwapChainSearch
+        BiasTabuSearch, SwapChainSearch, PathRelinking, Memetic
     };
 
     enum TabuTenureCoefficientIndex
@@ -124,6 +127,20 @@ public:
     virtual History genHistory() const = 0;
     // return const reference of the optima
     const Output& getOptima() const { return optima; }
+    // replace problem.randSeed, must be called before init()
+    void setRandSeed( int seed ) { randSeed = seed; }
+    // solvers running in parallel exchange their optima through sharedOptima
+    // in updateOptima(), NULL for running alone. must be called before solve()
+    void setSharedOptima( SharedOptima *shared ) { sharedOptima = shared; }
+    // solver runs as the arm-th arm of the portfolio which may suspend it
+    // in updateOptima(), NULL for running alone. must be called before solve()
+    void setPortfolio( Portfolio *pf, int armIndex ) { portfolio = pf; arm = armIndex; }
+    // block while the arm is suspended by the portfolio. it is called in the
+    // search loops of Solution and only checks every certain number of iterations
+    void yieldToPortfolio( IterCount iterCount ) const;
+    // iteration and generation count of the last solve()
+    IterCount getIterationCount() const { return iterationCount; }
+    IterCount getGenerationCount() const { return generationCount; }
     // print simple information of the solution to console
     void print() const;
     // record solution to specified file and create custom file if required
@@ -141,11 +158,11 @@ public:
     ObjValue checkObjValue( const AssignTable &assign ) const;
     ObjValue checkObjValue() const;  // check optima assign
 
-    const NurseNumOfSkill& getNurseNumOfSkill() const { return nurseNumOfSkill; }
-    const NurseWithSkill& getNurseWithSkill() const { return nurseWithSkill; }
+    const NurseNumOfSkill& getNurseNumOfSkill() const { return nurseSkillRelation->nurseNumOfSkill; }
+    const NurseWithSkill& getNurseWithSkill() const { return nurseSkillRelation->nurseWithSkill; }
     bool haveSameSkill( NurseID nurse, NurseID nurse2 ) const
     {
-        return nursesHasSameSkill[nurse][nurse2];
+        return problem.haveSameSkill( nurse, nurse2 );
     }
 
 
@@ -156,7 +173,7 @@ protected:
     static void initResultSheet( std::ofstream &csvFile );
     // solver can check termination condition every certain number of iterations
     // this determines if it is the right iteration to check time
-    static bool isIterForTimeCheck( int iterCount ) // currently no use
+    static bool isIterForTimeCheck( int iterCount )
     {
         return (!(iterCount & CHECK_TIME_INTERVAL_MASK_IN_ITER));
     }
@@ -167,19 +184,21 @@ protected:
         int &consecutiveShift, int &consecutiveDay, int &consecutiveDayOff,
         bool &shiftBegin, bool &dayBegin, bool &dayoffBegin ) const;
 
-    // initialize assist data about nurse-skill relation
+    // take the relation shared by problem, or discover it if there is none
     void discoverNurseSkillRelation();
 
 
     // nurse-skill relation
-    NurseNumOfSkill nurseNumOfSkill;
-    NurseWithSkill nurseWithSkill;
-    NursesHasSameSkill nursesHasSameSkill;
+    std::shared_ptr<const NurseSkillRelation> nurseSkillRelation;
 
 
     Output optima;
+    SharedOptima *sharedOptima;
+    Portfolio *portfolio;
+    int arm;
 
     Config config;
+    int randSeed;
 
     // information for log record
     std::string runID;
@@ -192,6 +211,123 @@ private:    // forbidden operators
 };
 
 
+// diverse solutions with high quality. a solution is rejected if it is
+// close to a better elite, or it replaces all worse elites close to it.
+// the worst elite will be replaced by a better solution if it is full
+class NurseRostering::ElitePool
+{
+public:
+    // two solutions are close if their distance is less than minDistance
+    ElitePool( int capacity, int minDistance )
+        : capacity( capacity ), minDistance( minDistance )
+    {
+    }
+
+    // return true if output is admitted
+    bool add( const Output &output );
+
+    int size() const { return static_cast<int>(elites.size()); }
+    const Output& operator[]( int index ) const { return elites[index]; }
+
+private:
+    int capacity;
+    int minDistance;
+    std::vector<Output> elites;
+};
+
+
+// best solution among the solvers running in parallel on the same problem.
+// the objective value is read without lock and the assignments are guarded
+// by a sequence lock, so readers never block the solver which improves it
+class NurseRostering::SharedOptima
+{
+public:
+    SharedOptima( const NurseRostering &problem );
+
+    ObjValue getObjValue() const { return objValue.load( std::memory_order_acquire ); }
+    // replace the shared optima and return true if output is better
+    bool update( const Output &output );
+    // copy the shared optima into output, return false if there is none
+    bool get( Output &output ) const;
+
+private:    // forbidden operators
+    SharedOptima( const SharedOptima & );
+    SharedOptima& operator=(const SharedOptima &);
+
+private:
+    const NurseID nurseNum;
+
+    std::atomic<ObjValue> objValue;
+    // odd while the assignments are being written
+    std::atomic<unsigned> sequence;
+    std::atomic<double> secondaryObjValue;
+    std::atomic<Timer::Clock::rep> findTime;
+    // each Assign is packed into an int, including the history and
+    // next week slots in AssignTable
+    std::vector< std::atomic<int> > assigns;
+};
+
+
+// CPU allocation among solvers running different algorithms on the same problem.
+// each solver is an arm of a discounted UCB bandit rewarded by the relative
+// improvement it makes in an epoch. at the end of each epoch, the arms with
+// the highest upper confidence bound run in the next epoch while the others
+// are suspended at their next checkpoint or yield() in the search loops
+class NurseRostering::Portfolio
+{
+public:
+    // weight of the reward and count in previous epochs
+    static const double DISCOUNT;
+    // weight of the exploration term in the upper confidence bound
+    static const double EXPLORATION;
+    static const Timer::Duration MIN_EPOCH;
+    // an epoch lasts (timeout / EPOCH_NUM) at least MIN_EPOCH
+    static const int EPOCH_NUM = 32;
+
+    // the first runningNum arms run in the first epoch
+    Portfolio( int armNum, int runningNum, Timer::Duration epoch );
+
+    // called by the solver of the arm whenever its optima is updated, add
+    // improvement (in ratio) to the reward of the arm in current epoch,
+    // then block while the arm is suspended
+    void checkpoint( int arm, double improvement );
+    // block while the arm is suspended, cheap enough to be called frequently
+    void yield( int arm )
+    {
+        if (isSuspended[arm].load( std::memory_order_relaxed )) { checkpoint( arm, 0 ); }
+    }
+    // reallocate at the end of each epoch until timeout, then resume all arms
+    void schedule( const Timer &timer );
+
+    // number of epochs that the arm is selected to run
+    int getRunningEpochNum( int arm ) const { return runningEpochNums[arm]; }
+
+private:    // forbidden operators
+    Portfolio( const Portfolio & );
+    Portfolio& operator=(const Portfolio &);
+
+private:
+    // update the bandit with rewards of the last epoch and select the
+    // arms with highest upper confidence bound to run
+    void reallocate();
+
+    const int runningNum;
+    const Timer::Duration epoch;
+
+    std::mutex mtx;
+    std::condition_variable resumeCond;
+    bool isStopped;
+
+    std::vector<bool> isRunning;
+    // (isSuspended[arm] == !isRunning[arm]) until stopped, read without lock
+    std::vector< std::atomic<bool> > isSuspended;
+    std::vector<int> runningEpochNums;
+    std::vector<double> improvements;   // in current epoch
+    std::vector<double> discountedRewards;
+    std::vector<double> discountedCounts;
+};
+
+
 class NurseRostering::TabuSolver : public NurseRostering::Solver
 {
 public:
@@ -203,6 +339,13 @@ public:
     static const int INVERSE_TOTAL_BIAS_RATIO = 4;
     // ratio of biased nurse selected by penalty of each nurse
     static const int INVERSE_PENALTY_BIAS_RATIO = 5;
+    // max number of elites in path relinking
+    static const int ELITE_POOL_SIZE = 8;
+    // min distance among elites is (assignment cell number / it)
+    static const int INVERSE_ELITE_DISTANCE_RATIO = 8;
+    // min number of individuals in memetic search, the population is
+    // also no less than the number of threads in scanPool
+    static const int MIN_POPULATION_SIZE = 4;
 
 
     TabuSolver( const NurseRostering &input, Timer::TimePoint startTime = Timer::Clock::now() );
@@ -217,7 +360,7 @@ public:
 
     void checkDump( std::string assignString )
     {
-        sln.rebuild( Output( 0, AssignTable( problem.scenario.nurseNum, Weekday::SIZE, assignString ) ) );
+        sln.rebuild( Output( 0, AssignTable( problem.scenario->nurseNum, Weekday::SIZE, assignString ) ) );
         sln.evaluateObjValue( false );
         sln.evaluateObjValue();
         checkFeasibility( sln.getAssignTable() );
@@ -236,11 +379,55 @@ public:
     IterCount MaxSwapChainRestartCount() const { return maxSwapChainRestartCount; }
 
 private:
+    // search perturbed restarts of the same generation on scanPool.
+    // the k-th restart is searched by the solution of worker (k % workerNum).
+    // each restart is a short search with (maxNoImproveCount / restartNum)
+    // so that a generation costs about the same as a sequential one
+    class Restart : public ThreadPool::Job
+    {
+    public:
+        Restart( TabuSolver &solver, const Solution::ModeSeqPattern &pattern,
+            Solution::TabuSearch search, IterCount maxNoImproveCount, bool isSwapChainFollowed );
+        ~Restart();
+
+        // rebuild from origin with strengths increasing from perturbStrength
+        // by perturbStrengthDelta, return the best optima among the restarts
+        const Output& run( const Output &origin, double perturbStrength, double perturbStrengthDelta );
+        IterCount getIterCount() const;
+
+        virtual void operator()( int workerIndex );
+
+    private:    // forbidden operators
+        Restart( const Restart & );
+        Restart& operator=(const Restart &);
+
+    private:
+        TabuSolver &s;
+        const Solution::ModeSeqPattern &modeSeqPat;
+        Solution::TabuSearch search;
+        IterCount maxNoImproveCount;
+        bool isSwapChainFollowed;
+
+        std::vector<Solution*> slns;
+        const Output *origin;
+        std::vector<double> strengths;
+        std::vector<unsigned> seeds;
+        std::vector<Output> results;
+    };
+
     void greedyInit();
     void exactInit();
+    // greedy init if there is no roster of last week or it can not be repaired
+    void warmStartInit();
 
     // search with tabu search and swap chain search by turn
     void swapChainSearch( Solution::ModeSeq modeSeq );
+    // collect elites by tabu search with restarts, and relink pairs of
+    // elites on scanPool, then improve the best solutions on the paths
+    void pathRelinking( Solution::ModeSeq modeSeq );
+    // breed children by row or column crossover of the individuals in the
+    // population and improve them with tabu search on scanPool
+    void memeticSearch( Solution::ModeSeq modeSeq );
     // turn the objective to optimize a subset of nurses when no improvement
     void biasTabuSearch( Solution::ModeSeq modeSeq );
     // search with tabu table
@@ -272,13 +459,13 @@ private:
         algorithmName += oss.str();
 
         maxNoImproveForSingleNeighborhood = static_cast<IterCount>(
-            coefficient * problem.scenario.nurseNum * Weekday::NUM);
+            coefficient * problem.scenario->nurseNum * Weekday::NUM);
         maxNoImproveForAllNeighborhood = static_cast<IterCount>(
-            coefficient * problem.scenario.nurseNum * Weekday::NUM *
-            sqrt( problem.scenario.shiftTypeNum * problem.scenario.skillTypeNum ));
+            coefficient * problem.scenario->nurseNum * Weekday::NUM *
+            sqrt( problem.scenario->shiftTypeNum * problem.scenario->skillTypeNum ));
         maxNoImproveForBiasTabuSearch = maxNoImproveForSingleNeighborhood / INVERSE_TOTAL_BIAS_RATIO;
         maxNoImproveSwapChainLength = maxNoImproveForSingleNeighborhood;
-        maxSwapChainRestartCount = static_cast<IterCount>(sqrt( problem.scenario.nurseNum ));
+        maxSwapChainRestartCount = static_cast<IterCount>(sqrt( problem.scenario->nurseNum ));
     }
 
     IterCount dayTabuTenureBase;
@@ -292,6 +479,8 @@ private:
     IterCount maxNoImproveSwapChainLength;
     IterCount maxSwapChainRestartCount;
 
+    // threads joining in neighborhood scans of sln
+    ThreadPool scanPool;
     Solution sln;
 
 private:    // forbidden operators
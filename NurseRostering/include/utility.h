@@ -11,12 +11,15 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 #include <cstdlib>
 #include <random>
 #include <chrono>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <cstdio>
+#include <algorithm>
 
 #include "DebugFlag.h"
 
@@ -134,16 +137,245 @@ public:
         }
     }
 
+    // number of elements which have competed for current selection
+    int candidateNum() const { return count; }
+
 private:
     int count;
 };
 
+// complete binary tree on indexed keys, each node records the minimal key
+// in its subtree and how many leaves hold it. so the minimal key and a
+// uniformly random leaf among all minimal ones can be found in O(log N).
+// require operator<() and operator==()
+template <typename T>
+class TournamentTree
+{
+public:
+    TournamentTree( int size = 0 ) : leafNum( 1 )
+    {
+        while (leafNum < size) { leafNum *= 2; }
+        nodes.resize( 2 * leafNum );
+    }
+
+    bool empty() const { return (nodes[1].count == 0); }
+    // the minimal key and the number of leaves holding it
+    const T& min() const { return nodes[1].key; }
+    int minCount() const { return nodes[1].count; }
+
+    // set the key of leaf index
+    void update( int index, const T &key )
+    {
+        Node &leaf( nodes[index + leafNum] );
+        leaf.key = key;
+        leaf.count = 1;
+        propagate( index );
+    }
+    // leave leaf index out of the competition
+    void erase( int index )
+    {
+        nodes[index + leafNum].count = 0;
+        propagate( index );
+    }
+
+    // return index of a uniformly random leaf among all minimal ones.
+    // the tree must not be empty
+    int select( std::mt19937 &randGen ) const
+    {
+        int rank = randGen() % nodes[1].count;
+        int i = 1;
+        while (i < leafNum) {
+            const Node &left( nodes[2 * i] );
+            int leftCount = ((left.count > 0) && (left.key == nodes[i].key)) ? left.count : 0;
+            if (rank < leftCount) {
+                i = 2 * i;
+            } else {
+                rank -= leftCount;
+                i = 2 * i + 1;
+            }
+        }
+        return (i - leafNum);
+    }
+
+private:
+    struct Node
+    {
+        Node() : count( 0 ) {}
+
+        T key;
+        int count;  // 0 means there is no key in the subtree
+    };
+
+    void propagate( int index )
+    {
+        for (int i = (index + leafNum) / 2; i > 0; i /= 2) {
+            const Node &left( nodes[2 * i] );
+            const Node &right( nodes[2 * i + 1] );
+            Node &node( nodes[i] );
+            if ((left.count == 0) || ((right.count > 0) && (right.key < left.key))) {
+                node = right;
+            } else if ((right.count == 0) || (left.key < right.key)) {
+                node = left;
+            } else {
+                node.key = left.key;
+                node.count = left.count + right.count;
+            }
+        }
+    }
+
+    int leafNum;
+    std::vector<Node> nodes;
+};
+
+// fixed number of threads which live as long as the pool.
+// run() hands a job to all of them and the calling thread which takes
+// the worker index 0, then returns after all of them have finished it.
+// run() must not be called by different threads at the same time, while
+// it can be called inside a running job and be done in the calling thread
+class ThreadPool
+{
+public:
+    class Job
+    {
+    public:
+        virtual ~Job() {}
+        virtual void operator()( int workerIndex ) = 0;
+    };
+
+    // the calling thread is counted in threadNum
+    ThreadPool( int threadNum = 1 );
+    ~ThreadPool();
+
+    int size() const { return static_cast<int>(threads.size()) + 1; }
+
+    void run( Job &job );
+
+private:    // forbidden operators
+    ThreadPool( const ThreadPool & );
+    ThreadPool& operator=(const ThreadPool &);
+
+private:
+    void work( int workerIndex );
+
+    std::vector<std::thread> threads;
+    std::mutex mtx;
+    std::condition_variable startCond;
+    std::condition_variable finishCond;
+    Job *job;
+    // increased on each run() to wake up all workers exactly once
+    int generation;
+    int busyWorkerNum;
+    bool isStopped;
+};
+
+// load a whole text file with a single read and split it into tokens in
+// place by overwriting delimiters with '\0', so no string is constructed
+// for a token. whitespaces are always delimiters.
+// MappedFile is not used since the view is read-only, and copying it into
+// a writable buffer costs the same as the single read of a small file
+class TextTokenizer
+{
+public:
+    TextTokenizer( const char *extraDelimiters = "" );
+
+    // return false if the file can not be opened
+    bool load( const std::string &filename );
+
+    // return NULL if there is no more token
+    const char* next();
+    void skip( int tokenNum )
+    {
+        for (; tokenNum > 0; --tokenNum) { next(); }
+    }
+    // parse next token as a decimal integer, return 0 if there is no more token
+    int nextInt();
+
+private:
+    std::vector<char> buf;  // terminated by an additional '\0'
+    size_t pos;
+    bool isDelimiter[256];
+};
+
+// read-only view of a whole file which is mapped into memory, so it is
+// paged in on demand and shared by all processes reading the same file
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // return false if the file can not be opened or mapped
+    bool open( const std::string &filename );
+    void close();
+
+    // NULL if no file is opened or the file is empty
+    const char* data() const { return begin; }
+    size_t size() const { return length; }
+
+private:    // forbidden operators
+    MappedFile( const MappedFile & );
+    MappedFile& operator=(const MappedFile &);
+
+private:
+    const char *begin;
+    size_t length;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#endif
+};
+
+// open addressing hash table from names to ids on a flat array,
+// which looks up a C string directly without constructing a std::string
+class NameTable
+{
+public:
+    NameTable( int capacity = 0 );
+
+    // overwrite the id if the name is already in the table
+    void insert( const std::string &name, int id );
+    // return false if the name is not in the table
+    bool find( const char *name, int &id ) const;
+
+private:
+    struct Entry
+    {
+        Entry() : isUsed( false ) {}
+
+        std::string name;
+        unsigned hashValue;
+        int id;
+        bool isUsed;
+    };
+
+    // FNV-1a
+    static unsigned hash( const char *name )
+    {
+        unsigned h = 2166136261U;
+        for (; *name != '\0'; ++name) {
+            h = (h ^ static_cast<unsigned char>(*name)) * 16777619U;
+        }
+        return h;
+    }
+
+    // return the entry holding name or the empty one to place it
+    size_t probe( const char *name, unsigned hashValue ) const;
+    void rehash( size_t capacity );
+
+    std::vector<Entry> entries; // size is always power of 2
+    size_t usedNum;
+};
+
 //
 std::string getLastNoneEmptyLine( const std::string &filename );
 
 //
 std::string getTime();
 
+// absolute path without "." , ".." or symbolic links (on POSIX),
+// return the path as it is if it can not be resolved
+std::string getCanonicalPath( const std::string &path );
+
 //
 extern std::mutex logFileMutex;
 
@@ -19,6 +19,9 @@ namespace INRC2
     const std::string ARGV_TIME( "timeout" );  // in seconds
     const std::string ARGV_ITER( "iter" );
     const std::string ARGV_CONFIG( "config" );
+    const std::string ARGV_SCAN_THREAD( "scanThread" );
+    const std::string ARGV_THREAD( "threads" );
+    const std::string ARGV_RESTART( "restarts" );
     const std::string ARGV_HELP( "help" );
 
     const std::string weekdayNames[NurseRostering::Weekday::SIZE] = {
@@ -43,6 +46,11 @@ namespace INRC2
             "  sce       - scenario file path.\n"
             "  his       - history file path.\n"
             "  week      - weekdata file path.\n"
+            "              sce, his and week can also be a record in an instance\n"
+            "              bundle like path/to/bundle#Sc-n005w4.txt if path/to/bundle\n"
+            "              is an existing file and the path itself does not exist.\n"
+            "              records are copied out of the mapped bundle on reading,\n"
+            "              see writeBundle().\n"
             "  sol       - solution file path.\n"
             "  [cusIn]   - custom input file path.\n"
             "  [cusOut]  - custom output file path.\n"
@@ -50,16 +58,31 @@ namespace INRC2
             "  [timeout] - max running time of the solver.\n"
             "  [iter]    - max iteration count of the solver.\n"
             "              reaching either timeout or iter will end the program.\n"
+            "  [scanThread] - number of threads scanning neighborhoods. they search\n"
+            "              selected neighborhoods concurrently in 'p'(Tabu Search\n"
+            "              Possibility), or split the re-evaluation of invalidated\n"
+            "              block swap pairs (INRC2_BLOCK_SWAP_INDEXED) in other modes.\n"
+            "              in 'p' the block swap is already searched on a scan\n"
+            "              thread, so its re-evaluation runs serially there.\n"
+            "              the result is reproducible for the same rand and scanThread.\n"
+            "  [restarts] - number of perturbed restarts searched at once on scan\n"
+            "              threads in each generation of 'l', 'p', 'r' and 's'. each\n"
+            "              restart has its own perturb strength and rand seed, and\n"
+            "              the best of them is kept for the next generation. each\n"
+            "              restart stops after 1/restarts of the no-improve limit.\n"
             "  [config]  - specifies algorithm select and argument settings.\n"
             "              format: cci;d;d,d,d,d;d,d,d,d\n"
             "                  c for char, d for real number,\n"
             "                  comma is used to separate numbers.\n"
             "                  the first char can be:\n"
-            "                      'g'(greedy init) or 'e'(exact init).\n"
+            "                      'g'(greedy init), 'e'(exact init) or 'w'(warm start\n"
+            "                      init from the roster of last week in cusIn, which\n"
+            "                      falls back to greedy init if it is not available).\n"
             "                  the second char can be:\n"
             "                      'w'(Random Walk), 'i'(Iterative Local Search),\n"
             "                      'p'(Tabu Search Possibility), 'l'(TS Loop),\n"
-            "                      'r'(TS Rand), 's'(Swap Chain) or 'b'(Bias TS).\n"
+            "                      'r'(TS Rand), 's'(Swap Chain), 'b'(Bias TS)\n"
+            "                      'k'(Path Relinking) or 'm'(Memetic).\n"
             "                  i is a non-negative integer in enum Solution::ModeSeq.\n"
             "                  next real number is the coefficient of no improve count.\n"
             "                  following 4 real numbers are coefficients for TableSize,\n"
@@ -69,6 +92,13 @@ namespace INRC2
             "                  used in shift tabu tenure setting with same meaning.\n"
             "              example: gt2;1.5;0,0.5,0,0;0,0.8,0,0\n"
             "                       gt3;0.8;0.1,0,0,0;0.1,0,0,0\n"
+            "              several configs separated by '/' are dealt to threads in turn.\n"
+            "              if there are more configs than threads, each config gets\n"
+            "              a solver and the threads are moved to the configs which\n"
+            "              improve the solution faster during the run.\n"
+            "  [threads] - number of solvers running in parallel with different\n"
+            "              rand seeds. they share the best solution found so far,\n"
+            "              and the best one among all of them will be output.\n"
             << endl;
     }
 
@@ -102,15 +132,17 @@ namespace INRC2
         }
 
         // load weekdata
-        if (!readWeekData( argvMap[ARGV_WEEKDATA], input )) {
+        if (!readWeekData_Fast( argvMap[ARGV_WEEKDATA], input )) {
             return -1;
         }
 
         // load history last for it will initialize some assist data depending on scenario and weekdata
         if (argvMap.find( ARGV_CUSTOM_INPUT ) != argvMap.end()) {
-            readCustomInput( argvMap[ARGV_CUSTOM_INPUT], input );
+            if (!readCustomInput( argvMap[ARGV_CUSTOM_INPUT], input )) {
+                return -1;
+            }
         } else if (argvMap.find( ARGV_HISTORY ) != argvMap.end()) {
-            readHistory( argvMap[ARGV_HISTORY], input );
+            readHistory_Fast( argvMap[ARGV_HISTORY], input );
         } else {
             errorLog( "missing obligate argument(history)" );
             return -1;
@@ -150,11 +182,95 @@ namespace INRC2
             input.maxIterCount = NurseRostering::MAX_ITER_COUNT;
         }
 
+        // load scan thread number
+        if (argvMap.find( ARGV_SCAN_THREAD ) != argvMap.end()) {
+            istringstream iss( argvMap[ARGV_SCAN_THREAD] );
+            iss >> input.scanThreadNum;
+            if (input.scanThreadNum < 1) {
+                input.scanThreadNum = 1;
+            }
+        }
+
+        // load restart number
+        if (argvMap.find( ARGV_RESTART ) != argvMap.end()) {
+            istringstream iss( argvMap[ARGV_RESTART] );
+            iss >> input.restartNum;
+            if (input.restartNum < 1) {
+                input.restartNum = 1;
+            }
+        }
+
+        // load thread number
+        int threadNum = 1;
+        if (argvMap.find( ARGV_THREAD ) != argvMap.end()) {
+            istringstream iss( argvMap[ARGV_THREAD] );
+            iss >> threadNum;
+            if (threadNum < 1) {
+                threadNum = 1;
+            }
+        }
+
+        // split configs
+        vector<string> configStrings;
+        istringstream configs( argvMap[ARGV_CONFIG] );
+        for (string configString; getline( configs, configString, '/' );) {
+            configStrings.push_back( configString );
+        }
+        if (configStrings.empty()) {
+            configStrings.push_back( "" );
+        }
+
         // start computation
         input.adjustRangeOfTotalAssignByWorkload();
-        NurseRostering::TabuSolver solver( input, startTime );
-        solver.init( parseConfig( argvMap[ARGV_CONFIG] ), argvMap[ARGV_ID] );
-        solver.solve();
+        vector<NurseRostering::TabuSolver*> solvers;
+        int solverNum = max( threadNum, static_cast<int>(configStrings.size()) );
+        if (solverNum == 1) {
+            solvers.push_back( new NurseRostering::TabuSolver( input, startTime ) );
+            solve( *solvers.front(), parseConfig( configStrings.front() ), argvMap[ARGV_ID] );
+        } else {
+            // there is a solver for each config if configs are more than
+            // threads, and the portfolio decides which of them are running
+            Timer timer( input.timeout, startTime );
+            NurseRostering::Portfolio portfolio( solverNum, threadNum, max(
+                input.timeout / static_cast<int>(NurseRostering::Portfolio::EPOCH_NUM), NurseRostering::Portfolio::MIN_EPOCH ) );
+            // the first solver keeps the given seed
+            NurseRostering::SharedOptima sharedOptima( input );
+            mt19937 seedGen( input.randSeed );
+            vector<thread> threads;
+            for (int i = 0; i < solverNum; ++i) {
+                solvers.push_back( new NurseRostering::TabuSolver( input, startTime ) );
+                solvers.back()->setRandSeed( (i == 0) ? input.randSeed : static_cast<int>(seedGen()) );
+                solvers.back()->setSharedOptima( &sharedOptima );
+                if (solverNum > threadNum) {
+                    solvers.back()->setPortfolio( &portfolio, i );
+                }
+                threads.push_back( thread( solve, ref( *solvers.back() ),
+                    parseConfig( configStrings[i % configStrings.size()] ), argvMap[ARGV_ID] ) );
+            }
+            if (solverNum > threadNum) {
+                portfolio.schedule( timer );
+            }
+            for (vector<thread>::iterator iter = threads.begin(); iter != threads.end(); ++iter) {
+                iter->join();
+            }
+#ifdef INRC2_PERFORMANCE_TEST
+            if (solverNum > threadNum) {
+                cout << "running epochs of each config:";
+                for (int i = 0; i < solverNum; ++i) {
+                    cout << ' ' << portfolio.getRunningEpochNum( i );
+                }
+                cout << endl;
+            }
+#endif
+        }
+
+        int best = 0;
+        for (int i = 1; i < solverNum; ++i) {
+            if (solvers[i]->getOptima().getObjValue() < solvers[best]->getOptima().getObjValue()) {
+                best = i;
+            }
+        }
+        const NurseRostering::TabuSolver &solver( *solvers[best] );
 
         // write output
         writeSolution( argvMap[ARGV_SOLUTION], solver );
@@ -167,23 +283,181 @@ namespace INRC2
         solver.print();
 
         ostringstream oss;
-        int historyFileNameIndex = argvMap[ARGV_HISTORY].find_last_of( "/\\" ) + 1;
-        int weekdataFileNameIndex = argvMap[ARGV_WEEKDATA].find_last_of( "/\\" ) + 1;
-        oss << input.names.scenarioName
-            << '[' << argvMap[ARGV_HISTORY].substr( historyFileNameIndex ) << ']'
-            << '[' << argvMap[ARGV_WEEKDATA].substr( weekdataFileNameIndex ) << ']';
+        oss << input.names->scenarioName
+            << '[' << getShortFileName( argvMap[ARGV_HISTORY] ) << ']'
+            << '[' << getShortFileName( argvMap[ARGV_WEEKDATA] ) << ']';
         solver.record( LOG_FILE_NAME, oss.str() );
 #endif
 #ifdef INRC2_TRAJECTORY_REPORT
         cerr << endl;
 #endif // INRC2_TRAJECTORY_REPORT
 
+        for (vector<NurseRostering::TabuSolver*>::iterator iter = solvers.begin();
+            iter != solvers.end(); ++iter) {
+            delete *iter;
+        }
+
         return 0;
     }
 
+    void solve( NurseRostering::TabuSolver &solver, const NurseRostering::Solver::Config &cfg, const std::string &runID )
+    {
+        solver.init( cfg, runID );
+        solver.solve();
+    }
+
+    bool runWeeks( const std::string &id, const std::string &configString,
+        const std::string &scenarioFileName, const std::string &initHistoryFileName,
+        const std::vector<std::string> &weekDataFileNames, double timeoutInSec, int randSeed,
+        const std::string &solutionFilePrefix )
+    {
+        NurseRostering input;
+        if (!readScenario( scenarioFileName, input )) {
+            return false;
+        }
+        // load history last for it will initialize some assist data depending on scenario and weekdata
+        if (weekDataFileNames.empty() || !readWeekData_Fast( weekDataFileNames.front(), input )) {
+            return false;
+        }
+        if (!readHistory_Fast( initHistoryFileName, input )) {
+            return false;
+        }
+        input.randSeed = randSeed;
+        input.timeout = Timer::Duration( static_cast<int>(timeoutInSec *
+            chrono::duration_cast<Timer::Duration>(chrono::seconds( 1 )).count()) )
+            - NurseRostering::Solver::SAVE_SOLUTION_TIME;
+        input.maxIterCount = NurseRostering::MAX_ITER_COUNT;
+
+        NurseRostering::Solver::Config config( parseConfig( configString ) );
+        string historyName( getShortFileName( initHistoryFileName ) );
+
+        // the writer of last week owns its solver and a copy of the input,
+        // so the next week can be solved meanwhile
+        thread writer;
+        bool isAllRead = true;
+        for (unsigned week = 0; week < weekDataFileNames.size(); ++week) {
+            if ((week > 0) && !readWeekData_Fast( weekDataFileNames[week], input )) {
+                isAllRead = false;
+                break;
+            }
+            input.adjustRangeOfTotalAssignByWorkload();
+
+            NurseRostering *weekInput = new NurseRostering( input );
+            NurseRostering::TabuSolver *solver = new NurseRostering::TabuSolver( *weekInput );
+            solve( *solver, config, id );
+            input.history = solver->genHistory();
+            input.lastWeekAssign = solver->getOptima().getAssignTable();
+
+            ostringstream instanceName;
+            instanceName << input.names->scenarioName
+                << '[' << historyName << ']'
+                << '[' << getShortFileName( weekDataFileNames[week] ) << ']';
+            ostringstream solutionFileName;
+            if (!solutionFilePrefix.empty()) {
+                solutionFileName << solutionFilePrefix << week << ".txt";
+            }
+
+            if (writer.joinable()) { writer.join(); }
+            writer = thread( writeWeek, solver, weekInput, solutionFileName.str(), instanceName.str() );
+
+            // keep the log identical to the weekly runs on custom files
+            ostringstream nextHistoryName;
+            nextHistoryName << "history-week" << week << ".txt";
+            historyName = nextHistoryName.str();
+        }
+        if (writer.joinable()) { writer.join(); }
+
+        return isAllRead;
+    }
+
+    void writeWeek( NurseRostering::TabuSolver *solver, const NurseRostering *input,
+        const std::string &solutionFileName, const std::string &instanceName )
+    {
+        if (!solutionFileName.empty()) {
+            writeSolution( solutionFileName, *solver );
+        }
+#ifdef INRC2_LOG
+        solver->check();
+        solver->print();
+        solver->record( LOG_FILE_NAME, instanceName );
+#endif
+
+        delete solver;
+        delete input;
+    }
+
     bool readScenario( const std::string &scenarioFileName, NurseRostering &input )
     {
-        NurseRostering::Scenario &scenario = input.scenario;
+        std::shared_ptr<const NurseRostering> parsed( loadScenario( scenarioFileName ) );
+        if (parsed == NULL) {
+            return false;
+        }
+
+        // share the read only data rather than copying them
+        input.scenario = parsed->scenario;
+        input.names = parsed->names;
+        input.nurseSkillRelation = parsed->nurseSkillRelation;
+        input.nameTables = parsed->nameTables;
+        return true;
+    }
+
+    std::shared_ptr<const NurseRostering> loadScenario( const std::string &scenarioFileName )
+    {
+        struct CacheItem
+        {
+            // a file is reloaded if either of them changes
+            time_t modifyTime;
+            long long fileSize;
+            std::shared_ptr<const NurseRostering> scenario;
+        };
+
+        static mutex cacheMutex;
+        static map<string, CacheItem> cache;
+
+        // the modify time of the bundle is checked for a record in it
+        string bundleFileName, recordName;
+        string key;
+        if (isBundleRecord( scenarioFileName, bundleFileName, recordName )) {
+            key = getCanonicalPath( bundleFileName ) + BUNDLE_RECORD_SEPARATOR + recordName;
+        } else {
+            bundleFileName = scenarioFileName;
+            key = getCanonicalPath( scenarioFileName );
+        }
+        struct stat fileStat;
+        if (stat( bundleFileName.c_str(), &fileStat ) != 0) {
+            errorLog( "fail to open scenario file : " + scenarioFileName );
+            return std::shared_ptr<const NurseRostering>();
+        }
+
+        // parse with lock held, so threads on the same scenario parse it once
+        lock_guard<mutex> lock( cacheMutex );
+        map<string, CacheItem>::iterator iter = cache.find( key );
+        if ((iter != cache.end()) && (iter->second.modifyTime == fileStat.st_mtime)
+            && (iter->second.fileSize == fileStat.st_size)) {
+            return iter->second.scenario;
+        }
+
+        std::shared_ptr<NurseRostering> scenario( new NurseRostering() );
+        if (!parseScenario_Fast( scenarioFileName, *scenario )) {
+            return std::shared_ptr<const NurseRostering>();
+        }
+        scenario->nurseSkillRelation = scenario->discoverNurseSkillRelation();
+        scenario->nameTables = genNameTables( *scenario->names );
+
+        CacheItem &item( cache[key] );
+        item.modifyTime = fileStat.st_mtime;
+        item.fileSize = fileStat.st_size;
+        item.scenario = scenario;
+        return scenario;
+    }
+
+    bool parseScenario( const std::string &scenarioFileName, NurseRostering &input )
+    {
+        // parse into new ones, for the old ones may be shared with other inputs
+        std::shared_ptr<NurseRostering::Scenario> parsedScenario( new NurseRostering::Scenario() );
+        std::shared_ptr<NurseRostering::Names> parsedNames( new NurseRostering::Names() );
+        NurseRostering::Scenario &scenario( *parsedScenario );
+        NurseRostering::Names &names( *parsedNames );
         char c;
         char buf[MAX_BUF_SIZE];
         ifstream ifs( scenarioFileName );
@@ -194,7 +468,7 @@ namespace INRC2
         }
 
         ifs.getline( buf, MAX_BUF_LEN, '=' );   // SCENARIO =
-        ifs >> input.names.scenarioName;        //  nXXXwX
+        ifs >> names.scenarioName;              //  nXXXwX
 
         ifs.getline( buf, MAX_BUF_LEN );        // empty line
         ifs.getline( buf, MAX_BUF_LEN, '=' );   // WEEKS =
@@ -206,10 +480,10 @@ namespace INRC2
         ifs.getline( buf, MAX_BUF_LEN, '=' );   // SKILLS =
         ifs >> scenario.skillTypeNum;
         scenario.skillSize = scenario.skillTypeNum + NurseRostering::Scenario::Skill::ID_BEGIN;
-        input.names.skillNames.resize( scenario.skillSize );
+        names.skillNames.resize( scenario.skillSize );
         for (NurseRostering::SkillID i = NurseRostering::Scenario::Skill::ID_BEGIN; i < scenario.skillSize; ++i) {
-            ifs >> input.names.skillNames[i];
-            input.names.skillMap[input.names.skillNames[i]] = i;
+            ifs >> names.skillNames[i];
+            names.skillMap[names.skillNames[i]] = i;
         }
         ifs.getline( buf, MAX_BUF_LEN );        // clear line
 
@@ -218,19 +492,19 @@ namespace INRC2
         ifs >> scenario.shiftTypeNum;
         scenario.shiftSize = scenario.shiftTypeNum + NurseRostering::Scenario::Shift::ID_BEGIN;
         scenario.shifts.resize( scenario.shiftSize );
-        input.names.shiftNames.resize( scenario.shiftSize );
+        names.shiftNames.resize( scenario.shiftSize );
         for (NurseRostering::ShiftID i = NurseRostering::Scenario::Shift::ID_BEGIN; i < scenario.shiftSize; ++i) {
             NurseRostering::Scenario::Shift &shift = scenario.shifts[i];
-            ifs >> input.names.shiftNames[i] >> c    // name (
+            ifs >> names.shiftNames[i] >> c            // name (
                 >> shift.minConsecutiveShiftNum >> c   // XX,
                 >> shift.maxConsecutiveShiftNum >> c;  // XX)
-            input.names.shiftMap[input.names.shiftNames[i]] = i;
+            names.shiftMap[names.shiftNames[i]] = i;
         }
         ifs.getline( buf, MAX_BUF_LEN );        // clear line
 
         ifs.getline( buf, MAX_BUF_LEN );        // empty line
         ifs.getline( buf, MAX_BUF_LEN );        // FORBIDDEN_SHIFT_TYPES_SUCCESSIONS
-        scenario.shifts[NurseRostering::Scenario::Shift::ID_NONE].legalNextShifts = vector<bool>( scenario.shiftSize, true );
+        scenario.shifts[NurseRostering::Scenario::Shift::ID_NONE].legalNextShifts = ~0U;
         scenario.shifts[NurseRostering::Scenario::Shift::ID_NONE].illegalNextShiftNum = 0;
         for (NurseRostering::ShiftID i = NurseRostering::Scenario::Shift::ID_BEGIN; i < scenario.shiftSize; ++i) {
             NurseRostering::Scenario::Shift &shift = scenario.shifts[i];
@@ -238,10 +512,10 @@ namespace INRC2
             int succesionNum;
             ifs >> shiftName >> succesionNum;
             shift.illegalNextShiftNum = succesionNum;
-            shift.legalNextShifts = vector<bool>( scenario.shiftSize, true );
+            shift.legalNextShifts = ~0U;
             for (int j = 0; j < succesionNum; ++j) {
                 ifs >> nextShiftName;
-                shift.legalNextShifts[input.names.shiftMap[nextShiftName]] = false;
+                shift.legalNextShifts &= ~(1U << names.shiftMap[nextShiftName]);
             }
         }
         ifs.getline( buf, MAX_BUF_LEN );        // clear line
@@ -251,10 +525,10 @@ namespace INRC2
         int contractNum;
         ifs >> contractNum;
         scenario.contracts.resize( contractNum );
-        input.names.contractNames.resize( contractNum );
+        names.contractNames.resize( contractNum );
         for (NurseRostering::ContractID i = 0; i < contractNum; ++i) {
             NurseRostering::Scenario::Contract &contract = scenario.contracts[i];
-            ifs >> input.names.contractNames[i] >> c         // name (
+            ifs >> names.contractNames[i] >> c               // name (
                 >> contract.minShiftNum >> c                 // XX,
                 >> contract.maxShiftNum >> c >> c            // XX) (
                 >> contract.minConsecutiveDayNum >> c        // XX,
@@ -263,7 +537,7 @@ namespace INRC2
                 >> contract.maxConsecutiveDayoffNum >> c     // )
                 >> contract.maxWorkingWeekendNum
                 >> contract.completeWeekend;
-            input.names.contractMap[input.names.contractNames[i]] = i;
+            names.contractMap[names.contractNames[i]] = i;
         }
         ifs.getline( buf, MAX_BUF_LEN );        // clear line
 
@@ -271,22 +545,24 @@ namespace INRC2
         ifs.getline( buf, MAX_BUF_LEN, '=' );   // NURSES =
         ifs >> scenario.nurseNum;
         scenario.nurses.resize( scenario.nurseNum );
-        input.names.nurseNames.resize( scenario.nurseNum );
+        names.nurseNames.resize( scenario.nurseNum );
         for (NurseRostering::NurseID i = 0; i < scenario.nurseNum; ++i) {
             NurseRostering::Scenario::Nurse &nurse = scenario.nurses[i];
             string contractName, skillName;
-            ifs >> input.names.nurseNames[i] >> contractName >> nurse.skillNum;
-            input.names.nurseMap[input.names.nurseNames[i]] = i;
-            nurse.contract = input.names.contractMap[contractName];
+            ifs >> names.nurseNames[i] >> contractName >> nurse.skillNum;
+            names.nurseMap[names.nurseNames[i]] = i;
+            nurse.contract = names.contractMap[contractName];
             scenario.contracts[nurse.contract].nurses.push_back( i );
-            nurse.skills = vector<bool>( scenario.skillSize, false );
+            nurse.skills = 0;
             for (int j = 0; j < nurse.skillNum; ++j) {
                 ifs >> skillName;
-                nurse.skills[input.names.skillMap[skillName]] = true;
+                nurse.skills |= (1U << names.skillMap[skillName]);
             }
         }
 
         ifs.close();
+        input.scenario = parsedScenario;
+        input.names = parsedNames;
         return true;
     }
 
@@ -305,25 +581,25 @@ namespace INRC2
         ifs.getline( buf, MAX_BUF_LEN );    // HISTORY
         ifs >> history.pastWeekCount;         // X
         history.currentWeek = history.pastWeekCount + 1;
-        history.restWeekCount = input.scenario.totalWeekNum - history.pastWeekCount;
+        history.restWeekCount = input.scenario->totalWeekNum - history.pastWeekCount;
         ifs.getline( buf, MAX_BUF_LEN );    //  nXXXwX
         ifs.getline( buf, MAX_BUF_LEN );    // empty line
         ifs.getline( buf, MAX_BUF_LEN );    // NURSE_HISTORY
 
-        history.totalAssignNums.resize( input.scenario.nurseNum );
-        history.totalWorkingWeekendNums.resize( input.scenario.nurseNum );
-        history.lastShifts.resize( input.scenario.nurseNum );
-        history.consecutiveShiftNums.resize( input.scenario.nurseNum );
-        history.consecutiveDayNums.resize( input.scenario.nurseNum );
-        history.consecutiveDayoffNums.resize( input.scenario.nurseNum );
-        for (int i = 0; i < input.scenario.nurseNum; ++i) {
+        history.totalAssignNums.resize( input.scenario->nurseNum );
+        history.totalWorkingWeekendNums.resize( input.scenario->nurseNum );
+        history.lastShifts.resize( input.scenario->nurseNum );
+        history.consecutiveShiftNums.resize( input.scenario->nurseNum );
+        history.consecutiveDayNums.resize( input.scenario->nurseNum );
+        history.consecutiveDayoffNums.resize( input.scenario->nurseNum );
+        for (int i = 0; i < input.scenario->nurseNum; ++i) {
             string nurseName, lastShiftName;
             ifs >> nurseName;
-            NurseRostering::NurseID nurse = input.names.nurseMap[nurseName];
+            NurseRostering::NurseID nurse = NurseRostering::Names::getID( input.names->nurseMap, nurseName );
             ifs >> history.totalAssignNums[nurse] >> history.totalWorkingWeekendNums[nurse]
                 >> lastShiftName >> history.consecutiveShiftNums[nurse]
                 >> history.consecutiveDayNums[nurse] >> history.consecutiveDayoffNums[nurse];
-            history.lastShifts[nurse] = input.names.shiftMap[lastShiftName];
+            history.lastShifts[nurse] = NurseRostering::Names::getID( input.names->shiftMap, lastShiftName );
             if (history.pastWeekCount == 0) {   // clear total assign if it is the first week
                 history.totalAssignNums[nurse] = 0;
                 history.totalWorkingWeekendNums[nurse] = 0;
@@ -338,11 +614,10 @@ namespace INRC2
     {
         NurseRostering::WeekData &weekdata = input.weekData;
         weekdata.minNurseNums = vector< vector< vector<int> > >( NurseRostering::Weekday::SIZE,
-            vector< vector<int> >( input.scenario.shiftSize, vector<int>( input.scenario.skillSize ) ) );
+            vector< vector<int> >( input.scenario->shiftSize, vector<int>( input.scenario->skillSize ) ) );
         weekdata.optNurseNums = vector< vector< vector<int> > >( NurseRostering::Weekday::SIZE,
-            vector< vector<int> >( input.scenario.shiftSize, vector<int>( input.scenario.skillSize ) ) );
-        weekdata.shiftOffs = vector< vector< vector<bool> > >( NurseRostering::Weekday::SIZE,
-            vector< vector<bool> >( input.scenario.shiftSize, vector<bool>( input.scenario.nurseNum, false ) ) );
+            vector< vector<int> >( input.scenario->shiftSize, vector<int>( input.scenario->skillSize ) ) );
+        weekdata.shiftOffs = vector<NurseRostering::ShiftMask>( input.scenario->nurseNum * NurseRostering::Weekday::SIZE, 0 );
         char c;
         char buf[MAX_BUF_SIZE];
         ifstream ifs( weekDataFileName );
@@ -363,8 +638,8 @@ namespace INRC2
             if (skillName == "=") {         // SHIFT_OFF_REQUESTS =
                 break;
             }
-            NurseRostering::ShiftID shift = input.names.shiftMap[shiftName];
-            NurseRostering::SkillID skill = input.names.skillMap[skillName];
+            NurseRostering::ShiftID shift = NurseRostering::Names::getID( input.names->shiftMap, shiftName );
+            NurseRostering::SkillID skill = NurseRostering::Names::getID( input.names->skillMap, skillName );
             for (int weekday = NurseRostering::Weekday::Mon;
                 weekday <= NurseRostering::Weekday::Sun; ++weekday) {
                 ifs >> c >> weekdata.minNurseNums[weekday][shift][skill]
@@ -378,15 +653,15 @@ namespace INRC2
             string nurseName, shiftName, weekdayName;
             ifs >> nurseName >> shiftName >> weekdayName;
             int weekday = weekdayMap.at( weekdayName );
-            NurseRostering::ShiftID shift = input.names.shiftMap[shiftName];
-            NurseRostering::NurseID nurse = input.names.nurseMap[nurseName];
+            NurseRostering::ShiftID shift = NurseRostering::Names::getID( input.names->shiftMap, shiftName );
+            NurseRostering::NurseID nurse = NurseRostering::Names::getID( input.names->nurseMap, nurseName );
             if (shift == NurseRostering::Scenario::Shift::ID_ANY) {
                 for (int s = NurseRostering::Scenario::Shift::ID_BEGIN;
-                    s < input.scenario.shiftSize; ++s) {
-                    weekdata.shiftOffs[weekday][s][nurse] = true;
+                    s < input.scenario->shiftSize; ++s) {
+                    weekdata.addShiftOff( nurse, weekday, s );
                 }
             } else {
-                weekdata.shiftOffs[weekday][shift][nurse] = true;
+                weekdata.addShiftOff( nurse, weekday, shift );
             }
         }
 
@@ -394,58 +669,847 @@ namespace INRC2
         return true;
     }
 
+    // build a NameTable from the name map of a scenario
+    template <typename T>
+    NameTable genNameTable( const std::map<std::string, T> &nameMap )
+    {
+        NameTable table( static_cast<int>(nameMap.size()) );
+        for (typename std::map<std::string, T>::const_iterator iter = nameMap.begin();
+            iter != nameMap.end(); ++iter) {
+            table.insert( iter->first, iter->second );
+        }
+        return table;
+    }
+
+    std::shared_ptr<const NurseRostering::NameTables> genNameTables( const NurseRostering::Names &names )
+    {
+        std::shared_ptr<NurseRostering::NameTables> tables( new NurseRostering::NameTables() );
+        tables->nurseTable = genNameTable( names.nurseMap );
+        tables->shiftTable = genNameTable( names.shiftMap );
+        tables->skillTable = genNameTable( names.skillMap );
+        return tables;
+    }
+
+    // look up the next token in table, log and return false if it is not found
+    bool nextID( TextTokenizer &tokenizer, const NameTable &table, int &id, const std::string &fileName )
+    {
+        const char *name = tokenizer.next();
+        if ((name == NULL) || !table.find( name, id )) {
+            errorLog( "unknown name " + string( (name == NULL) ? "" : name ) + " in file : " + fileName );
+            return false;
+        }
+        return true;
+    }
+
+    bool parseScenario_Fast( const std::string &scenarioFileName, NurseRostering &input )
+    {
+        string bundleFileName, recordName;
+        if (isBundleRecord( scenarioFileName, bundleFileName, recordName )) {
+            return parseScenario_Bundle( scenarioFileName, input );
+        }
+
+        // parse into new ones, for the old ones may be shared with other inputs
+        std::shared_ptr<NurseRostering::Scenario> parsedScenario( new NurseRostering::Scenario() );
+        std::shared_ptr<NurseRostering::Names> parsedNames( new NurseRostering::Names() );
+        NurseRostering::Scenario &scenario( *parsedScenario );
+        NurseRostering::Names &names( *parsedNames );
+        TextTokenizer tokenizer( "(),=" );
+
+        if (!tokenizer.load( scenarioFileName )) {
+            errorLog( "fail to open scenario file : " + scenarioFileName );
+            return false;
+        }
+
+        tokenizer.skip( 1 );                    // SCENARIO =
+        names.scenarioName = tokenizer.next();  //  nXXXwX
+
+        tokenizer.skip( 1 );                    // WEEKS =
+        scenario.totalWeekNum = tokenizer.nextInt();
+        scenario.maxWeekCount = scenario.totalWeekNum - 1;
+
+        tokenizer.skip( 1 );                    // SKILLS =
+        scenario.skillTypeNum = tokenizer.nextInt();
+        scenario.skillSize = scenario.skillTypeNum + NurseRostering::Scenario::Skill::ID_BEGIN;
+        NameTable skillTable( scenario.skillSize );
+        names.skillNames.resize( scenario.skillSize );
+        for (NurseRostering::SkillID i = NurseRostering::Scenario::Skill::ID_BEGIN; i < scenario.skillSize; ++i) {
+            names.skillNames[i] = tokenizer.next();
+            names.skillMap[names.skillNames[i]] = i;
+            skillTable.insert( names.skillNames[i], i );
+        }
+
+        tokenizer.skip( 1 );                    // SHIFT_TYPES =
+        scenario.shiftTypeNum = tokenizer.nextInt();
+        scenario.shiftSize = scenario.shiftTypeNum + NurseRostering::Scenario::Shift::ID_BEGIN;
+        scenario.shifts.resize( scenario.shiftSize );
+        names.shiftNames.resize( scenario.shiftSize );
+        for (NurseRostering::ShiftID i = NurseRostering::Scenario::Shift::ID_BEGIN; i < scenario.shiftSize; ++i) {
+            NurseRostering::Scenario::Shift &shift = scenario.shifts[i];
+            names.shiftNames[i] = tokenizer.next();             // name (
+            shift.minConsecutiveShiftNum = tokenizer.nextInt(); // XX,
+            shift.maxConsecutiveShiftNum = tokenizer.nextInt(); // XX)
+            names.shiftMap[names.shiftNames[i]] = i;
+        }
+        NameTable shiftTable( genNameTable( names.shiftMap ) );
+
+        tokenizer.skip( 1 );                    // FORBIDDEN_SHIFT_TYPES_SUCCESSIONS
+        scenario.shifts[NurseRostering::Scenario::Shift::ID_NONE].legalNextShifts = ~0U;
+        scenario.shifts[NurseRostering::Scenario::Shift::ID_NONE].illegalNextShiftNum = 0;
+        for (int i = NurseRostering::Scenario::Shift::ID_BEGIN; i < scenario.shiftSize; ++i) {
+            NurseRostering::ShiftID shiftID;
+            if (!nextID( tokenizer, shiftTable, shiftID, scenarioFileName )) {
+                return false;
+            }
+            NurseRostering::Scenario::Shift &shift = scenario.shifts[shiftID];
+            shift.illegalNextShiftNum = tokenizer.nextInt();
+            shift.legalNextShifts = ~0U;
+            for (int j = 0; j < shift.illegalNextShiftNum; ++j) {
+                NurseRostering::ShiftID nextShift;
+                if (!nextID( tokenizer, shiftTable, nextShift, scenarioFileName )) {
+                    return false;
+                }
+                shift.legalNextShifts &= ~(1U << nextShift);
+            }
+        }
+
+        tokenizer.skip( 1 );                    // CONTRACTS =
+        int contractNum = tokenizer.nextInt();
+        scenario.contracts.resize( contractNum );
+        names.contractNames.resize( contractNum );
+        NameTable contractTable( contractNum );
+        for (NurseRostering::ContractID i = 0; i < contractNum; ++i) {
+            NurseRostering::Scenario::Contract &contract = scenario.contracts[i];
+            names.contractNames[i] = tokenizer.next();              // name (
+            contract.minShiftNum = tokenizer.nextInt();             // XX,
+            contract.maxShiftNum = tokenizer.nextInt();             // XX) (
+            contract.minConsecutiveDayNum = tokenizer.nextInt();    // XX,
+            contract.maxConsecutiveDayNum = tokenizer.nextInt();    // XX) (
+            contract.minConsecutiveDayoffNum = tokenizer.nextInt(); // XX,
+            contract.maxConsecutiveDayoffNum = tokenizer.nextInt(); // XX)
+            contract.maxWorkingWeekendNum = tokenizer.nextInt();
+            contract.completeWeekend = (tokenizer.nextInt() != 0);
+            names.contractMap[names.contractNames[i]] = i;
+            contractTable.insert( names.contractNames[i], i );
+        }
+
+        tokenizer.skip( 1 );                    // NURSES =
+        scenario.nurseNum = tokenizer.nextInt();
+        scenario.nurses.resize( scenario.nurseNum );
+        names.nurseNames.resize( scenario.nurseNum );
+        for (NurseRostering::NurseID i = 0; i < scenario.nurseNum; ++i) {
+            NurseRostering::Scenario::Nurse &nurse = scenario.nurses[i];
+            names.nurseNames[i] = tokenizer.next();
+            names.nurseMap[names.nurseNames[i]] = i;
+            if (!nextID( tokenizer, contractTable, nurse.contract, scenarioFileName )) {
+                return false;
+            }
+            scenario.contracts[nurse.contract].nurses.push_back( i );
+            nurse.skillNum = tokenizer.nextInt();
+            nurse.skills = 0;
+            for (int j = 0; j < nurse.skillNum; ++j) {
+                NurseRostering::SkillID skill;
+                if (!nextID( tokenizer, skillTable, skill, scenarioFileName )) {
+                    return false;
+                }
+                nurse.skills |= (1U << skill);
+            }
+        }
+
+        input.scenario = parsedScenario;
+        input.names = parsedNames;
+        return true;
+    }
+
+    bool readHistory_Fast( const std::string &historyFileName, NurseRostering &input )
+    {
+        string bundleFileName, recordName;
+        if (isBundleRecord( historyFileName, bundleFileName, recordName )) {
+            return readHistory_Bundle( historyFileName, input );
+        }
+
+        NurseRostering::History &history = input.history;
+        TextTokenizer tokenizer;
+
+        if (!tokenizer.load( historyFileName )) {
+            errorLog( "fail to open history file : " + historyFileName );
+            return false;
+        }
+
+        history.accObjValue = 0;
+        tokenizer.skip( 1 );                    // HISTORY
+        history.pastWeekCount = tokenizer.nextInt();    // X
+        history.currentWeek = history.pastWeekCount + 1;
+        history.restWeekCount = input.scenario->totalWeekNum - history.pastWeekCount;
+        tokenizer.skip( 2 );                    //  nXXXwX NURSE_HISTORY
+
+        history.totalAssignNums.resize( input.scenario->nurseNum );
+        history.totalWorkingWeekendNums.resize( input.scenario->nurseNum );
+        history.lastShifts.resize( input.scenario->nurseNum );
+        history.consecutiveShiftNums.resize( input.scenario->nurseNum );
+        history.consecutiveDayNums.resize( input.scenario->nurseNum );
+        history.consecutiveDayoffNums.resize( input.scenario->nurseNum );
+        std::shared_ptr<const NurseRostering::NameTables> nameTables( (input.nameTables != NULL)
+            ? input.nameTables : genNameTables( *input.names ) );
+        const NameTable &nurseTable( nameTables->nurseTable );
+        const NameTable &shiftTable( nameTables->shiftTable );
+        for (int i = 0; i < input.scenario->nurseNum; ++i) {
+            NurseRostering::NurseID nurse;
+            if (!nextID( tokenizer, nurseTable, nurse, historyFileName )) {
+                return false;
+            }
+            history.totalAssignNums[nurse] = tokenizer.nextInt();
+            history.totalWorkingWeekendNums[nurse] = tokenizer.nextInt();
+            if (!nextID( tokenizer, shiftTable, history.lastShifts[nurse], historyFileName )) {
+                return false;
+            }
+            history.consecutiveShiftNums[nurse] = tokenizer.nextInt();
+            history.consecutiveDayNums[nurse] = tokenizer.nextInt();
+            history.consecutiveDayoffNums[nurse] = tokenizer.nextInt();
+            if (history.pastWeekCount == 0) {   // clear total assign if it is the first week
+                history.totalAssignNums[nurse] = 0;
+                history.totalWorkingWeekendNums[nurse] = 0;
+            }
+        }
+
+        return true;
+    }
+
+    bool readWeekData_Fast( const std::string &weekDataFileName, NurseRostering &input )
+    {
+        static const string SHIFT_OFF_REQUESTS( "SHIFT_OFF_REQUESTS" );
+
+        string bundleFileName, recordName;
+        if (isBundleRecord( weekDataFileName, bundleFileName, recordName )) {
+            return readWeekData_Bundle( weekDataFileName, input );
+        }
+
+        NurseRostering::WeekData &weekdata = input.weekData;
+        weekdata.minNurseNums = vector< vector< vector<int> > >( NurseRostering::Weekday::SIZE,
+            vector< vector<int> >( input.scenario->shiftSize, vector<int>( input.scenario->skillSize ) ) );
+        weekdata.optNurseNums = vector< vector< vector<int> > >( NurseRostering::Weekday::SIZE,
+            vector< vector<int> >( input.scenario->shiftSize, vector<int>( input.scenario->skillSize ) ) );
+        weekdata.shiftOffs = vector<NurseRostering::ShiftMask>( input.scenario->nurseNum * NurseRostering::Weekday::SIZE, 0 );
+        TextTokenizer tokenizer( "(),=" );
+
+        if (!tokenizer.load( weekDataFileName )) {
+            errorLog( "fail to open weekdata file : " + weekDataFileName );
+            return false;
+        }
+
+        tokenizer.skip( 3 );                    // WEEK_DATA nXXXwX REQUIREMENTS
+
+        std::shared_ptr<const NurseRostering::NameTables> nameTables( (input.nameTables != NULL)
+            ? input.nameTables : genNameTables( *input.names ) );
+        const NameTable &shiftTable( nameTables->shiftTable );
+        const NameTable &skillTable( nameTables->skillTable );
+        while (true) {
+            const char *shiftName = tokenizer.next();
+            if ((shiftName == NULL) || (SHIFT_OFF_REQUESTS == shiftName)) {    // SHIFT_OFF_REQUESTS =
+                break;
+            }
+            NurseRostering::ShiftID shift;
+            NurseRostering::SkillID skill;
+            if (!shiftTable.find( shiftName, shift )) {
+                errorLog( "unknown name " + string( shiftName ) + " in file : " + weekDataFileName );
+                return false;
+            }
+            if (!nextID( tokenizer, skillTable, skill, weekDataFileName )) {
+                return false;
+            }
+            for (int weekday = NurseRostering::Weekday::Mon;
+                weekday <= NurseRostering::Weekday::Sun; ++weekday) {
+                weekdata.minNurseNums[weekday][shift][skill] = tokenizer.nextInt();
+                weekdata.optNurseNums[weekday][shift][skill] = tokenizer.nextInt();
+            }
+        }
+
+        int shiftOffNum = tokenizer.nextInt();
+        const NameTable &nurseTable( nameTables->nurseTable );
+        static const NameTable weekdayTable( genNameTable( weekdayMap ) );
+        for (int i = 0; i < shiftOffNum; ++i) {
+            NurseRostering::NurseID nurse;
+            NurseRostering::ShiftID shift;
+            int weekday;
+            if (!(nextID( tokenizer, nurseTable, nurse, weekDataFileName )
+                && nextID( tokenizer, shiftTable, shift, weekDataFileName )
+                && nextID( tokenizer, weekdayTable, weekday, weekDataFileName ))) {
+                return false;
+            }
+            if (shift == NurseRostering::Scenario::Shift::ID_ANY) {
+                for (int s = NurseRostering::Scenario::Shift::ID_BEGIN;
+                    s < input.scenario->shiftSize; ++s) {
+                    weekdata.addShiftOff( nurse, weekday, s );
+                }
+            } else {
+                weekdata.addShiftOff( nurse, weekday, shift );
+            }
+        }
+
+        return true;
+    }
+
+    enum BundleRecordType { ScenarioRecord, HistoryRecord, WeekDataRecord };
+    enum BundleHeader { Magic, Version, RecordNum, HeaderSize };
+    enum BundleEntry { Type, NameOffset, NameLength, DataOffset, DataSize, EntrySize };
+
+    // append string as its length and chars padded to int
+    void appendBundleString( std::vector<int> &data, const std::string &str )
+    {
+        data.push_back( static_cast<int>(str.size()) );
+        size_t offset = data.size();
+        data.resize( offset + (str.size() + sizeof( int ) - 1) / sizeof( int ), 0 );
+        if (!str.empty()) {
+            memcpy( &data[offset], str.data(), str.size() );
+        }
+    }
+
+    void appendBundleArray( std::vector<int> &data, const std::vector<int> &arr )
+    {
+        data.insert( data.end(), arr.begin(), arr.end() );
+    }
+
+    // sequential reader on the ints in a record, which keeps failing
+    // once it runs out of the record
+    class BundleCursor
+    {
+    public:
+        BundleCursor( const int *data, int size ) : cur( data ), end( data + size ) {}
+
+        bool isValid() const { return (cur != NULL); }
+
+        int next()
+        {
+            if ((cur == NULL) || (cur >= end)) {
+                cur = NULL;
+                return 0;
+            }
+            return *(cur++);
+        }
+
+        std::string nextString()
+        {
+            int length = next();
+            int intNum = static_cast<int>((length + sizeof( int ) - 1) / sizeof( int ));
+            if ((cur == NULL) || (length < 0) || (end - cur < intNum)) {
+                cur = NULL;
+                return string();
+            }
+            string str( reinterpret_cast<const char *>(cur), length );
+            cur += intNum;
+            return str;
+        }
+
+        // the array is copied into arr
+        template <typename T>
+        void nextArray( T *arr, int size )
+        {
+            if ((cur == NULL) || (size < 0) || (end - cur < size)) {
+                cur = NULL;
+                return;
+            }
+            copy( cur, cur + size, arr );
+            cur += size;
+        }
+
+    private:
+        const int *cur; // NULL if it has failed
+        const int *end;
+    };
+
+    bool writeBundle( const std::string &bundleFileName, const std::string &scenarioFileName,
+        const std::vector<std::string> &historyFileNames, const std::vector<std::string> &weekDataFileNames )
+    {
+        vector<int> types;
+        vector<string> names;
+        vector< vector<int> > records;
+
+        NurseRostering input;
+        if (!parseScenario_Fast( scenarioFileName, input )) {
+            return false;
+        }
+        const NurseRostering::Scenario &scenario( *input.scenario );
+        const int contractNum = static_cast<int>(scenario.contracts.size());
+        types.push_back( BundleRecordType::ScenarioRecord );
+        names.push_back( scenarioFileName );
+        records.push_back( vector<int>() );
+        vector<int> &sce( records.back() );
+        sce.push_back( scenario.totalWeekNum );
+        sce.push_back( scenario.skillTypeNum );
+        sce.push_back( scenario.shiftTypeNum );
+        sce.push_back( contractNum );
+        sce.push_back( scenario.nurseNum );
+        appendBundleString( sce, input.names->scenarioName );
+        for (NurseRostering::SkillID i = NurseRostering::Scenario::Skill::ID_BEGIN; i < scenario.skillSize; ++i) {
+            appendBundleString( sce, input.names->skillNames[i] );
+        }
+        for (NurseRostering::ShiftID i = NurseRostering::Scenario::Shift::ID_BEGIN; i < scenario.shiftSize; ++i) {
+            appendBundleString( sce, input.names->shiftNames[i] );
+        }
+        for (NurseRostering::ContractID i = 0; i < contractNum; ++i) {
+            appendBundleString( sce, input.names->contractNames[i] );
+        }
+        for (NurseRostering::NurseID i = 0; i < scenario.nurseNum; ++i) {
+            appendBundleString( sce, input.names->nurseNames[i] );
+        }
+        for (NurseRostering::ShiftID i = NurseRostering::Scenario::Shift::ID_BEGIN; i < scenario.shiftSize; ++i) {
+            const NurseRostering::Scenario::Shift &shift( scenario.shifts[i] );
+            sce.push_back( shift.minConsecutiveShiftNum );
+            sce.push_back( shift.maxConsecutiveShiftNum );
+            sce.push_back( static_cast<int>(shift.legalNextShifts) );
+            sce.push_back( shift.illegalNextShiftNum );
+        }
+        for (NurseRostering::ContractID i = 0; i < contractNum; ++i) {
+            const NurseRostering::Scenario::Contract &contract( scenario.contracts[i] );
+            sce.push_back( contract.minShiftNum );
+            sce.push_back( contract.maxShiftNum );
+            sce.push_back( contract.minConsecutiveDayNum );
+            sce.push_back( contract.maxConsecutiveDayNum );
+            sce.push_back( contract.minConsecutiveDayoffNum );
+            sce.push_back( contract.maxConsecutiveDayoffNum );
+            sce.push_back( contract.maxWorkingWeekendNum );
+            sce.push_back( contract.completeWeekend );
+        }
+        for (NurseRostering::NurseID i = 0; i < scenario.nurseNum; ++i) {
+            const NurseRostering::Scenario::Nurse &nurse( scenario.nurses[i] );
+            sce.push_back( nurse.contract );
+            sce.push_back( nurse.skillNum );
+            sce.push_back( static_cast<int>(nurse.skills) );
+        }
+
+        for (unsigned i = 0; i < historyFileNames.size(); ++i) {
+            if (!readHistory_Fast( historyFileNames[i], input )) {
+                return false;
+            }
+            const NurseRostering::History &history( input.history );
+            types.push_back( BundleRecordType::HistoryRecord );
+            names.push_back( historyFileNames[i] );
+            records.push_back( vector<int>() );
+            vector<int> &his( records.back() );
+            his.push_back( history.pastWeekCount );
+            appendBundleArray( his, history.totalAssignNums );
+            appendBundleArray( his, history.totalWorkingWeekendNums );
+            appendBundleArray( his, history.lastShifts );
+            appendBundleArray( his, history.consecutiveShiftNums );
+            appendBundleArray( his, history.consecutiveDayNums );
+            appendBundleArray( his, history.consecutiveDayoffNums );
+        }
+
+        for (unsigned i = 0; i < weekDataFileNames.size(); ++i) {
+            if (!readWeekData_Fast( weekDataFileNames[i], input )) {
+                return false;
+            }
+            const NurseRostering::WeekData &weekdata( input.weekData );
+            types.push_back( BundleRecordType::WeekDataRecord );
+            names.push_back( weekDataFileNames[i] );
+            records.push_back( vector<int>() );
+            vector<int> &week( records.back() );
+            for (int weekday = 0; weekday < NurseRostering::Weekday::SIZE; ++weekday) {
+                for (NurseRostering::ShiftID shift = 0; shift < scenario.shiftSize; ++shift) {
+                    appendBundleArray( week, weekdata.minNurseNums[weekday][shift] );
+                }
+            }
+            for (int weekday = 0; weekday < NurseRostering::Weekday::SIZE; ++weekday) {
+                for (NurseRostering::ShiftID shift = 0; shift < scenario.shiftSize; ++shift) {
+                    appendBundleArray( week, weekdata.optNurseNums[weekday][shift] );
+                }
+            }
+            week.insert( week.end(), weekdata.shiftOffs.begin(), weekdata.shiftOffs.end() );
+        }
+
+        const int recordNum = static_cast<int>(records.size());
+        vector<int> bundle( BundleHeader::HeaderSize + recordNum * BundleEntry::EntrySize );
+        bundle[BundleHeader::Magic] = BUNDLE_MAGIC;
+        bundle[BundleHeader::Version] = BUNDLE_VERSION;
+        bundle[BundleHeader::RecordNum] = recordNum;
+        for (int i = 0; i < recordNum; ++i) {
+            string recordName( names[i].substr( names[i].find_last_of( "/\\" ) + 1 ) );
+            int *entry = &bundle[BundleHeader::HeaderSize + i * BundleEntry::EntrySize];
+            entry[BundleEntry::Type] = types[i];
+            entry[BundleEntry::NameLength] = static_cast<int>(recordName.size());
+            entry[BundleEntry::NameOffset] = static_cast<int>(bundle.size()) + 1;
+            appendBundleString( bundle, recordName );
+            entry = &bundle[BundleHeader::HeaderSize + i * BundleEntry::EntrySize];
+            entry[BundleEntry::DataOffset] = static_cast<int>(bundle.size());
+            entry[BundleEntry::DataSize] = static_cast<int>(records[i].size());
+            appendBundleArray( bundle, records[i] );
+        }
+
+        ofstream ofs( bundleFileName, ios::binary );
+        if (!ofs.is_open()) {
+            errorLog( "fail to open bundle file : " + bundleFileName );
+            return false;
+        }
+        ofs.write( reinterpret_cast<const char *>(bundle.data()), bundle.size() * sizeof( int ) );
+        ofs.close();
+        return true;
+    }
+
+    bool isBundleRecord( const std::string &fileName, std::string &bundleFileName, std::string &recordName )
+    {
+        size_t separatorIndex = fileName.find_last_of( BUNDLE_RECORD_SEPARATOR );
+        if (separatorIndex == string::npos) {
+            return false;
+        }
+        // an existing file or a path without bundle file before
+        // the separator is an ordinary file which has '#' in its path
+        struct stat fileStat;
+        if (stat( fileName.c_str(), &fileStat ) == 0) {
+            return false;
+        }
+        string bundlePath( fileName.substr( 0, separatorIndex ) );
+        if ((stat( bundlePath.c_str(), &fileStat ) != 0)
+            || ((fileStat.st_mode & S_IFMT) != S_IFREG)) {
+            return false;
+        }
+        // records are named by file name without directory
+        size_t recordNameIndex = fileName.find_last_of( "/\\" );
+        recordNameIndex = ((recordNameIndex == string::npos) || (recordNameIndex < separatorIndex))
+            ? (separatorIndex + 1) : (recordNameIndex + 1);
+        bundleFileName = bundlePath;
+        recordName = fileName.substr( recordNameIndex );
+        return true;
+    }
+
+    std::string getShortFileName( const std::string &fileName )
+    {
+        string bundleFileName, recordName;
+        if (isBundleRecord( fileName, bundleFileName, recordName )) {
+            return recordName;
+        }
+        return fileName.substr( fileName.find_last_of( "/\\" ) + 1 );
+    }
+
+    std::shared_ptr<const MappedFile> loadBundle( const std::string &bundleFileName )
+    {
+        struct CacheItem
+        {
+            // a file is reloaded if either of them changes
+            time_t modifyTime;
+            long long fileSize;
+            std::shared_ptr<const MappedFile> bundle;
+        };
+
+        static mutex cacheMutex;
+        static map<string, CacheItem> cache;
+
+        struct stat fileStat;
+        if (stat( bundleFileName.c_str(), &fileStat ) != 0) {
+            errorLog( "fail to open bundle file : " + bundleFileName );
+            return std::shared_ptr<const MappedFile>();
+        }
+
+        // different paths to the same file share the cache item
+        string key( getCanonicalPath( bundleFileName ) );
+        lock_guard<mutex> lock( cacheMutex );
+        map<string, CacheItem>::iterator iter = cache.find( key );
+        if ((iter != cache.end()) && (iter->second.modifyTime == fileStat.st_mtime)
+            && (iter->second.fileSize == fileStat.st_size)) {
+            return iter->second.bundle;
+        }
+
+        std::shared_ptr<MappedFile> bundle( new MappedFile() );
+        if (!bundle->open( bundleFileName )) {
+            errorLog( "fail to open bundle file : " + bundleFileName );
+            return std::shared_ptr<const MappedFile>();
+        }
+        const int *header = reinterpret_cast<const int *>(bundle->data());
+        int intNum = static_cast<int>(bundle->size() / sizeof( int ));
+        if ((intNum < BundleHeader::HeaderSize)
+            || (header[BundleHeader::Magic] != BUNDLE_MAGIC)
+            || (header[BundleHeader::Version] != BUNDLE_VERSION)
+            || (header[BundleHeader::RecordNum] < 0)
+            || ((intNum - BundleHeader::HeaderSize) / BundleEntry::EntrySize < header[BundleHeader::RecordNum])) {
+            errorLog( "invalid bundle file : " + bundleFileName );
+            return std::shared_ptr<const MappedFile>();
+        }
+
+        CacheItem &item( cache[key] );
+        item.modifyTime = fileStat.st_mtime;
+        item.fileSize = fileStat.st_size;
+        item.bundle = bundle;
+        return bundle;
+    }
+
+    // find the record referred by fileName, the bundle is kept alive by
+    // the returned pointer while the cursor is in use
+    std::shared_ptr<const MappedFile> findBundleRecord( const std::string &fileName,
+        BundleRecordType type, BundleCursor &cursor )
+    {
+        string bundleFileName, recordName;
+        isBundleRecord( fileName, bundleFileName, recordName );
+        std::shared_ptr<const MappedFile> bundle( loadBundle( bundleFileName ) );
+        if (bundle == NULL) {
+            return bundle;
+        }
+
+        const int *data = reinterpret_cast<const int *>(bundle->data());
+        int intNum = static_cast<int>(bundle->size() / sizeof( int ));
+        for (int i = 0; i < data[BundleHeader::RecordNum]; ++i) {
+            const int *entry = data + BundleHeader::HeaderSize + i * BundleEntry::EntrySize;
+            if ((entry[BundleEntry::Type] != type)
+                || (entry[BundleEntry::NameLength] != static_cast<int>(recordName.size()))
+                || (entry[BundleEntry::NameOffset] < 0)
+                || (entry[BundleEntry::NameOffset] * sizeof( int ) + recordName.size() > bundle->size())
+                || (recordName.compare( 0, string::npos,
+                reinterpret_cast<const char *>(data + entry[BundleEntry::NameOffset]), recordName.size() ) != 0)) {
+                continue;
+            }
+            if ((entry[BundleEntry::DataOffset] < 0) || (entry[BundleEntry::DataSize] < 0)
+                || (intNum - entry[BundleEntry::DataOffset] < entry[BundleEntry::DataSize])) {
+                break;
+            }
+            cursor = BundleCursor( data + entry[BundleEntry::DataOffset], entry[BundleEntry::DataSize] );
+            return bundle;
+        }
+
+        errorLog( "no valid record " + recordName + " in bundle file : " + bundleFileName );
+        return std::shared_ptr<const MappedFile>();
+    }
+
+    bool parseScenario_Bundle( const std::string &scenarioFileName, NurseRostering &input )
+    {
+        BundleCursor cursor( NULL, 0 );
+        std::shared_ptr<const MappedFile> bundle(
+            findBundleRecord( scenarioFileName, BundleRecordType::ScenarioRecord, cursor ) );
+        if (bundle == NULL) {
+            return false;
+        }
+
+        // parse into new ones, for the old ones may be shared with other inputs
+        std::shared_ptr<NurseRostering::Scenario> parsedScenario( new NurseRostering::Scenario() );
+        std::shared_ptr<NurseRostering::Names> parsedNames( new NurseRostering::Names() );
+        NurseRostering::Scenario &scenario( *parsedScenario );
+        NurseRostering::Names &names( *parsedNames );
+        scenario.totalWeekNum = cursor.next();
+        scenario.maxWeekCount = scenario.totalWeekNum - 1;
+        scenario.skillTypeNum = cursor.next();
+        scenario.skillSize = scenario.skillTypeNum + NurseRostering::Scenario::Skill::ID_BEGIN;
+        scenario.shiftTypeNum = cursor.next();
+        scenario.shiftSize = scenario.shiftTypeNum + NurseRostering::Scenario::Shift::ID_BEGIN;
+        int contractNum = cursor.next();
+        scenario.nurseNum = cursor.next();
+        if (!cursor.isValid() || (scenario.skillTypeNum < 0) || (scenario.shiftTypeNum < 0)
+            || (contractNum < 0) || (scenario.nurseNum < 0)) {
+            errorLog( "invalid scenario in bundle : " + scenarioFileName );
+            return false;
+        }
+
+        names.scenarioName = cursor.nextString();
+        names.skillNames.resize( scenario.skillSize );
+        for (NurseRostering::SkillID i = NurseRostering::Scenario::Skill::ID_BEGIN; i < scenario.skillSize; ++i) {
+            names.skillNames[i] = cursor.nextString();
+            names.skillMap[names.skillNames[i]] = i;
+        }
+        names.shiftNames.resize( scenario.shiftSize );
+        for (NurseRostering::ShiftID i = NurseRostering::Scenario::Shift::ID_BEGIN; i < scenario.shiftSize; ++i) {
+            names.shiftNames[i] = cursor.nextString();
+            names.shiftMap[names.shiftNames[i]] = i;
+        }
+        names.contractNames.resize( contractNum );
+        for (NurseRostering::ContractID i = 0; i < contractNum; ++i) {
+            names.contractNames[i] = cursor.nextString();
+            names.contractMap[names.contractNames[i]] = i;
+        }
+        names.nurseNames.resize( scenario.nurseNum );
+        for (NurseRostering::NurseID i = 0; i < scenario.nurseNum; ++i) {
+            names.nurseNames[i] = cursor.nextString();
+            names.nurseMap[names.nurseNames[i]] = i;
+        }
+
+        scenario.shifts.resize( scenario.shiftSize );
+        scenario.shifts[NurseRostering::Scenario::Shift::ID_NONE].legalNextShifts = ~0U;
+        scenario.shifts[NurseRostering::Scenario::Shift::ID_NONE].illegalNextShiftNum = 0;
+        for (NurseRostering::ShiftID i = NurseRostering::Scenario::Shift::ID_BEGIN; i < scenario.shiftSize; ++i) {
+            NurseRostering::Scenario::Shift &shift = scenario.shifts[i];
+            shift.minConsecutiveShiftNum = cursor.next();
+            shift.maxConsecutiveShiftNum = cursor.next();
+            shift.legalNextShifts = static_cast<NurseRostering::ShiftMask>(cursor.next());
+            shift.illegalNextShiftNum = cursor.next();
+        }
+        scenario.contracts.resize( contractNum );
+        for (NurseRostering::ContractID i = 0; i < contractNum; ++i) {
+            NurseRostering::Scenario::Contract &contract = scenario.contracts[i];
+            contract.minShiftNum = cursor.next();
+            contract.maxShiftNum = cursor.next();
+            contract.minConsecutiveDayNum = cursor.next();
+            contract.maxConsecutiveDayNum = cursor.next();
+            contract.minConsecutiveDayoffNum = cursor.next();
+            contract.maxConsecutiveDayoffNum = cursor.next();
+            contract.maxWorkingWeekendNum = cursor.next();
+            contract.completeWeekend = (cursor.next() != 0);
+        }
+        scenario.nurses.resize( scenario.nurseNum );
+        for (NurseRostering::NurseID i = 0; i < scenario.nurseNum; ++i) {
+            NurseRostering::Scenario::Nurse &nurse = scenario.nurses[i];
+            nurse.contract = cursor.next();
+            nurse.skillNum = cursor.next();
+            nurse.skills = static_cast<NurseRostering::SkillMask>(cursor.next());
+            if ((nurse.contract < 0) || (nurse.contract >= contractNum)) {
+                errorLog( "invalid scenario in bundle : " + scenarioFileName );
+                return false;
+            }
+            scenario.contracts[nurse.contract].nurses.push_back( i );
+        }
+
+        if (!cursor.isValid()) {
+            errorLog( "invalid scenario in bundle : " + scenarioFileName );
+            return false;
+        }
+        input.scenario = parsedScenario;
+        input.names = parsedNames;
+        return true;
+    }
+
+    bool readHistory_Bundle( const std::string &historyFileName, NurseRostering &input )
+    {
+        BundleCursor cursor( NULL, 0 );
+        std::shared_ptr<const MappedFile> bundle(
+            findBundleRecord( historyFileName, BundleRecordType::HistoryRecord, cursor ) );
+        if (bundle == NULL) {
+            return false;
+        }
+
+        NurseRostering::History &history = input.history;
+        const int nurseNum = input.scenario->nurseNum;
+        history.accObjValue = 0;
+        history.pastWeekCount = cursor.next();
+        history.currentWeek = history.pastWeekCount + 1;
+        history.restWeekCount = input.scenario->totalWeekNum - history.pastWeekCount;
+        history.totalAssignNums.resize( nurseNum );
+        history.totalWorkingWeekendNums.resize( nurseNum );
+        history.lastShifts.resize( nurseNum );
+        history.consecutiveShiftNums.resize( nurseNum );
+        history.consecutiveDayNums.resize( nurseNum );
+        history.consecutiveDayoffNums.resize( nurseNum );
+        cursor.nextArray( history.totalAssignNums.data(), nurseNum );
+        cursor.nextArray( history.totalWorkingWeekendNums.data(), nurseNum );
+        cursor.nextArray( history.lastShifts.data(), nurseNum );
+        cursor.nextArray( history.consecutiveShiftNums.data(), nurseNum );
+        cursor.nextArray( history.consecutiveDayNums.data(), nurseNum );
+        cursor.nextArray( history.consecutiveDayoffNums.data(), nurseNum );
+
+        if (!cursor.isValid()) {
+            errorLog( "invalid history in bundle : " + historyFileName );
+            return false;
+        }
+        return true;
+    }
+
+    bool readWeekData_Bundle( const std::string &weekDataFileName, NurseRostering &input )
+    {
+        BundleCursor cursor( NULL, 0 );
+        std::shared_ptr<const MappedFile> bundle(
+            findBundleRecord( weekDataFileName, BundleRecordType::WeekDataRecord, cursor ) );
+        if (bundle == NULL) {
+            return false;
+        }
+
+        NurseRostering::WeekData &weekdata = input.weekData;
+        const int shiftSize = input.scenario->shiftSize;
+        const int skillSize = input.scenario->skillSize;
+        weekdata.minNurseNums = vector< vector< vector<int> > >( NurseRostering::Weekday::SIZE,
+            vector< vector<int> >( shiftSize, vector<int>( skillSize ) ) );
+        weekdata.optNurseNums = vector< vector< vector<int> > >( NurseRostering::Weekday::SIZE,
+            vector< vector<int> >( shiftSize, vector<int>( skillSize ) ) );
+        weekdata.shiftOffs.resize( input.scenario->nurseNum * NurseRostering::Weekday::SIZE );
+        for (int weekday = 0; weekday < NurseRostering::Weekday::SIZE; ++weekday) {
+            for (NurseRostering::ShiftID shift = 0; shift < shiftSize; ++shift) {
+                cursor.nextArray( weekdata.minNurseNums[weekday][shift].data(), skillSize );
+            }
+        }
+        for (int weekday = 0; weekday < NurseRostering::Weekday::SIZE; ++weekday) {
+            for (NurseRostering::ShiftID shift = 0; shift < shiftSize; ++shift) {
+                cursor.nextArray( weekdata.optNurseNums[weekday][shift].data(), skillSize );
+            }
+        }
+        cursor.nextArray( weekdata.shiftOffs.data(), static_cast<int>(weekdata.shiftOffs.size()) );
+
+        if (!cursor.isValid()) {
+            errorLog( "invalid weekdata in bundle : " + weekDataFileName );
+            return false;
+        }
+        return true;
+    }
+
+    enum CustomHeader { CustomMagic, CustomVersion, CustomNurseNum, CustomFlags, CustomChecksum, CustomPayloadSize, CustomHeaderSize };
+    enum CustomFlag { HasLastWeekAssign = 1 };
+
+    // FNV-1a on each int
+    unsigned customChecksum( const int *data, int size )
+    {
+        unsigned h = 2166136261U;
+        for (int i = 0; i < size; ++i) {
+            h = (h ^ static_cast<unsigned>(data[i])) * 16777619U;
+        }
+        return h;
+    }
+
     bool readCustomInput( const std::string &customInputFileName, NurseRostering &input )
     {
         NurseRostering::History &history = input.history;
-        ifstream ifs( customInputFileName, ios::binary );
+        MappedFile file;
 
-        if (!ifs.is_open()) {
-            errorLog( "fail to open custom input file." );
+        if (!file.open( customInputFileName )) {
+            errorLog( "fail to open custom input file : " + customInputFileName );
             return false;
         }
 
-        const int nurseNum = input.scenario.nurseNum;
-        int *totalAssignNums = new int[nurseNum];
-        int *totalWorkingWeekendNums = new int[nurseNum];
-        NurseRostering::ShiftID *lastShifts = new NurseRostering::ShiftID[nurseNum];
-        int *consecutiveShiftNums = new int[nurseNum];
-        int *consecutiveDayNums = new int[nurseNum];
-        int *consecutiveDayoffNums = new int[nurseNum];
+        const int nurseNum = input.scenario->nurseNum;
+        const int *header = reinterpret_cast<const int *>(file.data());
+        const int intNum = static_cast<int>(file.size() / sizeof( int ));
+        if ((intNum < CustomHeader::CustomHeaderSize)
+            || (header[CustomHeader::CustomMagic] != CUSTOM_MAGIC)
+            || (header[CustomHeader::CustomVersion] != CUSTOM_VERSION)) {
+            errorLog( "unknown custom input format : " + customInputFileName );
+            return false;
+        }
+        const int *payload = header + CustomHeader::CustomHeaderSize;
+        const int payloadSize = header[CustomHeader::CustomPayloadSize];
+        const bool hasLastWeekAssign = ((header[CustomHeader::CustomFlags] & CustomFlag::HasLastWeekAssign) != 0);
+        const int expectedSize = 2 + 6 * nurseNum
+            + (hasLastWeekAssign ? (2 * nurseNum * NurseRostering::Weekday::NUM) : 0);
+        if ((header[CustomHeader::CustomNurseNum] != nurseNum)
+            || (payloadSize != expectedSize)
+            || (intNum - CustomHeader::CustomHeaderSize < payloadSize)
+            || (static_cast<unsigned>(header[CustomHeader::CustomChecksum]) != customChecksum( payload, payloadSize ))) {
+            errorLog( "corrupted custom input file : " + customInputFileName );
+            return false;
+        }
 
-        ifs.read( reinterpret_cast<char *>(&history.accObjValue), sizeof( history.accObjValue ) );
-        ifs.read( reinterpret_cast<char *>(&history.pastWeekCount), sizeof( history.pastWeekCount ) );
+        history.accObjValue = *(payload++);
+        history.pastWeekCount = *(payload++);
         history.currentWeek = history.pastWeekCount + 1;
-        history.restWeekCount = input.scenario.totalWeekNum - history.pastWeekCount;
-        //ifs.read( reinterpret_cast<char *>(&history.currentWeek), sizeof( history.currentWeek ) );
-        //ifs.read( reinterpret_cast<char *>(&history.restWeekCount), sizeof( history.restWeekCount ) );
-        ifs.read( reinterpret_cast<char *>(totalAssignNums), nurseNum * sizeof( int ) );
-        ifs.read( reinterpret_cast<char *>(totalWorkingWeekendNums), nurseNum * sizeof( int ) );
-        ifs.read( reinterpret_cast<char *>(lastShifts), nurseNum * sizeof( NurseRostering::ShiftID ) );
-        ifs.read( reinterpret_cast<char *>(consecutiveShiftNums), nurseNum * sizeof( int ) );
-        ifs.read( reinterpret_cast<char *>(consecutiveDayNums), nurseNum * sizeof( int ) );
-        ifs.read( reinterpret_cast<char *>(consecutiveDayoffNums), nurseNum * sizeof( int ) );
-
-        history.totalAssignNums = vector<int>( totalAssignNums, totalAssignNums + nurseNum );
-        history.totalWorkingWeekendNums = vector<int>( totalWorkingWeekendNums, totalWorkingWeekendNums + nurseNum );
-        history.lastShifts = vector<int>( lastShifts, lastShifts + nurseNum );
-        history.consecutiveShiftNums = vector<int>( consecutiveShiftNums, consecutiveShiftNums + nurseNum );
-        history.consecutiveDayNums = vector<int>( consecutiveDayNums, consecutiveDayNums + nurseNum );
-        history.consecutiveDayoffNums = vector<int>( consecutiveDayoffNums, consecutiveDayoffNums + nurseNum );
-
-        delete[] totalAssignNums;
-        delete[] totalWorkingWeekendNums;
-        delete[] lastShifts;
-        delete[] consecutiveShiftNums;
-        delete[] consecutiveDayNums;
-        delete[] consecutiveDayoffNums;
+        history.restWeekCount = input.scenario->totalWeekNum - history.pastWeekCount;
+        history.totalAssignNums.assign( payload, payload + nurseNum );
+        payload += nurseNum;
+        history.totalWorkingWeekendNums.assign( payload, payload + nurseNum );
+        payload += nurseNum;
+        history.lastShifts.assign( payload, payload + nurseNum );
+        payload += nurseNum;
+        history.consecutiveShiftNums.assign( payload, payload + nurseNum );
+        payload += nurseNum;
+        history.consecutiveDayNums.assign( payload, payload + nurseNum );
+        payload += nurseNum;
+        history.consecutiveDayoffNums.assign( payload, payload + nurseNum );
+        payload += nurseNum;
+
+        input.lastWeekAssign = NurseRostering::AssignTable();
+        if (hasLastWeekAssign) {
+            input.lastWeekAssign = NurseRostering::AssignTable( nurseNum );
+            for (NurseRostering::NurseID nurse = 0; nurse < nurseNum; ++nurse) {
+                for (int weekday = NurseRostering::Weekday::Mon; weekday <= NurseRostering::Weekday::Sun; ++weekday) {
+                    input.lastWeekAssign[nurse][weekday] = NurseRostering::Assign( payload[0], payload[1] );
+                    payload += 2;
+                }
+            }
+        }
 
-        ifs.close();
         return true;
     }
 
     bool writeSolution( const std::string &solutionFileName, const NurseRostering::Solver &solver )
     {
-        const NurseRostering::Names &names( solver.problem.names );
+        const NurseRostering::Names &names( *solver.problem.names );
         const NurseRostering::AssignTable &assign( solver.getOptima().getAssignTable() );
         ofstream ofs( solutionFileName );
 
@@ -456,10 +1520,10 @@ namespace INRC2
 
         ofs << "SOLUTION" << endl;
         ofs << solver.problem.history.pastWeekCount << ' '
-            << solver.problem.names.scenarioName << endl << endl;
+            << solver.problem.names->scenarioName << endl << endl;
         int totalAssign = 0;
         ostringstream oss;
-        for (NurseRostering::NurseID nurse = 0; nurse < solver.problem.scenario.nurseNum; ++nurse) {
+        for (NurseRostering::NurseID nurse = 0; nurse < solver.problem.scenario->nurseNum; ++nurse) {
             for (int weekday = NurseRostering::Weekday::Mon; weekday <= NurseRostering::Weekday::Sun; ++weekday) {
                 if (assign.isWorking( nurse, weekday )) {
                     ++totalAssign;
@@ -481,6 +1545,34 @@ namespace INRC2
     bool writeCustomOutput( const std::string &customOutputFileName, const NurseRostering::Solver &solver )
     {
         NurseRostering::History history( solver.genHistory() );
+        const NurseRostering::AssignTable &assign( solver.getOptima().getAssignTable() );
+        const int nurseNum = solver.problem.scenario->nurseNum;
+
+        vector<int> data( CustomHeader::CustomHeaderSize );
+        data.reserve( CustomHeader::CustomHeaderSize + 2 + (6 + 2 * NurseRostering::Weekday::NUM) * nurseNum );
+        data.push_back( history.accObjValue );
+        data.push_back( history.pastWeekCount );
+        data.insert( data.end(), history.totalAssignNums.begin(), history.totalAssignNums.end() );
+        data.insert( data.end(), history.totalWorkingWeekendNums.begin(), history.totalWorkingWeekendNums.end() );
+        data.insert( data.end(), history.lastShifts.begin(), history.lastShifts.end() );
+        data.insert( data.end(), history.consecutiveShiftNums.begin(), history.consecutiveShiftNums.end() );
+        data.insert( data.end(), history.consecutiveDayNums.begin(), history.consecutiveDayNums.end() );
+        data.insert( data.end(), history.consecutiveDayoffNums.begin(), history.consecutiveDayoffNums.end() );
+        for (NurseRostering::NurseID nurse = 0; nurse < nurseNum; ++nurse) {
+            for (int weekday = NurseRostering::Weekday::Mon; weekday <= NurseRostering::Weekday::Sun; ++weekday) {
+                data.push_back( assign[nurse][weekday].shift );
+                data.push_back( assign[nurse][weekday].skill );
+            }
+        }
+
+        const int payloadSize = static_cast<int>(data.size()) - CustomHeader::CustomHeaderSize;
+        data[CustomHeader::CustomMagic] = CUSTOM_MAGIC;
+        data[CustomHeader::CustomVersion] = CUSTOM_VERSION;
+        data[CustomHeader::CustomNurseNum] = nurseNum;
+        data[CustomHeader::CustomFlags] = CustomFlag::HasLastWeekAssign;
+        data[CustomHeader::CustomChecksum] = static_cast<int>(
+            customChecksum( data.data() + CustomHeader::CustomHeaderSize, payloadSize ));
+        data[CustomHeader::CustomPayloadSize] = payloadSize;
 
         ofstream ofs( customOutputFileName, ios::binary );
 
@@ -489,16 +1581,7 @@ namespace INRC2
             return false;
         }
 
-        ofs.write( reinterpret_cast<const char *>(&history.accObjValue), sizeof( history.accObjValue ) );
-        ofs.write( reinterpret_cast<const char *>(&history.pastWeekCount), sizeof( history.pastWeekCount ) );
-        //ofs.write( reinterpret_cast<const char *>(&history.currentWeek), sizeof( history.currentWeek ) );
-        //ofs.write( reinterpret_cast<const char *>(&history.restWeekCount), sizeof( history.restWeekCount ) );
-        ofs.write( reinterpret_cast<const char *>(history.totalAssignNums.data()), history.totalAssignNums.size() * sizeof( int ) );
-        ofs.write( reinterpret_cast<const char *>(history.totalWorkingWeekendNums.data()), history.totalWorkingWeekendNums.size() * sizeof( int ) );
-        ofs.write( reinterpret_cast<const char *>(history.lastShifts.data()), history.lastShifts.size() * sizeof( NurseRostering::ShiftID ) );
-        ofs.write( reinterpret_cast<const char *>(history.consecutiveShiftNums.data()), history.consecutiveShiftNums.size() * sizeof( int ) );
-        ofs.write( reinterpret_cast<const char *>(history.consecutiveDayNums.data()), history.consecutiveDayNums.size() * sizeof( int ) );
-        ofs.write( reinterpret_cast<const char *>(history.consecutiveDayoffNums.data()), history.consecutiveDayoffNums.size() * sizeof( int ) );
+        ofs.write( reinterpret_cast<const char *>(data.data()), data.size() * sizeof( int ) );
 
         ofs.close();
         return true;
@@ -516,6 +1599,8 @@ namespace INRC2
             config.initAlgorithm = NurseRostering::Solver::InitAlgorithm::Greedy;
         } else if (c == 'e') {
             config.initAlgorithm = NurseRostering::Solver::InitAlgorithm::Exact;
+        } else if (c == 'w') {
+            config.initAlgorithm = NurseRostering::Solver::InitAlgorithm::WarmStart;
         } else {
             return config;
         }
@@ -535,6 +1620,10 @@ namespace INRC2
             config.solveAlgorithm = NurseRostering::Solver::SolveAlgorithm::BiasTabuSearch;
         } else if (c == 's') {
             config.solveAlgorithm = NurseRostering::Solver::SolveAlgorithm::SwapChainSearch;
+        } else if (c == 'k') {
+            config.solveAlgorithm = NurseRostering::Solver::SolveAlgorithm::PathRelinking;
+        } else if (c == 'm') {
+            config.solveAlgorithm = NurseRostering::Solver::SolveAlgorithm::Memetic;
         } else {
             return config;
         }
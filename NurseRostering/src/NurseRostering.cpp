@@ -1,5 +1,16 @@
 #include "NurseRostering.h"
 
+#include <bitset>
+
+#ifdef INRC2_USE_SIMD
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define INRC2_USE_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
 
 using namespace std;
 
@@ -21,25 +32,102 @@ const NurseRostering::SkillID NurseRostering::Scenario::Skill::ID_BEGIN = 0;
 
 
 NurseRostering::NurseRostering()
+    : scenario( new Scenario() ), names( new Names() ), scanThreadNum( 1 ), restartNum( 1 )
+{
+}
+
+NurseRostering::Names::Names()
 {
-    names.shiftMap[NurseRostering::Scenario::Shift::NAME_ANY] = NurseRostering::Scenario::Shift::ID_ANY;
-    names.shiftMap[NurseRostering::Scenario::Shift::NAME_NONE] = NurseRostering::Scenario::Shift::ID_NONE;
+    shiftMap[NurseRostering::Scenario::Shift::NAME_ANY] = NurseRostering::Scenario::Shift::ID_ANY;
+    shiftMap[NurseRostering::Scenario::Shift::NAME_NONE] = NurseRostering::Scenario::Shift::ID_NONE;
+}
+
+std::shared_ptr<const NurseRostering::NurseSkillRelation> NurseRostering::discoverNurseSkillRelation() const
+{
+    std::shared_ptr<NurseSkillRelation> relation( new NurseSkillRelation() );
+    NurseNumOfSkill &nurseNumOfSkill( relation->nurseNumOfSkill );
+    NurseWithSkill &nurseWithSkill( relation->nurseWithSkill );
+
+    nurseNumOfSkill = std::vector<SkillID>( scenario->skillSize, 0 );
+    nurseWithSkill = std::vector< std::vector< std::vector<NurseID> > >( scenario->skillSize );
+
+    for (NurseID nurse = 0; nurse < scenario->nurseNum; ++nurse) {
+        const Scenario::Nurse &n( scenario->nurses[nurse] );
+        unsigned skillNum = n.skillNum;
+        for (SkillID skill = NurseRostering::Scenario::Skill::ID_BEGIN; skill < scenario->skillSize; ++skill) {
+            if (n.hasSkill( skill )) {
+                ++nurseNumOfSkill[skill];
+                if (skillNum > nurseWithSkill[skill].size()) {
+                    nurseWithSkill[skill].resize( skillNum );
+                }
+                nurseWithSkill[skill][skillNum - 1].push_back( nurse );
+            }
+        }
+    }
+
+    return relation;
 }
 
 void NurseRostering::adjustRangeOfTotalAssignByWorkload()
 {
-    for (NurseID nurse = 0; nurse < scenario.nurseNum; ++nurse) {
-        const Scenario::Contract &c( scenario.contracts[scenario.nurses[nurse].contract] );
+    restRanges.resize( scenario->nurseNum );
+    for (NurseID nurse = 0; nurse < scenario->nurseNum; ++nurse) {
+        const Scenario::Contract &c( scenario->contracts[scenario->nurses[nurse].contract] );
 #ifdef INRC2_IGNORE_MIN_SHIFT_IN_EARLY_WEEKS
-        int weekToStartCountMin = scenario.totalWeekNum * c.minShiftNum;
+        int weekToStartCountMin = scenario->totalWeekNum * c.minShiftNum;
         bool ignoreMinShift = ((history.currentWeek * c.maxShiftNum) < weekToStartCountMin);
-        scenario.nurses[nurse].restMinShiftNum = (ignoreMinShift) ? 0 : (c.minShiftNum - history.totalAssignNums[nurse]);
+        restRanges[nurse].restMinShiftNum = (ignoreMinShift) ? 0 : (c.minShiftNum - history.totalAssignNums[nurse]);
 #else
-        scenario.nurses[nurse].restMinShiftNum = c.minShiftNum - history.totalAssignNums[nurse];
+        restRanges[nurse].restMinShiftNum = c.minShiftNum - history.totalAssignNums[nurse];
 #endif
-        scenario.nurses[nurse].restMaxShiftNum = c.maxShiftNum - history.totalAssignNums[nurse];
-        scenario.nurses[nurse].restMaxWorkingWeekendNum = c.maxWorkingWeekendNum - history.totalWorkingWeekendNums[nurse];
+        restRanges[nurse].restMaxShiftNum = c.maxShiftNum - history.totalAssignNums[nurse];
+        restRanges[nurse].restMaxWorkingWeekendNum = c.maxWorkingWeekendNum - history.totalWorkingWeekendNums[nurse];
+    }
+}
+
+
+int NurseRostering::AssignTable::distance( const AssignTable &l, const AssignTable &r )
+{
+    const Assign *la = l.assigns.data();
+    const Assign *ra = r.assigns.data();
+    int assignNum = l.assigns.size();
+    int sameNum = 0;
+    int i = 0;
+
+    // each lane holds a whole packed assign, so the movemask has 2 bits for each equal assign
+#ifdef INRC2_USE_SIMD
+#if defined(__AVX2__)
+    const int LANE_NUM = sizeof( __m256i ) / sizeof( Assign );
+    for (; (i + LANE_NUM) <= assignNum; i += LANE_NUM) {
+        __m256i lv = _mm256_loadu_si256( reinterpret_cast<const __m256i *>(la + i) );
+        __m256i rv = _mm256_loadu_si256( reinterpret_cast<const __m256i *>(ra + i) );
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8( _mm256_cmpeq_epi16( lv, rv ) ));
+        sameNum += static_cast<int>(bitset<32>( mask ).count());
+    }
+    sameNum /= 2;
+#elif defined(INRC2_USE_SSE2)
+    const int LANE_NUM = sizeof( __m128i ) / sizeof( Assign );
+    for (; (i + LANE_NUM) <= assignNum; i += LANE_NUM) {
+        __m128i lv = _mm_loadu_si128( reinterpret_cast<const __m128i *>(la + i) );
+        __m128i rv = _mm_loadu_si128( reinterpret_cast<const __m128i *>(ra + i) );
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8( _mm_cmpeq_epi16( lv, rv ) ));
+        sameNum += static_cast<int>(bitset<16>( mask ).count());
+    }
+    sameNum /= 2;
+#endif
+#endif
+    for (; i < assignNum; ++i) {
+        sameNum += (la[i] == ra[i]);
+    }
+
+    // history and next week slots are not part of the roster
+    int dist = assignNum - sameNum;
+    for (NurseID nurse = 0; nurse < l.nurseNum; ++nurse) {
+        dist -= (l[nurse][Weekday::HIS] != r[nurse][Weekday::HIS]);
+        dist -= (l[nurse][Weekday::NEXT_WEEK] != r[nurse][Weekday::NEXT_WEEK]);
     }
+
+    return dist;
 }
 
 
@@ -71,28 +159,61 @@ void NurseRostering::Penalty::recoverLastMode()
 void NurseRostering::Penalty::setSwapMode()
 {
     modeStack.push_back( pm );
-
-    pm.underStaff = 0;          // due to no extra assignments
-    pm.insufficientStaff = 0;   // due to no extra assignments
+    applySwapMode( pm );
 }
 
 void NurseRostering::Penalty::setBlockSwapMode()
 {
     modeStack.push_back( pm );
-
-    pm.underStaff = 0;  // due to no extra assignments
-    pm.succession = 0;  // due to it is checked manually
-    pm.missSkill = 0;   // due to it is checked manually
-    pm.insufficientStaff = 0;   // due to no extra assignments
+    applyBlockSwapMode( pm );
 }
 
 void NurseRostering::Penalty::setExchangeMode()
 {
     modeStack.push_back( pm );
+    applyExchangeMode( pm );
+}
+
+NurseRostering::Penalty NurseRostering::Penalty::withSwapMode() const
+{
+    Penalty p( pm );
+    applySwapMode( p.pm );
+    return p;
+}
+
+NurseRostering::Penalty NurseRostering::Penalty::withBlockSwapMode() const
+{
+    Penalty p( pm );
+    applyBlockSwapMode( p.pm );
+    return p;
+}
 
-    pm.succession = 0;  // due to it is checked manually
-    pm.missSkill = 0;   // due to it is the same nurse
-    pm.totalAssign = 0; // due to it is the same nurse
+NurseRostering::Penalty NurseRostering::Penalty::withExchangeMode() const
+{
+    Penalty p( pm );
+    applyExchangeMode( p.pm );
+    return p;
+}
+
+void NurseRostering::Penalty::applySwapMode( PenaltyMode &mode )
+{
+    mode.underStaff = 0;        // due to no extra assignments
+    mode.insufficientStaff = 0; // due to no extra assignments
+}
+
+void NurseRostering::Penalty::applyBlockSwapMode( PenaltyMode &mode )
+{
+    mode.underStaff = 0;    // due to no extra assignments
+    mode.succession = 0;    // due to it is checked manually
+    mode.missSkill = 0;     // due to it is checked manually
+    mode.insufficientStaff = 0; // due to no extra assignments
+}
+
+void NurseRostering::Penalty::applyExchangeMode( PenaltyMode &mode )
+{
+    mode.succession = 0;    // due to it is checked manually
+    mode.missSkill = 0;     // due to it is the same nurse
+    mode.totalAssign = 0;   // due to it is the same nurse
 }
 
 void NurseRostering::Penalty::setRepairMode( ObjValue WeightOnUnderStaff, ObjValue WeightOnSuccesion, ObjValue softConstraintDecay )
@@ -5,82 +5,6 @@
 using namespace std;
 
 
-const NurseRostering::Solution::TryMoveTable
-NurseRostering::Solution::tryMove = {
-    &NurseRostering::Solution::tryAddAssign,
-    &NurseRostering::Solution::tryRemoveAssign,
-    &NurseRostering::Solution::tryChangeAssign,
-    &NurseRostering::Solution::tryExchangeDay,
-    &NurseRostering::Solution::trySwapNurse,
-    &NurseRostering::Solution::trySwapBlock
-};
-const NurseRostering::Solution::FindBestMoveTable
-NurseRostering::Solution::findBestMove = {
-    &NurseRostering::Solution::findBestAdd,
-    &NurseRostering::Solution::findBestRemove,
-    &NurseRostering::Solution::findBestChange,
-    &NurseRostering::Solution::findBestExchange,
-    &NurseRostering::Solution::findBestSwap,
-#if INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_ORGN
-    &NurseRostering::Solution::findBestBlockSwap,
-#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_CACHED
-    &NurseRostering::Solution::findBestBlockSwap_cached,
-#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_FAST
-    &NurseRostering::Solution::findBestBlockSwap_fast,
-#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_PART
-    &NurseRostering::Solution::findBestBlockSwap_part,
-#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_RAND
-    &NurseRostering::Solution::findBestBlockSwap_rand,
-#endif
-    &NurseRostering::Solution::findBestBlockShift,
-    &NurseRostering::Solution::findBestARLoop,
-    &NurseRostering::Solution::findBestARRand,
-    &NurseRostering::Solution::findBestARBoth
-};
-const NurseRostering::Solution::FindBestMoveTable
-NurseRostering::Solution::findBestMoveOnBlockBorder = {
-    &NurseRostering::Solution::findBestAddOnBlockBorder,
-    &NurseRostering::Solution::findBestRemoveOnBlockBorder,
-    &NurseRostering::Solution::findBestChangeOnBlockBorder,
-    &NurseRostering::Solution::findBestExchangeOnBlockBorder,
-    &NurseRostering::Solution::findBestSwapOnBlockBorder,
-#if INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_ORGN
-    &NurseRostering::Solution::findBestBlockSwap,
-#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_CACHED
-    &NurseRostering::Solution::findBestBlockSwap_cached,
-#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_FAST
-    &NurseRostering::Solution::findBestBlockSwap_fast,
-#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_PART
-    &NurseRostering::Solution::findBestBlockSwap_part,
-#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_RAND
-    &NurseRostering::Solution::findBestBlockSwap_rand,
-#endif
-    &NurseRostering::Solution::findBestBlockShift,
-    &NurseRostering::Solution::findBestARLoopOnBlockBorder,
-    &NurseRostering::Solution::findBestARRandOnBlockBorder,
-    &NurseRostering::Solution::findBestARBothOnBlockBorder
-};
-const NurseRostering::Solution::ApplyMoveTable
-NurseRostering::Solution::applyMove = {
-    &NurseRostering::Solution::addAssign,
-    &NurseRostering::Solution::removeAssign,
-    &NurseRostering::Solution::changeAssign,
-    &NurseRostering::Solution::exchangeDay,
-    &NurseRostering::Solution::swapNurse,
-    &NurseRostering::Solution::swapBlock
-};
-#ifdef INRC2_USE_TABU
-const NurseRostering::Solution::UpdateTabuTable
-NurseRostering::Solution::updateTabu = {
-    &NurseRostering::Solution::updateAddTabu,
-    &NurseRostering::Solution::updateRemoveTabu,
-    &NurseRostering::Solution::updateChangeTabu,
-    &NurseRostering::Solution::updateExchangeTabu,
-    &NurseRostering::Solution::updateSwapTabu,
-    &NurseRostering::Solution::updateBlockSwapTabu
-};
-#endif
-
 const vector<string> NurseRostering::Solution::modeSeqNames = {
     "[ARlCS]", "[ARrCS]", "[ARbCS]", "[ACSR]",
     "[ARlSCB]", "[ARrSCB]", "[ARbSCB]", "[ASCBR]",
@@ -89,7 +13,7 @@ const vector<string> NurseRostering::Solution::modeSeqNames = {
     "[ARlCB]", "[ARrCB]", "[ARbCB]", "[ACBR]",
     "[ARlCEB]", "[ARrCEB]", "[ARbCEB]", "[ACEBR]"
 };
-const vector<vector<int> > NurseRostering::Solution::modeSeqPatterns = {
+const vector<NurseRostering::Solution::ModeSeqPattern> NurseRostering::Solution::modeSeqPatterns = {
     { Solution::Move::Mode::ARLoop, Solution::Move::Mode::Change, Solution::Move::Mode::Swap },
     { Solution::Move::Mode::ARRand, Solution::Move::Mode::Change, Solution::Move::Mode::Swap },
     { Solution::Move::Mode::ARBoth, Solution::Move::Mode::Change, Solution::Move::Mode::Swap },
@@ -126,12 +50,12 @@ const double NurseRostering::Solution::NO_DIFF = -1;
 
 
 NurseRostering::Solution::Solution( const TabuSolver &s )
-    : solver( s ), problem( s.problem ), iterCount( 1 )
+    : solver( s ), problem( s.problem ), scanPool( NULL ), iterCount( 1 )
 {
 }
 
 NurseRostering::Solution::Solution( const TabuSolver &s, const Output &output )
-    : solver( s ), problem( s.problem ), iterCount( 1 )
+    : solver( s ), problem( s.problem ), scanPool( NULL ), iterCount( 1 )
 {
     rebuild( output );
 }
@@ -140,7 +64,7 @@ void NurseRostering::Solution::rebuild( const Output &output, double diff )
 {
     if (diff < 1) { // greater than 1 means totally change
         unsigned selectBound = static_cast<unsigned>(diff *
-            (solver.randGen.max() - solver.randGen.min()) + solver.randGen.min());
+            (evalContext.randGen.max() - evalContext.randGen.min()) + evalContext.randGen.min());
 
         const AssignTable &assignTable( (&output.getAssignTable() != &assign)
             ? output.getAssignTable() : AssignTable( output.getAssignTable() ) );
@@ -148,10 +72,10 @@ void NurseRostering::Solution::rebuild( const Output &output, double diff )
         resetAssign();
         resetAssistData();
 
-        for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+        for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
             for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
                 if (assignTable[nurse][weekday].isWorking()) {
-                    if (solver.randGen() >= selectBound) {
+                    if (evalContext.randGen() >= selectBound) {
                         addAssign( weekday, nurse, assignTable[nurse][weekday] );
                     }
                 }
@@ -174,7 +98,7 @@ void NurseRostering::Solution::rebuild( const Output &output )
     resetAssign();
     resetAssistData();
 
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
             if (assignTable[nurse][weekday].isWorking()) {
                 addAssign( weekday, nurse, assignTable[nurse][weekday] );
@@ -211,19 +135,19 @@ bool NurseRostering::Solution::genInitAssign_Greedy()
     resetAssign();
     resetAssistData();
 
-    AvailableNurses availableNurse( *this );
+    AvailableNurses availableNurse( *this, evalContext.randGen );
     const NurseNumOfSkill &nurseNumOfSkill( solver.getNurseNumOfSkill() );
 
     for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
         // decide assign sequence of skill
         // the greater requiredNurseNum/nurseNumOfSkill[skill] is, the smaller index in skillRank a skill will get
-        vector<SkillID> skillRank( problem.scenario.skillTypeNum );
-        vector<double> dailyRequire( problem.scenario.skillSize, 0 );
-        for (int rank = 0; rank < problem.scenario.skillTypeNum; ++rank) {
+        vector<SkillID> skillRank( problem.scenario->skillTypeNum );
+        vector<double> dailyRequire( problem.scenario->skillSize, 0 );
+        for (int rank = 0; rank < problem.scenario->skillTypeNum; ++rank) {
             SkillID skill = rank + NurseRostering::Scenario::Skill::ID_BEGIN;
             skillRank[rank] = skill;
             for (ShiftID shift = NurseRostering::Scenario::Shift::ID_BEGIN;
-                shift < problem.scenario.shiftSize; ++shift) {
+                shift < problem.scenario->shiftSize; ++shift) {
                 dailyRequire[skill] += problem.weekData.minNurseNums[weekday][shift][skill];
             }
             dailyRequire[skill] /= nurseNumOfSkill[skill];
@@ -247,11 +171,11 @@ bool NurseRostering::Solution::genInitAssign_Greedy()
         sort( skillRank.begin(), skillRank.end(), CmpDailyRequire( dailyRequire ) );
 
         // start assigning nurses
-        for (int rank = 0; rank < problem.scenario.skillTypeNum; ++rank) {
+        for (int rank = 0; rank < problem.scenario->skillTypeNum; ++rank) {
             SkillID skill = skillRank[rank];
             availableNurse.setEnvironment( weekday, skill );
             for (ShiftID shift = NurseRostering::Scenario::Shift::ID_BEGIN;
-                shift < problem.scenario.shiftSize; ++shift) {
+                shift < problem.scenario->shiftSize; ++shift) {
                 availableNurse.setShift( shift );
                 for (int i = 0; i < problem.weekData.minNurseNums[weekday][shift][skill]; ++i) {
                     int nurse = availableNurse.getNurse();
@@ -269,6 +193,25 @@ bool NurseRostering::Solution::genInitAssign_Greedy()
     return true;
 }
 
+bool NurseRostering::Solution::genInitAssign_WarmStart( const AssignTable &lastWeekAssign )
+{
+    resetAssign();
+    resetAssistData();
+
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
+        for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
+            if (lastWeekAssign[nurse][weekday].isWorking()) {
+                addAssign( weekday, nurse, lastWeekAssign[nurse][weekday] );
+            }
+        }
+    }
+    evaluateObjValue();
+
+    // leave most of the time for greedy init if it fails
+    Timer timer( solver.timer.restTime() / 4 );
+    return repair( timer );
+}
+
 bool NurseRostering::Solution::genInitAssign_BranchAndCut()
 {
     resetAssign();
@@ -283,15 +226,15 @@ bool NurseRostering::Solution::genInitAssign_BranchAndCut()
 
 bool NurseRostering::Solution::fillAssign( int weekday, ShiftID shift, SkillID skill, NurseID nurse, int nurseNum )
 {
-    if (nurse >= problem.scenario.nurseNum) {
+    if (nurse >= problem.scenario->nurseNum) {
         if (nurseNum < problem.weekData.minNurseNums[weekday][shift][skill]) {
             return false;
         } else {
             return fillAssign( weekday, shift, skill + 1, 0, 0 );
         }
-    } else if (skill >= problem.scenario.skillSize) {
+    } else if (skill >= problem.scenario->skillSize) {
         return fillAssign( weekday, shift + 1, NurseRostering::Scenario::Skill::ID_BEGIN, 0, 0 );
-    } else if (shift >= problem.scenario.shiftSize) {
+    } else if (shift >= problem.scenario->shiftSize) {
         return fillAssign( weekday + 1, NurseRostering::Scenario::Shift::ID_BEGIN,
             NurseRostering::Scenario::Skill::ID_BEGIN, 0, 0 );
     } else if (weekday > Weekday::Sun) {
@@ -309,9 +252,9 @@ bool NurseRostering::Solution::fillAssign( int weekday, ShiftID shift, SkillID s
     bool isNotAssignedBefore = !assign.isWorking( nurse, weekday );
 
     if (isNotAssignedBefore) {
-        if (problem.scenario.nurses[nurse].skills[skill]
+        if (problem.scenario->nurses[nurse].hasSkill( skill )
             && isValidSuccession( nurse, shift, weekday )) {
-            if (solver.randGen() % 2) {
+            if (evalContext.randGen() % 2) {
                 swap( firstAssign, secondAssign );
                 swap( firstNurseNum, secondNurseNum );
             }
@@ -337,8 +280,8 @@ bool NurseRostering::Solution::fillAssign( int weekday, ShiftID shift, SkillID s
 
 void NurseRostering::Solution::resetAssign()
 {
-    assign = AssignTable( problem.scenario.nurseNum, Weekday::SIZE );
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    assign = AssignTable( problem.scenario->nurseNum, Weekday::SIZE );
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         assign[nurse][Weekday::HIS] = Assign( problem.history.lastShifts[nurse] );
         assign[nurse][Weekday::NEXT_WEEK] = Assign();
     }
@@ -348,22 +291,19 @@ void NurseRostering::Solution::resetAssistData()
 {
     // incremental evaluation
     missingNurseNums = problem.weekData.optNurseNums;
-    totalAssignNums = vector<int>( problem.scenario.nurseNum, 0 );
-    consecutives = vector<Consecutive>( problem.scenario.nurseNum );
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    totalAssignNums = vector<int>( problem.scenario->nurseNum, 0 );
+    consecutives = vector<Consecutive>( problem.scenario->nurseNum );
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         consecutives[nurse] = Consecutive( problem.history, nurse );
     }
     // penalty weight
-    nurseWeights = vector<ObjValue>( problem.scenario.nurseNum, 1 );
+    nurseWeights = vector<ObjValue>( problem.scenario->nurseNum, 1 );
 #ifdef INRC2_USE_TABU
     // tabu table
     if (shiftTabu.empty() || dayTabu.empty()) {
-        shiftTabu = ShiftTabu( problem.scenario.nurseNum,
-            vector< vector< vector<IterCount> > >( Weekday::SIZE,
-            vector< vector<IterCount> >( problem.scenario.shiftSize,
-            vector<IterCount>( problem.scenario.skillSize, 0 ) ) ) );
-        dayTabu = DayTabu( problem.scenario.nurseNum,
-            vector<IterCount>( Weekday::SIZE, 0 ) );
+        shiftTabu = ShiftTabu( problem.scenario->nurseNum,
+            problem.scenario->shiftSize, problem.scenario->skillSize );
+        dayTabu = DayTabu( problem.scenario->nurseNum );
     } else {
         iterCount += solver.ShiftTabuTenureBase() + solver.ShiftTabuTenureAmp()
             + solver.DayTabuTenureBase() + solver.DayTabuTenureAmp();
@@ -371,16 +311,28 @@ void NurseRostering::Solution::resetAssistData()
 #endif
     // delta cache
     if (blockSwapCache.empty()) {
-        blockSwapCache = BlockSwapCache( problem.scenario.nurseNum,
-            vector<BlockSwapCacheItem>( problem.scenario.nurseNum ) );
+        blockSwapCache = BlockSwapCache( problem.scenario->nurseNum,
+            vector<BlockSwapCacheItem>( problem.scenario->nurseNum ) );
+    }
+    isBlockSwapCacheValid = vector<bool>( problem.scenario->nurseNum, false );
+    blockSwapRows.resize( problem.scenario->nurseNum );
+    if (blockSwapIndex.empty()) {
+        blockSwapIndex = TournamentTree<ObjValue>(
+            problem.scenario->nurseNum * problem.scenario->nurseNum );
+    }
+    if (swapCache.empty()) {
+        swapCache = SwapCache( problem.scenario->nurseNum,
+            vector<SwapCacheItem>( problem.scenario->nurseNum ) );
+    }
+    isSwapCacheValid = vector<bool>( problem.scenario->nurseNum, false );
+    if (assignDeltaCache.empty()) {
+        assignDeltaCache = AssignDeltaCache( problem.scenario->nurseNum,
+            problem.scenario->shiftSize, problem.scenario->skillSize );
+    } else {
+        assignDeltaCache.invalidateAll();
     }
-    isBlockSwapCacheValid = vector<bool>( problem.scenario.nurseNum, false );
     // flags
-    findBestARLoop_flag = true;
-    findBestARLoopOnBlockBorder_flag = true;
-    findBestBlockSwap_startNurse = problem.scenario.nurseNum;
-    isPossibilitySelect = false;
-    isBlockSwapSelected = false;
+    evalContext.reset( problem.scenario->nurseNum );
 }
 
 void NurseRostering::Solution::evaluateObjValue( bool considerSpanningConstraint )
@@ -394,7 +346,7 @@ void NurseRostering::Solution::evaluateObjValue( bool considerSpanningConstraint
     objTotalAssign = 0;
     objTotalWorkingWeekend = 0;
 
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         objConsecutiveShift += evaluateConsecutiveShift( nurse );
         objConsecutiveDay += evaluateConsecutiveDay( nurse );
         objConsecutiveDayOff += evaluateConsecutiveDayOff( nurse );
@@ -414,10 +366,10 @@ NurseRostering::History NurseRostering::Solution::genHistory() const
 {
     const History &history( problem.history );
     History newHistory;
-    newHistory.lastShifts.resize( problem.scenario.nurseNum );
-    newHistory.consecutiveShiftNums.resize( problem.scenario.nurseNum, 0 );
-    newHistory.consecutiveDayNums.resize( problem.scenario.nurseNum, 0 );
-    newHistory.consecutiveDayoffNums.resize( problem.scenario.nurseNum, 0 );
+    newHistory.lastShifts.resize( problem.scenario->nurseNum );
+    newHistory.consecutiveShiftNums.resize( problem.scenario->nurseNum, 0 );
+    newHistory.consecutiveDayNums.resize( problem.scenario->nurseNum, 0 );
+    newHistory.consecutiveDayoffNums.resize( problem.scenario->nurseNum, 0 );
 
     newHistory.accObjValue = history.accObjValue + objValue;
     newHistory.pastWeekCount = history.currentWeek;
@@ -426,7 +378,7 @@ NurseRostering::History NurseRostering::Solution::genHistory() const
     newHistory.totalAssignNums = history.totalAssignNums;
     newHistory.totalWorkingWeekendNums = history.totalWorkingWeekendNums;
 
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         newHistory.totalAssignNums[nurse] += totalAssignNums[nurse];
         newHistory.totalWorkingWeekendNums[nurse] +=
             (assign.isWorking( nurse, Weekday::Sat ) || assign.isWorking( nurse, Weekday::Sun ));
@@ -454,10 +406,7 @@ bool NurseRostering::Solution::repair( const Timer &timer )
 #endif
     // must not use swap for swap mode is not compatible with repair mode
     // also, the repair procedure doesn't need the technique to jump through infeasible solutions
-    Solution::FindBestMoveTable fbmt = {
-        &NurseRostering::Solution::findBestARBoth,
-        &NurseRostering::Solution::findBestChange
-    };
+    const ModeSeqPattern modeSeqPat = { Move::Mode::ARBoth, Move::Mode::Change };
 
     ObjValue violation = solver.checkFeasibility( assign );
 
@@ -466,7 +415,7 @@ bool NurseRostering::Solution::repair( const Timer &timer )
     // reduced tabuSearch_Rand()
     penalty.setRepairMode();
     objValue = violation;
-    int modeNum = fbmt.size();
+    int modeNum = modeSeqPat.size();
 
     const int minWeight = 256;  // min weight
     const int maxWeight = 1024; // max weight (less than (RAND_MAX / modeNum))
@@ -480,15 +429,16 @@ bool NurseRostering::Solution::repair( const Timer &timer )
 
     for (; !timer.isTimeOut() && (objValue > 0)
         && (iterCount != problem.maxIterCount); ++iterCount) {
+        solver.yieldToPortfolio( iterCount );
         int modeSelect = 0;
-        for (int w = solver.randGen() % totalWeight; (w -= weights[modeSelect]) >= 0; ++modeSelect) {}
+        for (int w = evalContext.randGen() % totalWeight; (w -= weights[modeSelect]) >= 0; ++modeSelect) {}
 
         Move bestMove;
-        (this->*fbmt[modeSelect])(bestMove);
+        findBestMove( evalContext, modeSeqPat[modeSelect], bestMove );
 
 #ifdef INRC2_USE_TABU
         // update tabu list first because it requires original assignment
-        ( this->*updateTabu[bestMove.mode] )(bestMove);
+        updateTabu( bestMove );
 #endif
         int weightDelta;
         if (bestMove.delta < DefaultPenalty::MAX_OBJ_VALUE) {
@@ -524,10 +474,14 @@ void NurseRostering::Solution::adjustWeightToBiasNurseWithGreaterPenalty( int in
 {
     int biasedNurseNum = 0;
     fill( nurseWeights.begin(), nurseWeights.end(), 0 );
+    fill( isSwapCacheValid.begin(), isSwapCacheValid.end(), false );
+    // pairs with both nurses of zero weight are not considered in block swap
+    fill( isBlockSwapCacheValid.begin(), isBlockSwapCacheValid.end(), false );
+    assignDeltaCache.invalidateAll();
 
     // select worse nurses to meet the PenaltyBiasRatio
-    vector<ObjValue> nurseObj( problem.scenario.nurseNum, 0 );
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    vector<ObjValue> nurseObj( problem.scenario->nurseNum, 0 );
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         nurseObj[nurse] += evaluateConsecutiveShift( nurse );
         nurseObj[nurse] += evaluateConsecutiveDay( nurse );
         nurseObj[nurse] += evaluateConsecutiveDayOff( nurse );
@@ -556,8 +510,8 @@ void NurseRostering::Solution::adjustWeightToBiasNurseWithGreaterPenalty( int in
     } cmpNurseObj( nurseObj );
 #endif
 
-    for (auto iter = problem.scenario.contracts.begin();
-        iter != problem.scenario.contracts.end(); ++iter) {
+    for (auto iter = problem.scenario->contracts.begin();
+        iter != problem.scenario->contracts.end(); ++iter) {
         vector<NurseID> &nurses( const_cast<vector<NurseID>&>(iter->nurses) );
 #ifndef INRC2_USE_LAMBDA_IN_SORT
         sort( nurses.begin(), nurses.end(), cmpNurseObj );
@@ -573,16 +527,16 @@ void NurseRostering::Solution::adjustWeightToBiasNurseWithGreaterPenalty( int in
         for (int i = 0; i < num; ++i) {
             nurseWeights[nurses[i]] = 1;
         }
-        if (solver.randGen() % inversePenaltyBiasRatio < remainder) {
+        if (evalContext.randGen() % inversePenaltyBiasRatio < remainder) {
             nurseWeights[nurses[num]] = 1;
             ++biasedNurseNum;
         }
     }
 
     // pick nurse randomly to meet the TotalBiasRatio
-    int num = problem.scenario.nurseNum / inverseTotalBiasRatio;
+    int num = problem.scenario->nurseNum / inverseTotalBiasRatio;
     while (biasedNurseNum < num) {
-        NurseID nurse = solver.randGen() % problem.scenario.nurseNum;
+        NurseID nurse = evalContext.randGen() % problem.scenario->nurseNum;
         if (nurseWeights[nurse] == 0) {
             nurseWeights[nurse] = 1;
             ++biasedNurseNum;
@@ -594,7 +548,7 @@ void NurseRostering::Solution::adjustWeightToBiasNurseWithGreaterPenalty( int in
 void NurseRostering::Solution::swapChainSearch_DoubleHead( const Timer &timer, IterCount maxNoImproveChainLength )
 {
     if (!((optima.getObjValue() < solver.getOptima().getObjValue())
-        || (solver.randGen() % solver.PERTURB_ORIGIN_SELECT))
+        || (evalContext.randGen() % solver.PERTURB_ORIGIN_SELECT))
         || (optima.getObjValue() >= DefaultPenalty::MAX_OBJ_VALUE)) {
         optima = solver.getOptima();
     }
@@ -608,18 +562,24 @@ void NurseRostering::Solution::swapChainSearch_DoubleHead( const Timer &timer, I
         ObjValue bestDeltaForOneNurse = DefaultPenalty::FORBIDDEN_MOVE;
 
         // find start links for the chain of block swap
-        penalty.setBlockSwapMode();
+        const Penalty::BlockSwapMode pm;
+        vector<BlockSwapRow> rows;
+        buildBlockSwapRows( pm, rows );
         Move move;
-        for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
-            for (move.nurse2 = move.nurse + 1; move.nurse2 < problem.scenario.nurseNum; ++move.nurse2) {
+        for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
+            for (move.nurse2 = move.nurse + 1; move.nurse2 < problem.scenario->nurseNum; ++move.nurse2) {
                 if (solver.haveSameSkill( move.nurse, move.nurse2 )) {
                     for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
-                        move.delta = trySwapBlock( move.weekday, move.weekday2, move.nurse, move.nurse2 );
+                        SwapDelta swapDelta( trySwapBlock( evalContext, pm, rows[move.nurse], rows[move.nurse2],
+                            move.weekday, move.weekday2, move.nurse, move.nurse2 ) );
+                        move.delta = swapDelta.delta;
                         if (move.delta < DefaultPenalty::MAX_OBJ_VALUE) {
+                            ObjValue &nurseDelta( swapDelta.nurseDelta );
+                            ObjValue &nurse2Delta( swapDelta.nurse2Delta );
                             bool isSwap = (nurseDelta > nurse2Delta);
                             if (isSwap) { swap( nurseDelta, nurse2Delta ); }
                             if (nurseDelta < 0) {
-                                if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                                if (rs.isMinimal( move.delta, bestMove.delta, evalContext.randGen )) {
                                     bestMove = move;
                                     if (isSwap) { swap( bestMove.nurse, bestMove.nurse2 ); }
                                 }
@@ -633,7 +593,6 @@ void NurseRostering::Solution::swapChainSearch_DoubleHead( const Timer &timer, I
                 }
             }
         }
-        penalty.recoverLastMode();
 
         if (bestMove.delta < DefaultPenalty::MAX_OBJ_VALUE) {
             if (genSwapChain( timer, bestMove, maxNoImproveChainLength )) {
@@ -652,7 +611,7 @@ void NurseRostering::Solution::swapChainSearch_DoubleHead( const Timer &timer, I
 void NurseRostering::Solution::swapChainSearch( const Timer &timer, IterCount maxNoImproveChainLength )
 {
     if (!((optima.getObjValue() < solver.getOptima().getObjValue())
-        || (solver.randGen() % solver.PERTURB_ORIGIN_SELECT))
+        || (evalContext.randGen() % solver.PERTURB_ORIGIN_SELECT))
         || (optima.getObjValue() >= DefaultPenalty::MAX_OBJ_VALUE)) {
         optima = solver.getOptima();
     }
@@ -665,14 +624,20 @@ void NurseRostering::Solution::swapChainSearch( const Timer &timer, IterCount ma
 
         // find start links for the chain of block swap
         if (bestMoves.empty()) {
-            penalty.setBlockSwapMode();
+            const Penalty::BlockSwapMode pm;
+            vector<BlockSwapRow> rows;
+            buildBlockSwapRows( pm, rows );
             Move move;
-            for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
-                for (move.nurse2 = move.nurse + 1; move.nurse2 < problem.scenario.nurseNum; ++move.nurse2) {
+            for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
+                for (move.nurse2 = move.nurse + 1; move.nurse2 < problem.scenario->nurseNum; ++move.nurse2) {
                     if (solver.haveSameSkill( move.nurse, move.nurse2 )) {
                         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
-                            move.delta = trySwapBlock( move.weekday, move.weekday2, move.nurse, move.nurse2 );
+                            SwapDelta swapDelta( trySwapBlock( evalContext, pm, rows[move.nurse], rows[move.nurse2],
+                                move.weekday, move.weekday2, move.nurse, move.nurse2 ) );
+                            move.delta = swapDelta.delta;
                             if (move.delta < DefaultPenalty::MAX_OBJ_VALUE) {
+                                ObjValue &nurseDelta( swapDelta.nurseDelta );
+                                ObjValue &nurse2Delta( swapDelta.nurse2Delta );
                                 bool isSwap = (nurseDelta > nurse2Delta);
                                 if (isSwap) { swap( nurseDelta, nurse2Delta ); }
                                 if (nurseDelta < 0) {
@@ -685,7 +650,6 @@ void NurseRostering::Solution::swapChainSearch( const Timer &timer, IterCount ma
                     }
                 }
             }
-            penalty.recoverLastMode();
         }
 
         Move head;
@@ -704,6 +668,52 @@ void NurseRostering::Solution::swapChainSearch( const Timer &timer, IterCount ma
 
 bool NurseRostering::Solution::genSwapChain( const Timer &timer, const Move &head, IterCount noImproveLen )
 {
+    // select next link which may improve the optima by the head or the whole block swap
+    struct LinkSelector
+    {
+    public:
+        LinkSelector( const Solution &solution, RandSelect<ObjValue> &randSelect, std::mt19937 &rgen, const Move &currentMove, Move &best )
+            : sln( solution ), rs( randSelect ), randGen( rgen ), move( currentMove ), bestMove( best )
+#ifdef INRC2_SWAP_CHAIN_MAKE_BAD_MOVE
+            , bestDeltaForOneNurse( DefaultPenalty::FORBIDDEN_MOVE )
+#endif
+        {
+        }
+
+        void operator()( int weekday, int weekday2, const SwapDelta &swapDelta, bool )
+        {
+            if ((sln.objValue + swapDelta.nurseDelta < sln.optima.getObjValue())
+                || (sln.objValue + swapDelta.delta < sln.optima.getObjValue())) {
+                if (rs.isMinimal( swapDelta.delta, bestMove.delta, randGen )) {
+                    bestMove = move;
+                    bestMove.weekday = weekday;
+                    bestMove.weekday2 = weekday2;
+                    bestMove.delta = swapDelta.delta;
+                }
+#ifdef INRC2_SWAP_CHAIN_MAKE_BAD_MOVE
+            } else if (swapDelta.nurseDelta < bestDeltaForOneNurse) { // in case no swap meet requirement above
+                bestMoveForOneNurse = move;
+                bestMoveForOneNurse.weekday = weekday;
+                bestMoveForOneNurse.weekday2 = weekday2;
+                bestMoveForOneNurse.delta = swapDelta.delta;
+                bestDeltaForOneNurse = swapDelta.nurseDelta;
+#endif
+            }
+        }
+
+#ifdef INRC2_SWAP_CHAIN_MAKE_BAD_MOVE
+        Move bestMoveForOneNurse;
+        ObjValue bestDeltaForOneNurse;
+#endif
+
+    private:
+        const Solution &sln;
+        RandSelect<ObjValue> &rs;
+        std::mt19937 &randGen;
+        const Move &move;
+        Move &bestMove;
+    };
+
     RandSelect<ObjValue> rs;
     Move bestMove( head );
     Move move;
@@ -712,8 +722,11 @@ bool NurseRostering::Solution::genSwapChain( const Timer &timer, const Move &hea
     IterCount len = noImproveLen;
     for (; !timer.isTimeOut() && (len > 0)
         && (iterCount != problem.maxIterCount); ++iterCount) {
+        solver.yieldToPortfolio( iterCount );
+        bestMove.mode = Move::Mode::BlockSwap;
         swapBlock( bestMove );
         objValue += bestMove.delta;
+        invalidateCacheFlag( bestMove );
         if (updateOptima()) { return true; }
 
         // try to improve the worsened nurse
@@ -722,16 +735,16 @@ bool NurseRostering::Solution::genSwapChain( const Timer &timer, const Move &hea
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
             if (assign.isWorking( move.nurse, move.weekday )) {
                 move.delta = tryRemoveAssign( move );
-                if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                if (rs.isMinimal( move.delta, bestMove.delta, evalContext.randGen )) {
                     bestMove = move;
                     bestMove.mode = Move::Mode::Remove;
                 }
                 for (move.assign.shift = NurseRostering::Scenario::Shift::ID_BEGIN;
-                    move.assign.shift < problem.scenario.shiftSize; ++move.assign.shift) {
+                    move.assign.shift < problem.scenario->shiftSize; ++move.assign.shift) {
                     for (move.assign.skill = NurseRostering::Scenario::Skill::ID_BEGIN;
-                        move.assign.skill < problem.scenario.skillSize; ++move.assign.skill) {
+                        move.assign.skill < problem.scenario->skillSize; ++move.assign.skill) {
                         move.delta = tryChangeAssign( move );
-                        if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                        if (rs.isMinimal( move.delta, bestMove.delta, evalContext.randGen )) {
                             bestMove = move;
                             bestMove.mode = Move::Mode::Change;
                         }
@@ -739,11 +752,11 @@ bool NurseRostering::Solution::genSwapChain( const Timer &timer, const Move &hea
                 }
             } else {
                 for (move.assign.shift = NurseRostering::Scenario::Shift::ID_BEGIN;
-                    move.assign.shift < problem.scenario.shiftSize; ++move.assign.shift) {
+                    move.assign.shift < problem.scenario->shiftSize; ++move.assign.shift) {
                     for (move.assign.skill = NurseRostering::Scenario::Skill::ID_BEGIN;
-                        move.assign.skill < problem.scenario.skillSize; ++move.assign.skill) {
+                        move.assign.skill < problem.scenario->skillSize; ++move.assign.skill) {
                         move.delta = tryAddAssign( move );
-                        if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                        if (rs.isMinimal( move.delta, bestMove.delta, evalContext.randGen )) {
                             bestMove = move;
                             bestMove.mode = Move::Mode::Add;
                         }
@@ -751,13 +764,12 @@ bool NurseRostering::Solution::genSwapChain( const Timer &timer, const Move &hea
                 }
             }
         }
-        penalty.setExchangeMode();
         const Consecutive &c( consecutives[move.nurse] );
         move.weekday = Weekday::Mon;
         move.weekday2 = c.dayHigh[move.weekday] + 1;
         while (move.weekday2 <= Weekday::Sun) {
-            move.delta = tryExchangeDay( move.weekday, move.nurse, move.weekday2 );
-            if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+            move.delta = tryExchangeDay( Penalty::ExchangeMode(), move.weekday, move.nurse, move.weekday2 );
+            if (rs.isMinimal( move.delta, bestMove.delta, evalContext.randGen )) {
                 bestMove = move;
                 bestMove.mode = Move::Mode::Exchange;
             }
@@ -769,7 +781,6 @@ bool NurseRostering::Solution::genSwapChain( const Timer &timer, const Move &hea
                 move.weekday2 = c.dayHigh[move.weekday] + 1;
             }
         }
-        penalty.recoverLastMode();
 
         // apply add/change/remove/shift if there is improvement
 #ifdef INRC2_SWAP_CHAIN_MAKE_BAD_MOVE
@@ -782,67 +793,22 @@ bool NurseRostering::Solution::genSwapChain( const Timer &timer, const Move &hea
         }
 
         // find next link
-        penalty.setBlockSwapMode();
         bestMove.delta = DefaultPenalty::FORBIDDEN_MOVE;
-#ifdef INRC2_SWAP_CHAIN_MAKE_BAD_MOVE
-        Move bestMoveForOneNurse;
-        ObjValue bestDeltaForOneNurse = DefaultPenalty::FORBIDDEN_MOVE;
-#endif
-        for (move.nurse2 = 0; move.nurse2 < problem.scenario.nurseNum; ++move.nurse2) {
+        LinkSelector select( *this, rs, evalContext.randGen, move, bestMove );
+        const Penalty::BlockSwapMode pm;
+        BlockSwapRow row;
+        BlockSwapRow row2;
+        buildBlockSwapRow( pm, move.nurse, row );
+        for (move.nurse2 = 0; move.nurse2 < problem.scenario->nurseNum; ++move.nurse2) {
             if ((move.nurse != move.nurse2) && solver.haveSameSkill( move.nurse, move.nurse2 )) {
-                for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
-                    if (!(isValidSuccession( move.nurse, assign[move.nurse2][move.weekday].shift, move.weekday )
-                        && isValidSuccession( move.nurse2, assign[move.nurse][move.weekday].shift, move.weekday ))) {
-                        continue;
-                    }
-
-                    move.delta = 0;
-                    ObjValue headDelta = 0;
-                    move.weekday2 = move.weekday;
-                    // try each block length
-                    while (problem.scenario.nurses[move.nurse].skills[assign[move.nurse2][move.weekday2].skill]
-                        && problem.scenario.nurses[move.nurse2].skills[assign[move.nurse][move.weekday2].skill]) {
-                        // longer blocks will also miss this skill
-                        move.delta += trySwapNurse( move.weekday2, move.nurse, move.nurse2 );
-                        headDelta += nurseDelta;
-
-                        if (move.delta < DefaultPenalty::MAX_OBJ_VALUE) {
-                            if (isValidPrior( move.nurse, assign[move.nurse2][move.weekday2].shift, move.weekday2 )
-                                && isValidPrior( move.nurse2, assign[move.nurse][move.weekday2].shift, move.weekday2 )) {
-                                if ((objValue + headDelta < optima.getObjValue())
-                                    || (objValue + move.delta < optima.getObjValue())) {
-                                    if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
-                                        bestMove = move;
-                                    }
-#ifdef INRC2_SWAP_CHAIN_MAKE_BAD_MOVE
-                                } else if (headDelta < bestDeltaForOneNurse) { // in case no swap meet requirement above
-                                    bestMoveForOneNurse = move;
-                                    bestDeltaForOneNurse = nurseDelta;
-#endif
-                                }
-                            }
-                        } else {    // two day off
-                            move.delta -= DefaultPenalty::FORBIDDEN_MOVE;
-                        }
-
-                        if (move.weekday2 >= Weekday::Sun) { break; }
-
-                        (const_cast<Solution*>(this))->swapNurse( move.weekday2, move.nurse, move.nurse2 );
-                        ++move.weekday2;
-                    }
-
-                    // recover original data
-                    while ((--move.weekday2) >= move.weekday) {
-                        (const_cast<Solution*>(this))->swapNurse( move.weekday2, move.nurse, move.nurse2 );
-                    }
-                }
+                buildBlockSwapRow( pm, move.nurse2, row2 );
+                sweepBlockSwap( pm, row, row2, move.nurse, move.nurse2, Weekday::Mon, Weekday::Sun, select );
             }
         }
-        penalty.recoverLastMode();
 
 #ifdef INRC2_SWAP_CHAIN_MAKE_BAD_MOVE
         if (bestMove.delta >= DefaultPenalty::MAX_OBJ_VALUE) {
-            bestMove = bestMoveForOneNurse;
+            bestMove = select.bestMoveForOneNurse;
         }
 #endif
         if (bestMove.delta >= DefaultPenalty::MAX_OBJ_VALUE) {
@@ -856,7 +822,7 @@ bool NurseRostering::Solution::genSwapChain( const Timer &timer, const Move &hea
     return false;
 }
 
-void NurseRostering::Solution::tabuSearch_Rand( const Timer &timer, const FindBestMoveTable &findBestMoveTable, IterCount maxNoImproveCount )
+void NurseRostering::Solution::tabuSearch_Rand( const Timer &timer, const ModeSeqPattern &modeSeqPat, IterCount maxNoImproveCount )
 {
 #ifdef INRC2_PERFORMANCE_TEST
     clock_t startTime = clock();
@@ -864,7 +830,7 @@ void NurseRostering::Solution::tabuSearch_Rand( const Timer &timer, const FindBe
 #endif
     optima = *this;
 
-    int modeNum = findBestMoveTable.size();
+    int modeNum = modeSeqPat.size();
 
     const int weight_Invalid = 128;     // min weight
     const int weight_NoImprove = 256;
@@ -881,23 +847,24 @@ void NurseRostering::Solution::tabuSearch_Rand( const Timer &timer, const FindBe
     IterCount noImprove = maxNoImproveCount;
     for (; !timer.isTimeOut() && (noImprove > 0)
         && (iterCount < problem.maxIterCount); ++iterCount) {
+        solver.yieldToPortfolio( iterCount );
         int modeSelect = 0;
-        for (int w = solver.randGen() % totalWeight; (w -= weights[modeSelect]) >= 0; ++modeSelect) {}
+        for (int w = evalContext.randGen() % totalWeight; (w -= weights[modeSelect]) >= 0; ++modeSelect) {}
 
         Move bestMove;
-        (this->*findBestMoveTable[modeSelect])(bestMove);
+        findBestMove( evalContext, modeSeqPat[modeSelect], bestMove );
 
         int weightDelta;
         if (bestMove.delta < DefaultPenalty::MAX_OBJ_VALUE) {
 #ifdef INRC2_USE_TABU
             // update tabu list first because it requires original assignment
-            ( this->*updateTabu[bestMove.mode] )(bestMove);
+            updateTabu( bestMove );
 #endif
             applyBasicMove( bestMove );
 
             if (updateOptima()) {   // improve optima
 #ifdef INRC2_LS_AFTER_TSR_UPDATE_OPT
-                localSearch( timer, findBestMoveTable );
+                localSearch( timer, modeSeqPat );
 #endif
                 noImprove = maxNoImproveCount;
                 weightDelta = (incError + weight_ImproveOpt - weights[modeSelect]) / deltaIncRatio;
@@ -928,7 +895,7 @@ void NurseRostering::Solution::tabuSearch_Rand( const Timer &timer, const FindBe
 #endif
 }
 
-void NurseRostering::Solution::tabuSearch_Loop( const Timer &timer, const FindBestMoveTable &findBestMoveTable, IterCount maxNoImproveCount )
+void NurseRostering::Solution::tabuSearch_Loop( const Timer &timer, const ModeSeqPattern &modeSeqPat, IterCount maxNoImproveCount )
 {
 #ifdef INRC2_PERFORMANCE_TEST
     clock_t startTime = clock();
@@ -936,7 +903,7 @@ void NurseRostering::Solution::tabuSearch_Loop( const Timer &timer, const FindBe
 #endif
     optima = *this;
 
-    int modeNum = findBestMoveTable.size();
+    int modeNum = modeSeqPat.size();
 
     int failCount = modeNum;
     int modeSelect = 0;
@@ -950,14 +917,15 @@ void NurseRostering::Solution::tabuSearch_Loop( const Timer &timer, const FindBe
         IterCount noImprove_Single = maxNoImproveCount;
         for (; !timer.isTimeOut() && (noImprove_Single > 0)
             && (iterCount < problem.maxIterCount); ++iterCount) {
+            solver.yieldToPortfolio( iterCount );
             Move bestMove;
-            (this->*findBestMoveTable[modeSelect])(bestMove);
+            findBestMove( evalContext, modeSeqPat[modeSelect], bestMove );
 
             if (bestMove.delta >= DefaultPenalty::MAX_OBJ_VALUE) { break; }
 
 #ifdef INRC2_USE_TABU
             // update tabu list first because it requires original assignment
-            ( this->*updateTabu[bestMove.mode] )(bestMove);
+            updateTabu( bestMove );
 #endif
             applyBasicMove( bestMove );
 
@@ -980,57 +948,116 @@ void NurseRostering::Solution::tabuSearch_Loop( const Timer &timer, const FindBe
 #endif
 }
 
-void NurseRostering::Solution::tabuSearch_Possibility( const Timer &timer, const FindBestMoveTable &findBestMoveTable, IterCount maxNoImproveCount )
+void NurseRostering::Solution::tabuSearch_Possibility( const Timer &timer, const ModeSeqPattern &modeSeqPat, IterCount maxNoImproveCount )
 {
 #ifdef INRC2_PERFORMANCE_TEST
     clock_t startTime = clock();
     IterCount startIterCount = iterCount;
+    Timer::Clock::duration totalLatency( 0 );
+    Timer::Clock::duration maxLatency( 0 );
 #endif
-    isPossibilitySelect = true;
+    evalContext.isPossibilitySelect = true;
 
     optima = *this;
 
-    int modeNum = findBestMoveTable.size();
+    int modeNum = modeSeqPat.size();
     int startMode = 0;
 
-    const unsigned maxP_local = (solver.randGen.max() - solver.randGen.min()) / modeNum;
-    const unsigned maxP_global = (solver.randGen.max() - solver.randGen.min()) * (modeNum - 1) / modeNum;
+    const unsigned maxP_local = (evalContext.randGen.max() - evalContext.randGen.min()) / modeNum;
+    const unsigned maxP_global = (evalContext.randGen.max() - evalContext.randGen.min()) * (modeNum - 1) / modeNum;
     const double amp_local = 1.0 / (2 * modeNum);
     const double amp_global = 1.0 / (4 * modeNum * modeNum);
     const double dec_local = (2.0 * modeNum - 1) / (2 * modeNum);
     const double dec_global = (2.0 * modeNum * modeNum - 1) / (2 * modeNum * modeNum);
-    unsigned P_global = (solver.randGen.max() - solver.randGen.min()) / modeNum;
+    unsigned P_global = (evalContext.randGen.max() - evalContext.randGen.min()) / modeNum;
     vector<unsigned> P_local( modeNum, 0 );
 
+    // each neighborhood is searched with its own context, so the selected ones
+    // can be searched concurrently on the same solution. the caches refreshed
+    // by them are disjoint for neighborhoods in any ModeSeqPattern
+    class Scan : public ThreadPool::Job
+    {
+    public:
+        Scan( const Solution &solution, const ModeSeqPattern &pattern, int workerNumber )
+            : sln( solution ), modeSeqPat( pattern ), workerNum( workerNumber ),
+            contexts( pattern.size(), solution.evalContext ), bestMoves( pattern.size() )
+        {
+        }
+
+        // the k-th selected neighborhood is searched by worker (k % workerNum)
+        virtual void operator()( int workerIndex )
+        {
+            for (int k = workerIndex; k < static_cast<int>(selectedModes.size()); k += workerNum) {
+                int i = selectedModes[k];
+                bestMoves[i] = Move();
+                sln.findBestMove( contexts[i], modeSeqPat[i], bestMoves[i] );
+            }
+        }
+
+        const Solution &sln;
+        const ModeSeqPattern &modeSeqPat;
+        const int workerNum;
+        std::vector<int> selectedModes;
+        std::vector<EvalContext> contexts;
+        std::vector<Move> bestMoves;
+    };
+
+    Scan scan( *this, modeSeqPat, (scanPool == NULL) ? 1 : scanPool->size() );
+    for (int i = 0; i < modeNum; ++i) { scan.contexts[i].randGen.seed( evalContext.randGen() ); }
+
     IterCount noImprove = maxNoImproveCount;
     for (; !timer.isTimeOut() && (noImprove > 0)
         && (iterCount < problem.maxIterCount); ++iterCount) {
+        solver.yieldToPortfolio( iterCount );
+#ifdef INRC2_PERFORMANCE_TEST
+        Timer::TimePoint iterStartTime = Timer::Clock::now();
+#endif
         int modeSelect = startMode;
-        Move::Mode moveMode = Move::Mode::SIZE;
         Move bestMove;
-        isBlockSwapSelected = false;
         // judge every neighborhood whether to select and search when selected
         // start from big end to make sure block swap will be tested before swap
+        bool isBlockSwapSelected = false;
+        scan.selectedModes.clear();
         for (int i = modeNum - 1; i >= 0; --i) {
-            if (solver.randGen() < (P_global + P_local[i] + solver.randGen.min())) { // selected
-                (this->*findBestMoveTable[i])(bestMove);
-                if (moveMode != bestMove.mode) {
-                    moveMode = bestMove.mode;
-                    modeSelect = i;
-                }
+            if (evalContext.randGen() < (P_global + P_local[i] + evalContext.randGen.min())) { // selected
+                scan.selectedModes.push_back( i );
+                isBlockSwapSelected |= (modeSeqPat[i] == Move::Mode::BlockSwap);
+            }
+        }
+        for (int i = 0; i < modeNum; ++i) { scan.contexts[i].isBlockSwapSelected = isBlockSwapSelected; }
+        if (!scan.selectedModes.empty()) {
+            if (scanPool == NULL) {
+                scan( 0 );
+            } else {
+                scanPool->run( scan );
+            }
+        }
+        // merge in the order of selection, a tie is broken as the first one in RandSelect
+        for (vector<int>::const_iterator iter = scan.selectedModes.begin();
+            iter != scan.selectedModes.end(); ++iter) {
+            const Move &move( scan.bestMoves[*iter] );
+            if ((move.delta < bestMove.delta)
+                || ((move.delta == bestMove.delta) && (evalContext.randGen() % 2))) {
+                bestMove = move;
+                modeSelect = *iter;
             }
         }
 
         // no one is selected
         while (bestMove.delta >= DefaultPenalty::MAX_OBJ_VALUE) {
-            (this->*findBestMoveTable[modeSelect])(bestMove);
+            findBestMove( scan.contexts[modeSelect], modeSeqPat[modeSelect], bestMove );
             modeSelect += (bestMove.delta >= DefaultPenalty::MAX_OBJ_VALUE);
             modeSelect %= modeNum;
         }
+#ifdef INRC2_PERFORMANCE_TEST
+        Timer::Clock::duration latency( Timer::Clock::now() - iterStartTime );
+        totalLatency += latency;
+        if (maxLatency < latency) { maxLatency = latency; }
+#endif
 
 #ifdef INRC2_USE_TABU
         // update tabu list first because it requires original assignment
-        ( this->*updateTabu[bestMove.mode] )(bestMove);
+        updateTabu( bestMove );
 #endif
         applyBasicMove( bestMove );
 
@@ -1046,16 +1073,19 @@ void NurseRostering::Solution::tabuSearch_Possibility( const Timer &timer, const
         }
     }
 
-    isPossibilitySelect = false;
+    evalContext.isPossibilitySelect = false;
 #ifdef INRC2_PERFORMANCE_TEST
     clock_t duration = clock() - startTime;
-    cout << "[TS] iter: " << (iterCount - startIterCount) << ' '
+    IterCount iterNum = iterCount - startIterCount;
+    cout << "[TS] iter: " << iterNum << ' '
         << "time: " << duration << ' '
-        << "speed: " << (iterCount - startIterCount) * static_cast<double>(CLOCKS_PER_SEC) / (duration + 1) << endl;
+        << "speed: " << iterNum * static_cast<double>(CLOCKS_PER_SEC) / (duration + 1) << ' '
+        << "latency(us): " << chrono::duration_cast<chrono::microseconds>(totalLatency).count() / (iterNum + 1) << ' '
+        << "max latency(us): " << chrono::duration_cast<chrono::microseconds>(maxLatency).count() << endl;
 #endif
 }
 
-void NurseRostering::Solution::localSearch( const Timer &timer, const FindBestMoveTable &findBestMoveTable )
+void NurseRostering::Solution::localSearch( const Timer &timer, const ModeSeqPattern &modeSeqPat, bool onBlockBorder )
 {
 #ifdef INRC2_PERFORMANCE_TEST
     clock_t startTime = clock();
@@ -1063,14 +1093,16 @@ void NurseRostering::Solution::localSearch( const Timer &timer, const FindBestMo
 #endif
     optima = *this;
 
-    int modeNum = findBestMoveTable.size();
+    int modeNum = modeSeqPat.size();
 
     int failCount = modeNum;
     int modeSelect = 0;
     while (!timer.isTimeOut() && (failCount > 0)
         && (iterCount != problem.maxIterCount)) {
+        solver.yieldToPortfolio( iterCount );
         Move bestMove;
-        if ((this->*findBestMoveTable[modeSelect])(bestMove)) {
+        if (onBlockBorder ? findBestMoveOnBlockBorder( evalContext, modeSeqPat[modeSelect], bestMove )
+            : findBestMove( evalContext, modeSeqPat[modeSelect], bestMove )) {
             applyBasicMove( bestMove );
             updateOptima();
             ++iterCount;
@@ -1099,19 +1131,20 @@ void NurseRostering::Solution::randomWalk( const Timer &timer, IterCount stepNum
     stepNum += iterCount;
     while ((iterCount < stepNum) && !timer.isTimeOut()
         && (iterCount < problem.maxIterCount)) {
+        solver.yieldToPortfolio( iterCount );
         Move move;
-        move.mode = static_cast<Move::Mode>(solver.randGen() % Move::Mode::BASIC_MOVE_SIZE);
-        move.weekday = (solver.randGen() % Weekday::NUM) + Weekday::Mon;
-        move.weekday2 = (solver.randGen() % Weekday::NUM) + Weekday::Mon;
+        move.mode = static_cast<Move::Mode>(evalContext.randGen() % Move::Mode::BASIC_MOVE_SIZE);
+        move.weekday = (evalContext.randGen() % Weekday::NUM) + Weekday::Mon;
+        move.weekday2 = (evalContext.randGen() % Weekday::NUM) + Weekday::Mon;
         if (move.weekday > move.weekday2) { swap( move.weekday, move.weekday2 ); }
-        move.nurse = solver.randGen() % problem.scenario.nurseNum;
-        move.nurse2 = solver.randGen() % problem.scenario.nurseNum;
+        move.nurse = evalContext.randGen() % problem.scenario->nurseNum;
+        move.nurse2 = evalContext.randGen() % problem.scenario->nurseNum;
         move.assign.shift = NurseRostering::Scenario::Shift::ID_BEGIN +
-            (solver.randGen() % problem.scenario.shiftTypeNum);
+            (evalContext.randGen() % problem.scenario->shiftTypeNum);
         move.assign.skill = NurseRostering::Scenario::Skill::ID_BEGIN +
-            (solver.randGen() % problem.scenario.skillTypeNum);
+            (evalContext.randGen() % problem.scenario->skillTypeNum);
 
-        move.delta = (this->*tryMove[move.mode])(move);
+        move.delta = tryMove( evalContext, move );
         if (move.delta < DefaultPenalty::MAX_OBJ_VALUE) {
             applyBasicMove( move );
             ++iterCount;
@@ -1129,15 +1162,180 @@ void NurseRostering::Solution::perturb( double strength )
 {
     // TODO : make this change solution structure in certain complexity
     int randomWalkStepCount = static_cast<int>(strength *
-        problem.scenario.shiftTypeNum * problem.scenario.nurseNum * Weekday::NUM);
+        problem.scenario->shiftTypeNum * problem.scenario->nurseNum * Weekday::NUM);
 
     randomWalk( solver.timer, randomWalkStepCount );
 
     updateOptima();
 }
 
+bool NurseRostering::Solution::pathRelinking( const Timer &timer, const AssignTable &target, Output &bestOnPath )
+{
+    vector<Move> diffs;
+    Move move;
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
+        for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
+            if (assign[move.nurse][move.weekday] != target[move.nurse][move.weekday]) {
+                diffs.push_back( move );
+            }
+        }
+    }
+
+    bool isPassed = false;
+    // the last day will make it the same as target
+    while ((diffs.size() > 1) && !timer.isTimeOut()) {
+        RandSelect<ObjValue> rs;
+        Move bestMove;
+        int bestIndex = 0;
+        for (int i = 0; i < static_cast<int>(diffs.size()); ++i) {
+            Move &m( diffs[i] );
+            m.assign = target[m.nurse][m.weekday];
+            if (!m.assign.isWorking()) {
+                m.mode = Move::Mode::Remove;
+            } else if (assign.isWorking( m.nurse, m.weekday )) {
+                m.mode = Move::Mode::Change;
+            } else {
+                m.mode = Move::Mode::Add;
+            }
+            m.delta = tryMove( evalContext, m );
+            if (rs.isMinimal( m.delta, bestMove.delta, evalContext.randGen )) {
+                bestMove = m;
+                bestIndex = i;
+            }
+        }
+        // the path is blocked by hard constraints
+        if (bestMove.delta >= DefaultPenalty::MAX_OBJ_VALUE) { break; }
+
+        applyBasicMove( bestMove );
+        diffs[bestIndex] = diffs.back();
+        diffs.pop_back();
+
+        if (!isPassed || (objValue < bestOnPath.getObjValue())) {
+            findTime = Timer::Clock::now();
+            bestOnPath = *this;
+            isPassed = true;
+        }
+    }
+
+    return isPassed;
+}
+
+bool NurseRostering::Solution::crossover( const Timer &timer, const AssignTable &parent, const AssignTable &parent2, bool isRowWise )
+{
+    resetAssign();
+    resetAssistData();
+
+    vector<const AssignTable*> rowParents( problem.scenario->nurseNum, &parent );
+    vector<const AssignTable*> columnParents( Weekday::SIZE, &parent );
+    if (isRowWise) {
+        for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
+            if (evalContext.randGen() % 2) { rowParents[nurse] = &parent2; }
+        }
+    } else {
+        for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
+            if (evalContext.randGen() % 2) { columnParents[weekday] = &parent2; }
+        }
+    }
+
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
+        for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
+            const AssignTable &p( isRowWise ? *rowParents[nurse] : *columnParents[weekday] );
+            if (p[nurse][weekday].isWorking()) {
+                addAssign( weekday, nurse, p[nurse][weekday] );
+            }
+        }
+    }
+
+    evaluateObjValue();
+    return repair( timer );
+}
+
+
+NurseRostering::ObjValue NurseRostering::Solution::tryMove( EvalContext &ctx, const Move &move ) const
+{
+    switch (move.mode) {
+        case Move::Mode::Add:
+            return tryAddAssign( move );
+        case Move::Mode::Remove:
+            return tryRemoveAssign( move );
+        case Move::Mode::Change:
+            return tryChangeAssign( move );
+        case Move::Mode::Exchange:
+            return tryExchangeDay( move );
+        case Move::Mode::Swap:
+            return trySwapNurse( move );
+        case Move::Mode::BlockSwap:
+            return trySwapBlock( ctx, move );
+        default:    // compound moves can not be tried directly
+            return DefaultPenalty::FORBIDDEN_MOVE;
+    }
+}
+
+bool NurseRostering::Solution::findBestMove( EvalContext &ctx, int mode, Move &bestMove ) const
+{
+    switch (mode) {
+        case Move::Mode::Add:
+            return findBestAdd( ctx, bestMove );
+        case Move::Mode::Remove:
+            return findBestRemove( ctx, bestMove );
+        case Move::Mode::Change:
+            return findBestChange( ctx, bestMove );
+        case Move::Mode::Exchange:
+            return findBestExchange( ctx, bestMove );
+        case Move::Mode::Swap:
+            return findBestSwap( ctx, bestMove );
+        case Move::Mode::BlockSwap:
+#if INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_ORGN
+            return findBestBlockSwap( ctx, bestMove );
+#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_CACHED
+            return findBestBlockSwap_cached( ctx, bestMove );
+#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_INDEXED
+            return findBestBlockSwap_indexed( ctx, bestMove );
+#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_FAST
+            return findBestBlockSwap_fast( ctx, bestMove );
+#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_PART
+            return findBestBlockSwap_part( ctx, bestMove );
+#elif INRC2_BLOCK_SWAP_FIND_BEST == INRC2_BLOCK_SWAP_RAND
+            return findBestBlockSwap_rand( ctx, bestMove );
+#endif
+        case Move::Mode::BlockShift:
+            return findBestBlockShift( ctx, bestMove );
+        case Move::Mode::ARLoop:
+            return findBestARLoop( ctx, bestMove );
+        case Move::Mode::ARRand:
+            return findBestARRand( ctx, bestMove );
+        case Move::Mode::ARBoth:
+            return findBestARBoth( ctx, bestMove );
+        default:
+            return false;
+    }
+}
 
-bool NurseRostering::Solution::findBestAdd( Move &bestMove ) const
+bool NurseRostering::Solution::findBestMoveOnBlockBorder( EvalContext &ctx, int mode, Move &bestMove ) const
+{
+    switch (mode) {
+        case Move::Mode::Add:
+            return findBestAddOnBlockBorder( ctx, bestMove );
+        case Move::Mode::Remove:
+            return findBestRemoveOnBlockBorder( ctx, bestMove );
+        case Move::Mode::Change:
+            return findBestChangeOnBlockBorder( ctx, bestMove );
+        case Move::Mode::Exchange:
+            return findBestExchangeOnBlockBorder( ctx, bestMove );
+        case Move::Mode::Swap:
+            return findBestSwapOnBlockBorder( ctx, bestMove );
+        case Move::Mode::ARLoop:
+            return findBestARLoopOnBlockBorder( ctx, bestMove );
+        case Move::Mode::ARRand:
+            return findBestARRandOnBlockBorder( ctx, bestMove );
+        case Move::Mode::ARBoth:
+            return findBestARBothOnBlockBorder( ctx, bestMove );
+        default:    // no block border version for BlockSwap and BlockShift
+            return findBestMove( ctx, mode, bestMove );
+    }
+}
+
+bool NurseRostering::Solution::findBestAdd( EvalContext &ctx, Move &bestMove ) const
 {
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
@@ -1145,25 +1343,27 @@ bool NurseRostering::Solution::findBestAdd( Move &bestMove ) const
     RandSelect<ObjValue> rs_tabu;
 #endif
 
+    const bool useCache = isAssignDeltaCacheEnabled();
+
     Move move;
     move.mode = Move::Mode::Add;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
             if (!assign.isWorking( move.nurse, move.weekday )) {
                 for (move.assign.shift = NurseRostering::Scenario::Shift::ID_BEGIN;
-                    move.assign.shift < problem.scenario.shiftSize; ++move.assign.shift) {
+                    move.assign.shift < problem.scenario->shiftSize; ++move.assign.shift) {
                     for (move.assign.skill = NurseRostering::Scenario::Skill::ID_BEGIN;
-                        move.assign.skill < problem.scenario.skillSize; ++move.assign.skill) {
-                        move.delta = tryAddAssign( move );
+                        move.assign.skill < problem.scenario->skillSize; ++move.assign.skill) {
+                        move.delta = useCache ? tryAddAssign_cached( move ) : tryAddAssign( move );
 #ifdef INRC2_USE_TABU
                         if (noAddTabu( move )) {
 #endif
-                            if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                            if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                                 bestMove = move;
                             }
 #ifdef INRC2_USE_TABU
                         } else {    // tabu
-                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                                 bestMove_tabu = move;
                             }
                         }
@@ -1172,6 +1372,7 @@ bool NurseRostering::Solution::findBestAdd( Move &bestMove ) const
                 }
             }
         }
+        if (useCache) { assignDeltaCache.isAddValid[move.nurse] = true; }
     }
 
 #ifdef INRC2_USE_TABU
@@ -1183,7 +1384,7 @@ bool NurseRostering::Solution::findBestAdd( Move &bestMove ) const
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestChange( Move &bestMove ) const
+bool NurseRostering::Solution::findBestChange( EvalContext &ctx, Move &bestMove ) const
 {
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
@@ -1191,25 +1392,27 @@ bool NurseRostering::Solution::findBestChange( Move &bestMove ) const
     RandSelect<ObjValue> rs_tabu;
 #endif
 
+    const bool useCache = isAssignDeltaCacheEnabled();
+
     Move move;
     move.mode = Move::Mode::Change;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
             if (assign.isWorking( move.nurse, move.weekday )) {
                 for (move.assign.shift = NurseRostering::Scenario::Shift::ID_BEGIN;
-                    move.assign.shift < problem.scenario.shiftSize; ++move.assign.shift) {
+                    move.assign.shift < problem.scenario->shiftSize; ++move.assign.shift) {
                     for (move.assign.skill = NurseRostering::Scenario::Skill::ID_BEGIN;
-                        move.assign.skill < problem.scenario.skillSize; ++move.assign.skill) {
-                        move.delta = tryChangeAssign( move );
+                        move.assign.skill < problem.scenario->skillSize; ++move.assign.skill) {
+                        move.delta = useCache ? tryChangeAssign_cached( move ) : tryChangeAssign( move );
 #ifdef INRC2_USE_TABU
                         if (noChangeTabu( move )) {
 #endif
-                            if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                            if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                                 bestMove = move;
                             }
 #ifdef INRC2_USE_TABU
                         } else {    // tabu
-                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                                 bestMove_tabu = move;
                             }
                         }
@@ -1218,6 +1421,7 @@ bool NurseRostering::Solution::findBestChange( Move &bestMove ) const
                 }
             }
         }
+        if (useCache) { assignDeltaCache.isChangeValid[move.nurse] = true; }
     }
 
 #ifdef INRC2_USE_TABU
@@ -1229,7 +1433,7 @@ bool NurseRostering::Solution::findBestChange( Move &bestMove ) const
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestRemove( Move &bestMove ) const
+bool NurseRostering::Solution::findBestRemove( EvalContext &ctx, Move &bestMove ) const
 {
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
@@ -1237,27 +1441,30 @@ bool NurseRostering::Solution::findBestRemove( Move &bestMove ) const
     RandSelect<ObjValue> rs_tabu;
 #endif
 
+    const bool useCache = isAssignDeltaCacheEnabled();
+
     Move move;
     move.mode = Move::Mode::Remove;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
             if (assign.isWorking( move.nurse, move.weekday )) {
-                move.delta = tryRemoveAssign( move );
+                move.delta = useCache ? tryRemoveAssign_cached( move ) : tryRemoveAssign( move );
 #ifdef INRC2_USE_TABU
                 if (noRemoveTabu( move )) {
 #endif
-                    if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                    if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                         bestMove = move;
                     }
 #ifdef INRC2_USE_TABU
                 } else {    // tabu
-                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                         bestMove_tabu = move;
                     }
                 }
 #endif
             }
         }
+        if (useCache) { assignDeltaCache.isRemoveValid[move.nurse] = true; }
     }
 
 #ifdef INRC2_USE_TABU
@@ -1269,14 +1476,12 @@ bool NurseRostering::Solution::findBestRemove( Move &bestMove ) const
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestSwap( Move &bestMove ) const
+bool NurseRostering::Solution::findBestSwap( EvalContext &ctx, Move &bestMove ) const
 {
-    if (isPossibilitySelect && isBlockSwapSelected) {
+    if (ctx.isPossibilitySelect && ctx.isBlockSwapSelected) {
         return false;
     }
 
-    penalty.setSwapMode();
-
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
     Move bestMove_tabu;
@@ -1285,28 +1490,42 @@ bool NurseRostering::Solution::findBestSwap( Move &bestMove ) const
 
     Move move;
     move.mode = Move::Mode::Swap;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
-        for (move.nurse2 = move.nurse + 1; move.nurse2 < problem.scenario.nurseNum; ++move.nurse2) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
+        for (move.nurse2 = move.nurse + 1; move.nurse2 < problem.scenario->nurseNum; ++move.nurse2) {
             if ((nurseWeights[move.nurse] == 0) && (nurseWeights[move.nurse2] == 0)) {
                 continue;
             }
+#ifdef INRC2_USE_SWAP_DELTA_CACHE
+            SwapCacheItem &cache( swapCache[move.nurse][move.nurse2] );
+            bool isCacheValid = (isSwapCacheValid[move.nurse] && isSwapCacheValid[move.nurse2]);
+#endif
             for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
-                move.delta = trySwapNurse( move.weekday, move.nurse, move.nurse2 );
+#ifdef INRC2_USE_SWAP_DELTA_CACHE
+                if (!isCacheValid) {
+                    cache.delta[move.weekday] = trySwapNurse( Penalty::SwapMode(), move.weekday, move.nurse, move.nurse2 ).delta;
+                }
+                move.delta = cache.delta[move.weekday];
+#else
+                move.delta = trySwapNurse( Penalty::SwapMode(), move.weekday, move.nurse, move.nurse2 ).delta;
+#endif
 #ifdef INRC2_USE_TABU
                 if (noSwapTabu( move )) {
 #endif
-                    if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                    if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                         bestMove = move;
                     }
 #ifdef INRC2_USE_TABU
                 } else {    // tabu
-                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                         bestMove_tabu = move;
                     }
                 }
 #endif
             }
         }
+#ifdef INRC2_USE_SWAP_DELTA_CACHE
+        isSwapCacheValid[move.nurse] = true;
+#endif
     }
 
 #ifdef INRC2_USE_TABU
@@ -1315,23 +1534,25 @@ bool NurseRostering::Solution::findBestSwap( Move &bestMove ) const
     }
 #endif
 
-    penalty.recoverLastMode();
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestBlockSwap( Move &bestMove ) const
+bool NurseRostering::Solution::findBestBlockSwap( EvalContext &ctx, Move &bestMove ) const
 {
-    const NurseID maxNurseID = problem.scenario.nurseNum - 1;
+    const NurseID maxNurseID = problem.scenario->nurseNum - 1;
 
-    isBlockSwapSelected = true;
-    penalty.setBlockSwapMode();
+    ctx.isBlockSwapSelected = true;
 
     RandSelect<ObjValue> rs;
 
+    const Penalty::BlockSwapMode pm;
+    vector<BlockSwapRow> rows;
+    buildBlockSwapRows( pm, rows );
+
     Move move;
     move.mode = Move::Mode::BlockSwap;
-    move.nurse = findBestBlockSwap_startNurse;
-    for (NurseID count = problem.scenario.nurseNum; count > 0; --count) {
+    move.nurse = ctx.findBestBlockSwap_startNurse;
+    for (NurseID count = problem.scenario->nurseNum; count > 0; --count) {
         (move.nurse < maxNurseID) ? (++move.nurse) : (move.nurse = 0);
         move.nurse2 = move.nurse;
         for (NurseID count2 = count - 1; count2 > 0; --count2) {
@@ -1341,13 +1562,13 @@ bool NurseRostering::Solution::findBestBlockSwap( Move &bestMove ) const
             }
             if (solver.haveSameSkill( move.nurse, move.nurse2 )) {
                 for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
-                    move.delta = trySwapBlock( move.weekday, move.weekday2, move.nurse, move.nurse2 );
-                    if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                    move.delta = trySwapBlock( ctx, pm, rows[move.nurse], rows[move.nurse2],
+                        move.weekday, move.weekday2, move.nurse, move.nurse2 ).delta;
+                    if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                         bestMove = move;
 #ifdef INRC2_BLOCK_SWAP_FIRST_IMPROVE
                         if (bestMove.delta < 0) {
-                            findBestBlockSwap_startNurse = move.nurse;
-                            penalty.recoverLastMode();
+                            ctx.findBestBlockSwap_startNurse = move.nurse;
                             return true;
                         }
 #endif
@@ -1357,39 +1578,32 @@ bool NurseRostering::Solution::findBestBlockSwap( Move &bestMove ) const
         }
     }
 
-    findBestBlockSwap_startNurse = move.nurse;
-    penalty.recoverLastMode();
+    ctx.findBestBlockSwap_startNurse = move.nurse;
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestBlockSwap_cached( Move &bestMove ) const
+bool NurseRostering::Solution::findBestBlockSwap_cached( EvalContext &ctx, Move &bestMove ) const
 {
-    isBlockSwapSelected = true;
-    penalty.setBlockSwapMode();
+    ctx.isBlockSwapSelected = true;
+
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
+        if (!isBlockSwapCacheValid[nurse]) { updateBlockSwapRow( nurse ); }
+    }
 
     RandSelect<ObjValue> rs;
 
     Move move;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
-        for (move.nurse2 = move.nurse + 1; move.nurse2 < problem.scenario.nurseNum; ++move.nurse2) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
+        for (move.nurse2 = move.nurse + 1; move.nurse2 < problem.scenario->nurseNum; ++move.nurse2) {
             if (((nurseWeights[move.nurse] == 0) && (nurseWeights[move.nurse2] == 0))
                 || !solver.haveSameSkill( move.nurse, move.nurse2 )) {
                 continue;
             }
-            BlockSwapCacheItem &cache( blockSwapCache[move.nurse][move.nurse2] );
             if (!(isBlockSwapCacheValid[move.nurse] && isBlockSwapCacheValid[move.nurse2])) {
-                RandSelect<ObjValue> rs_currentPair;
-                cache.delta = DefaultPenalty::FORBIDDEN_MOVE;
-                for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
-                    move.delta = trySwapBlock( move.weekday, move.weekday2, move.nurse, move.nurse2 );
-                    if (rs_currentPair.isMinimal( move.delta, cache.delta, solver.randGen )) {
-                        cache.delta = move.delta;
-                        cache.weekday = move.weekday;
-                        cache.weekday2 = move.weekday2;
-                    }
-                }
+                updateBlockSwapCache( ctx, move.nurse, move.nurse2 );
             }
-            if (rs.isMinimal( cache.delta, bestMove.delta, solver.randGen )) {
+            const BlockSwapCacheItem &cache( blockSwapCache[move.nurse][move.nurse2] );
+            if (rs.isMinimal( cache.delta, bestMove.delta, ctx.randGen )) {
                 bestMove.mode = Move::Mode::BlockSwap;
                 bestMove.delta = cache.delta;
                 bestMove.nurse = move.nurse;
@@ -1401,23 +1615,136 @@ bool NurseRostering::Solution::findBestBlockSwap_cached( Move &bestMove ) const
         isBlockSwapCacheValid[move.nurse] = true;
     }
 
-    penalty.recoverLastMode();
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestBlockSwap_fast( Move &bestMove ) const
+bool NurseRostering::Solution::findBestBlockSwap_indexed( EvalContext &ctx, Move &bestMove ) const
 {
-    const NurseID maxNurseID = problem.scenario.nurseNum - 1;
+    const NurseID nurseNum = problem.scenario->nurseNum;
+
+    ctx.isBlockSwapSelected = true;
+
+    for (NurseID nurse = 0; nurse < nurseNum; ++nurse) {
+        if (!isBlockSwapCacheValid[nurse]) { updateBlockSwapRow( nurse ); }
+    }
+    // only pairs with invalidated nurse need to be re-evaluated
+    std::vector<int> &refreshPairs( blockSwapRefreshPairs );
+    refreshPairs.clear();
+    for (NurseID nurse = 0; nurse < nurseNum; ++nurse) {
+        if (isBlockSwapCacheValid[nurse]) { continue; }
+        for (NurseID nurse2 = 0; nurse2 < nurseNum; ++nurse2) {
+            // pair of two invalidated nurses has been updated with the smaller one
+            if ((nurse2 == nurse) || (!isBlockSwapCacheValid[nurse2] && (nurse2 < nurse))) {
+                continue;
+            }
+            NurseID n = (nurse < nurse2) ? nurse : nurse2;
+            NurseID n2 = (nurse < nurse2) ? nurse2 : nurse;
+            int index = n * nurseNum + n2;
+            if (((nurseWeights[n] == 0) && (nurseWeights[n2] == 0))
+                || !solver.haveSameSkill( n, n2 )) {
+                blockSwapIndex.erase( index );
+                continue;
+            }
+            refreshPairs.push_back( index );
+        }
+    }
+
+    // the k-th chunk of refreshPairs is refreshed by worker (k % workerNum) and
+    // breaks ties with the k-th stream. the chunks are disjoint, so are the cache
+    // items, and a chunk does the same work on any worker. so the result is the
+    // same whether they are refreshed serially, nested in a running job, or on
+    // any number of workers, and nothing is seeded for the workers in each call
+    class Refresh : public ThreadPool::Job
+    {
+    public:
+        Refresh( const Solution &solution, int workerNumber )
+            : sln( solution ), workerNum( workerNumber ) {}
 
-    isBlockSwapSelected = true;
-    penalty.setBlockSwapMode();
+        virtual void operator()( int workerIndex )
+        {
+            const NurseID nurseNum = sln.problem.scenario->nurseNum;
+            const std::vector<int> &refreshPairs( sln.blockSwapRefreshPairs );
+            const int pairNum = static_cast<int>(refreshPairs.size());
+            for (int k = workerIndex; k < BLOCK_SWAP_REFRESH_CHUNK_NUM; k += workerNum) {
+                EvalContext &ctx( sln.blockSwapRefreshContexts[k] );
+                int end = pairNum * (k + 1) / BLOCK_SWAP_REFRESH_CHUNK_NUM;
+                for (int i = pairNum * k / BLOCK_SWAP_REFRESH_CHUNK_NUM; i < end; ++i) {
+                    sln.updateBlockSwapCache( ctx,
+                        refreshPairs[i] / nurseNum, refreshPairs[i] % nurseNum );
+                }
+            }
+        }
+
+    private:
+        const Solution &sln;
+        const int workerNum;
+    };
+
+    if (!refreshPairs.empty()) {
+        if (blockSwapRefreshContexts.empty()) {
+            blockSwapRefreshContexts.resize( BLOCK_SWAP_REFRESH_CHUNK_NUM );
+            for (std::vector<EvalContext>::iterator iter = blockSwapRefreshContexts.begin();
+                iter != blockSwapRefreshContexts.end(); ++iter) {
+                iter->randGen.seed( ctx.randGen() );
+            }
+        }
+        if ((scanPool == NULL) || (scanPool->size() <= 1)) {
+            Refresh refresh( *this, 1 );
+            refresh( 0 );
+        } else {    // it runs serially in the calling thread if it is nested
+            Refresh refresh( *this, scanPool->size() );
+            scanPool->run( refresh );
+        }
+    }
+
+    // the tournament tree is not thread safe, so it is updated after the refresh
+    for (std::vector<int>::const_iterator iter = refreshPairs.begin();
+        iter != refreshPairs.end(); ++iter) {
+        const BlockSwapCacheItem &cache( blockSwapCache[*iter / nurseNum][*iter % nurseNum] );
+        blockSwapIndex.update( *iter, cache.delta );
+    }
+    fill( isBlockSwapCacheValid.begin(), isBlockSwapCacheValid.end(), true );
+
+    if (blockSwapIndex.empty()) { return (bestMove.delta < 0); }
+
+    // the move in bestMove is one of the (minCount + 1) candidates on tie
+    // which keeps the same possibility as RandSelect in linear scan
+    ObjValue minDelta = blockSwapIndex.min();
+    if ((minDelta < bestMove.delta) || ((minDelta == bestMove.delta)
+        && ((ctx.randGen() % (blockSwapIndex.minCount() + 1)) != 0))) {
+        int index = blockSwapIndex.select( ctx.randGen );
+        NurseID nurse = index / nurseNum;
+        NurseID nurse2 = index % nurseNum;
+        const BlockSwapCacheItem &cache( blockSwapCache[nurse][nurse2] );
+        bestMove.mode = Move::Mode::BlockSwap;
+        bestMove.delta = cache.delta;
+        bestMove.nurse = nurse;
+        bestMove.nurse2 = nurse2;
+        bestMove.weekday = cache.weekday;
+        bestMove.weekday2 = cache.weekday2;
+    }
+
+    return (bestMove.delta < 0);
+}
+
+void NurseRostering::Solution::updateBlockSwapCache( EvalContext &ctx, NurseID nurse, NurseID nurse2 ) const
+{
+    BlockSwapCacheItem &cache( blockSwapCache[nurse][nurse2] );
+    cache.delta = trySwapBlock_sweep( ctx, cache.weekday, cache.weekday2, nurse, nurse2 );
+}
+
+bool NurseRostering::Solution::findBestBlockSwap_fast( EvalContext &ctx, Move &bestMove ) const
+{
+    const NurseID maxNurseID = problem.scenario->nurseNum - 1;
+
+    ctx.isBlockSwapSelected = true;
 
     RandSelect<ObjValue> rs;
 
     Move move;
     move.mode = Move::Mode::BlockSwap;
-    move.nurse = findBestBlockSwap_startNurse;
-    for (NurseID count = problem.scenario.nurseNum; count > 0; --count) {
+    move.nurse = ctx.findBestBlockSwap_startNurse;
+    for (NurseID count = problem.scenario->nurseNum; count > 0; --count) {
         (move.nurse < maxNurseID) ? (++move.nurse) : (move.nurse = 0);
         move.nurse2 = move.nurse;
         for (NurseID count2 = count - 1; count2 > 0; --count2) {
@@ -1426,13 +1753,12 @@ bool NurseRostering::Solution::findBestBlockSwap_fast( Move &bestMove ) const
                 continue;
             }
             if (solver.haveSameSkill( move.nurse, move.nurse2 )) {
-                move.delta = trySwapBlock_fast( move.weekday, move.weekday2, move.nurse, move.nurse2 );
-                if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                move.delta = trySwapBlock_fast( ctx, Penalty::BlockSwapMode(), move.weekday, move.weekday2, move.nurse, move.nurse2 ).delta;
+                if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                     bestMove = move;
 #ifdef INRC2_BLOCK_SWAP_FIRST_IMPROVE
                     if (bestMove.delta < 0) {
-                        findBestBlockSwap_startNurse = move.nurse;
-                        penalty.recoverLastMode();
+                        ctx.findBestBlockSwap_startNurse = move.nurse;
                         return true;
                     }
 #endif
@@ -1441,25 +1767,23 @@ bool NurseRostering::Solution::findBestBlockSwap_fast( Move &bestMove ) const
         }
     }
 
-    findBestBlockSwap_startNurse = move.nurse;
-    penalty.recoverLastMode();
+    ctx.findBestBlockSwap_startNurse = move.nurse;
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestBlockSwap_part( Move &bestMove ) const
+bool NurseRostering::Solution::findBestBlockSwap_part( EvalContext &ctx, Move &bestMove ) const
 {
-    const int nurseNum_noTry = problem.scenario.nurseNum - problem.scenario.nurseNum / 4;
-    const NurseID maxNurseID = problem.scenario.nurseNum - 1;
+    const int nurseNum_noTry = problem.scenario->nurseNum - problem.scenario->nurseNum / 4;
+    const NurseID maxNurseID = problem.scenario->nurseNum - 1;
 
-    isBlockSwapSelected = true;
-    penalty.setBlockSwapMode();
+    ctx.isBlockSwapSelected = true;
 
     RandSelect<ObjValue> rs;
 
     Move move;
     move.mode = Move::Mode::BlockSwap;
-    move.nurse = findBestBlockSwap_startNurse;
-    for (NurseID count = problem.scenario.nurseNum; count > nurseNum_noTry; --count) {
+    move.nurse = ctx.findBestBlockSwap_startNurse;
+    for (NurseID count = problem.scenario->nurseNum; count > nurseNum_noTry; --count) {
         (move.nurse < maxNurseID) ? (++move.nurse) : (move.nurse = 0);
         move.nurse2 = move.nurse;
         for (NurseID count2 = count - 1; count2 > 0; --count2) {
@@ -1468,13 +1792,12 @@ bool NurseRostering::Solution::findBestBlockSwap_part( Move &bestMove ) const
                 continue;
             }
             if (solver.haveSameSkill( move.nurse, move.nurse2 )) {
-                move.delta = trySwapBlock_fast( move.weekday, move.weekday2, move.nurse, move.nurse2 );
-                if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                move.delta = trySwapBlock_fast( ctx, Penalty::BlockSwapMode(), move.weekday, move.weekday2, move.nurse, move.nurse2 ).delta;
+                if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                     bestMove = move;
 #ifdef INRC2_BLOCK_SWAP_FIRST_IMPROVE
                     if (bestMove.delta < 0) {
-                        findBestBlockSwap_startNurse = move.nurse;
-                        penalty.recoverLastMode();
+                        ctx.findBestBlockSwap_startNurse = move.nurse;
                         return true;
                     }
 #endif
@@ -1483,25 +1806,23 @@ bool NurseRostering::Solution::findBestBlockSwap_part( Move &bestMove ) const
         }
     }
 
-    findBestBlockSwap_startNurse = move.nurse;
-    penalty.recoverLastMode();
+    ctx.findBestBlockSwap_startNurse = move.nurse;
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestBlockSwap_rand( Move &bestMove ) const
+bool NurseRostering::Solution::findBestBlockSwap_rand( EvalContext &ctx, Move &bestMove ) const
 {
-    const int nurseNum_noTry = problem.scenario.nurseNum - problem.scenario.nurseNum / 4;
-    const NurseID maxNurseID = problem.scenario.nurseNum - 1;
+    const int nurseNum_noTry = problem.scenario->nurseNum - problem.scenario->nurseNum / 4;
+    const NurseID maxNurseID = problem.scenario->nurseNum - 1;
 
-    isBlockSwapSelected = true;
-    penalty.setBlockSwapMode();
+    ctx.isBlockSwapSelected = true;
 
     RandSelect<ObjValue> rs;
 
     Move move;
     move.mode = Move::Mode::BlockSwap;
-    for (NurseID count = problem.scenario.nurseNum; count > nurseNum_noTry; --count) {
-        move.nurse = solver.randGen() % problem.scenario.nurseNum;
+    for (NurseID count = problem.scenario->nurseNum; count > nurseNum_noTry; --count) {
+        move.nurse = ctx.randGen() % problem.scenario->nurseNum;
         move.nurse2 = move.nurse;
         for (NurseID count2 = count - 1; count2 > 0; --count2) {
             (move.nurse2 < maxNurseID) ? (++move.nurse2) : (move.nurse2 = 0);
@@ -1509,13 +1830,12 @@ bool NurseRostering::Solution::findBestBlockSwap_rand( Move &bestMove ) const
                 continue;
             }
             if (solver.haveSameSkill( move.nurse, move.nurse2 )) {
-                move.delta = trySwapBlock_fast( move.weekday, move.weekday2, move.nurse, move.nurse2 );
-                if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                move.delta = trySwapBlock_fast( ctx, Penalty::BlockSwapMode(), move.weekday, move.weekday2, move.nurse, move.nurse2 ).delta;
+                if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                     bestMove = move;
 #ifdef INRC2_BLOCK_SWAP_FIRST_IMPROVE
                     if (bestMove.delta < 0) {
-                        findBestBlockSwap_startNurse = move.nurse;
-                        penalty.recoverLastMode();
+                        ctx.findBestBlockSwap_startNurse = move.nurse;
                         return true;
                     }
 #endif
@@ -1524,14 +1844,12 @@ bool NurseRostering::Solution::findBestBlockSwap_rand( Move &bestMove ) const
         }
     }
 
-    findBestBlockSwap_startNurse = move.nurse;
-    penalty.recoverLastMode();
+    ctx.findBestBlockSwap_startNurse = move.nurse;
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestExchange( Move &bestMove ) const
+bool NurseRostering::Solution::findBestExchange( EvalContext &ctx, Move &bestMove ) const
 {
-    penalty.setExchangeMode();
 
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
@@ -1541,19 +1859,19 @@ bool NurseRostering::Solution::findBestExchange( Move &bestMove ) const
 
     Move move;
     move.mode = Move::Mode::Exchange;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
             for (move.weekday2 = move.weekday + 1; move.weekday2 <= Weekday::Sun; ++move.weekday2) {
-                move.delta = tryExchangeDay( move.weekday, move.nurse, move.weekday2 );
+                move.delta = tryExchangeDay( Penalty::ExchangeMode(), move.weekday, move.nurse, move.weekday2 );
 #ifdef INRC2_USE_TABU
                 if (noExchangeTabu( move )) {
 #endif
-                    if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                    if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                         bestMove = move;
                     }
 #ifdef INRC2_USE_TABU
                 } else {    // tabu
-                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                         bestMove_tabu = move;
                     }
                 }
@@ -1568,13 +1886,11 @@ bool NurseRostering::Solution::findBestExchange( Move &bestMove ) const
     }
 #endif
 
-    penalty.recoverLastMode();
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestBlockShift( Move &bestMove ) const
+bool NurseRostering::Solution::findBestBlockShift( EvalContext &ctx, Move &bestMove ) const
 {
-    penalty.setExchangeMode();
 
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
@@ -1584,21 +1900,21 @@ bool NurseRostering::Solution::findBestBlockShift( Move &bestMove ) const
 
     Move move;
     move.mode = Move::Mode::Exchange;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         const Consecutive &c( consecutives[move.nurse] );
         move.weekday = Weekday::Mon;
         move.weekday2 = c.dayHigh[move.weekday] + 1;
         while (move.weekday2 <= Weekday::Sun) {
-            move.delta = tryExchangeDay( move.weekday, move.nurse, move.weekday2 );
+            move.delta = tryExchangeDay( Penalty::ExchangeMode(), move.weekday, move.nurse, move.weekday2 );
 #ifdef INRC2_USE_TABU
             if (noExchangeTabu( move )) {
 #endif
-                if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                     bestMove = move;
                 }
 #ifdef INRC2_USE_TABU
             } else {    // tabu
-                if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                     bestMove_tabu = move;
                 }
             }
@@ -1619,29 +1935,28 @@ bool NurseRostering::Solution::findBestBlockShift( Move &bestMove ) const
     }
 #endif
 
-    penalty.recoverLastMode();
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestARLoop( Move &bestMove ) const
+bool NurseRostering::Solution::findBestARLoop( EvalContext &ctx, Move &bestMove ) const
 {
     bool isImproved;
-    isImproved = findBestARLoop_flag
-        ? findBestAdd( bestMove ) : findBestRemove( bestMove );
+    isImproved = ctx.findBestARLoop_flag
+        ? findBestAdd( ctx, bestMove ) : findBestRemove( ctx, bestMove );
 
     if (!isImproved) {
-        findBestARLoop_flag = !findBestARLoop_flag;
+        ctx.findBestARLoop_flag = !ctx.findBestARLoop_flag;
     }
 
     return isImproved;
 }
 
-bool NurseRostering::Solution::findBestARRand( Move &bestMove ) const
+bool NurseRostering::Solution::findBestARRand( EvalContext &ctx, Move &bestMove ) const
 {
-    return ((solver.randGen() % 2) ? findBestAdd( bestMove ) : findBestRemove( bestMove ));
+    return ((ctx.randGen() % 2) ? findBestAdd( ctx, bestMove ) : findBestRemove( ctx, bestMove ));
 }
 
-bool NurseRostering::Solution::findBestARBoth( Move &bestMove ) const
+bool NurseRostering::Solution::findBestARBoth( EvalContext &ctx, Move &bestMove ) const
 {
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
@@ -1649,21 +1964,23 @@ bool NurseRostering::Solution::findBestARBoth( Move &bestMove ) const
     RandSelect<ObjValue> rs_tabu;
 #endif
 
+    const bool useCache = isAssignDeltaCacheEnabled();
+
     Move move;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun; ++move.weekday) {
             if (assign.isWorking( move.nurse, move.weekday )) {
-                move.delta = tryRemoveAssign( move );
+                move.delta = useCache ? tryRemoveAssign_cached( move ) : tryRemoveAssign( move );
 #ifdef INRC2_USE_TABU
                 if (noRemoveTabu( move )) {
 #endif
-                    if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                    if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                         bestMove = move;
                         bestMove.mode = Move::Mode::Remove;
                     }
 #ifdef INRC2_USE_TABU
                 } else {    // tabu
-                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                         bestMove_tabu = move;
                         bestMove_tabu.mode = Move::Mode::Remove;
                     }
@@ -1671,20 +1988,20 @@ bool NurseRostering::Solution::findBestARBoth( Move &bestMove ) const
 #endif
             } else {
                 for (move.assign.shift = NurseRostering::Scenario::Shift::ID_BEGIN;
-                    move.assign.shift < problem.scenario.shiftSize; ++move.assign.shift) {
+                    move.assign.shift < problem.scenario->shiftSize; ++move.assign.shift) {
                     for (move.assign.skill = NurseRostering::Scenario::Skill::ID_BEGIN;
-                        move.assign.skill < problem.scenario.skillSize; ++move.assign.skill) {
-                        move.delta = tryAddAssign( move );
+                        move.assign.skill < problem.scenario->skillSize; ++move.assign.skill) {
+                        move.delta = useCache ? tryAddAssign_cached( move ) : tryAddAssign( move );
 #ifdef INRC2_USE_TABU
                         if (noAddTabu( move )) {
 #endif
-                            if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                            if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                                 bestMove = move;
                                 bestMove.mode = Move::Mode::Add;
                             }
 #ifdef INRC2_USE_TABU
                         } else {    // tabu
-                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                                 bestMove_tabu = move;
                                 bestMove_tabu.mode = Move::Mode::Add;
                             }
@@ -1694,6 +2011,10 @@ bool NurseRostering::Solution::findBestARBoth( Move &bestMove ) const
                 }
             }
         }
+        if (useCache) {
+            assignDeltaCache.isAddValid[move.nurse] = true;
+            assignDeltaCache.isRemoveValid[move.nurse] = true;
+        }
     }
 
 #ifdef INRC2_USE_TABU
@@ -1705,7 +2026,7 @@ bool NurseRostering::Solution::findBestARBoth( Move &bestMove ) const
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestAddOnBlockBorder( Move &bestMove ) const
+bool NurseRostering::Solution::findBestAddOnBlockBorder( EvalContext &ctx, Move &bestMove ) const
 {
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
@@ -1715,24 +2036,24 @@ bool NurseRostering::Solution::findBestAddOnBlockBorder( Move &bestMove ) const
 
     Move move;
     move.mode = Move::Mode::Add;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         const Consecutive &c( consecutives[move.nurse] );
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun;) {
             if (!assign.isWorking( move.nurse, move.weekday )) {
                 for (move.assign.shift = NurseRostering::Scenario::Shift::ID_BEGIN;
-                    move.assign.shift < problem.scenario.shiftSize; ++move.assign.shift) {
+                    move.assign.shift < problem.scenario->shiftSize; ++move.assign.shift) {
                     for (move.assign.skill = NurseRostering::Scenario::Skill::ID_BEGIN;
-                        move.assign.skill < problem.scenario.skillSize; ++move.assign.skill) {
+                        move.assign.skill < problem.scenario->skillSize; ++move.assign.skill) {
                         move.delta = tryAddAssign( move );
 #ifdef INRC2_USE_TABU
                         if (noAddTabu( move )) {
 #endif
-                            if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                            if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                                 bestMove = move;
                             }
 #ifdef INRC2_USE_TABU
                         } else {    // tabu
-                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                                 bestMove_tabu = move;
                             }
                         }
@@ -1755,7 +2076,7 @@ bool NurseRostering::Solution::findBestAddOnBlockBorder( Move &bestMove ) const
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestChangeOnBlockBorder( Move &bestMove ) const
+bool NurseRostering::Solution::findBestChangeOnBlockBorder( EvalContext &ctx, Move &bestMove ) const
 {
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
@@ -1765,24 +2086,24 @@ bool NurseRostering::Solution::findBestChangeOnBlockBorder( Move &bestMove ) con
 
     Move move;
     move.mode = Move::Mode::Change;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         const Consecutive &c( consecutives[move.nurse] );
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun;) {
             if (assign.isWorking( move.nurse, move.weekday )) {
                 for (move.assign.shift = NurseRostering::Scenario::Shift::ID_BEGIN;
-                    move.assign.shift < problem.scenario.shiftSize; ++move.assign.shift) {
+                    move.assign.shift < problem.scenario->shiftSize; ++move.assign.shift) {
                     for (move.assign.skill = NurseRostering::Scenario::Skill::ID_BEGIN;
-                        move.assign.skill < problem.scenario.skillSize; ++move.assign.skill) {
+                        move.assign.skill < problem.scenario->skillSize; ++move.assign.skill) {
                         move.delta = tryChangeAssign( move );
 #ifdef INRC2_USE_TABU
                         if (noChangeTabu( move )) {
 #endif
-                            if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                            if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                                 bestMove = move;
                             }
 #ifdef INRC2_USE_TABU
                         } else {    // tabu
-                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                                 bestMove_tabu = move;
                             }
                         }
@@ -1805,7 +2126,7 @@ bool NurseRostering::Solution::findBestChangeOnBlockBorder( Move &bestMove ) con
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestRemoveOnBlockBorder( Move &bestMove ) const
+bool NurseRostering::Solution::findBestRemoveOnBlockBorder( EvalContext &ctx, Move &bestMove ) const
 {
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
@@ -1815,7 +2136,7 @@ bool NurseRostering::Solution::findBestRemoveOnBlockBorder( Move &bestMove ) con
 
     Move move;
     move.mode = Move::Mode::Remove;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         const Consecutive &c( consecutives[move.nurse] );
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun;) {
             if (assign.isWorking( move.nurse, move.weekday )) {
@@ -1823,12 +2144,12 @@ bool NurseRostering::Solution::findBestRemoveOnBlockBorder( Move &bestMove ) con
 #ifdef INRC2_USE_TABU
                 if (noRemoveTabu( move )) {
 #endif
-                    if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                    if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                         bestMove = move;
                     }
 #ifdef INRC2_USE_TABU
                 } else {    // tabu
-                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                         bestMove_tabu = move;
                     }
                 }
@@ -1849,14 +2170,12 @@ bool NurseRostering::Solution::findBestRemoveOnBlockBorder( Move &bestMove ) con
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestSwapOnBlockBorder( Move &bestMove ) const
+bool NurseRostering::Solution::findBestSwapOnBlockBorder( EvalContext &ctx, Move &bestMove ) const
 {
-    if (isPossibilitySelect && isBlockSwapSelected) {
+    if (ctx.isPossibilitySelect && ctx.isBlockSwapSelected) {
         return false;
     }
 
-    penalty.setSwapMode();
-
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
     Move bestMove_tabu;
@@ -1865,23 +2184,23 @@ bool NurseRostering::Solution::findBestSwapOnBlockBorder( Move &bestMove ) const
 
     Move move;
     move.mode = Move::Mode::Swap;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         const Consecutive &c( consecutives[move.nurse] );
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun;) {
-            for (move.nurse2 = 0; move.nurse2 < problem.scenario.nurseNum; ++move.nurse2) {
+            for (move.nurse2 = 0; move.nurse2 < problem.scenario->nurseNum; ++move.nurse2) {
                 if ((nurseWeights[move.nurse] == 0) && (nurseWeights[move.nurse2] == 0)) {
                     continue;
                 }
-                move.delta = trySwapNurse( move.weekday, move.nurse, move.nurse2 );
+                move.delta = trySwapNurse( Penalty::SwapMode(), move.weekday, move.nurse, move.nurse2 ).delta;
 #ifdef INRC2_USE_TABU
                 if (noSwapTabu( move )) {
 #endif
-                    if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                    if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                         bestMove = move;
                     }
 #ifdef INRC2_USE_TABU
                 } else {    // tabu
-                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                         bestMove_tabu = move;
                     }
                 }
@@ -1897,13 +2216,11 @@ bool NurseRostering::Solution::findBestSwapOnBlockBorder( Move &bestMove ) const
     }
 #endif
 
-    penalty.recoverLastMode();
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestExchangeOnBlockBorder( Move &bestMove ) const
+bool NurseRostering::Solution::findBestExchangeOnBlockBorder( EvalContext &ctx, Move &bestMove ) const
 {
-    penalty.setExchangeMode();
 
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
@@ -1913,20 +2230,20 @@ bool NurseRostering::Solution::findBestExchangeOnBlockBorder( Move &bestMove ) c
 
     Move move;
     move.mode = Move::Mode::Exchange;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         const Consecutive &c( consecutives[move.nurse] );
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun;) {
             for (move.weekday2 = Weekday::Mon; move.weekday2 <= Weekday::Sun; ++move.weekday2) {
-                move.delta = tryExchangeDay( move.weekday, move.nurse, move.weekday2 );
+                move.delta = tryExchangeDay( Penalty::ExchangeMode(), move.weekday, move.nurse, move.weekday2 );
 #ifdef INRC2_USE_TABU
                 if (noExchangeTabu( move )) {
 #endif
-                    if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                    if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                         bestMove = move;
                     }
 #ifdef INRC2_USE_TABU
                 } else {    // tabu
-                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                         bestMove_tabu = move;
                     }
                 }
@@ -1942,29 +2259,28 @@ bool NurseRostering::Solution::findBestExchangeOnBlockBorder( Move &bestMove ) c
     }
 #endif
 
-    penalty.recoverLastMode();
     return (bestMove.delta < 0);
 }
 
-bool NurseRostering::Solution::findBestARLoopOnBlockBorder( Move &bestMove ) const
+bool NurseRostering::Solution::findBestARLoopOnBlockBorder( EvalContext &ctx, Move &bestMove ) const
 {
     bool isImproved;
-    isImproved = findBestARLoopOnBlockBorder_flag
-        ? findBestAddOnBlockBorder( bestMove ) : findBestRemove( bestMove );
+    isImproved = ctx.findBestARLoopOnBlockBorder_flag
+        ? findBestAddOnBlockBorder( ctx, bestMove ) : findBestRemove( ctx, bestMove );
 
     if (!isImproved) {
-        findBestARLoopOnBlockBorder_flag = !findBestARLoopOnBlockBorder_flag;
+        ctx.findBestARLoopOnBlockBorder_flag = !ctx.findBestARLoopOnBlockBorder_flag;
     }
 
     return isImproved;
 }
 
-bool NurseRostering::Solution::findBestARRandOnBlockBorder( Move &bestMove ) const
+bool NurseRostering::Solution::findBestARRandOnBlockBorder( EvalContext &ctx, Move &bestMove ) const
 {
-    return ((solver.randGen() % 2) ? findBestAddOnBlockBorder( bestMove ) : findBestRemoveOnBlockBorder( bestMove ));
+    return ((ctx.randGen() % 2) ? findBestAddOnBlockBorder( ctx, bestMove ) : findBestRemoveOnBlockBorder( ctx, bestMove ));
 }
 
-bool NurseRostering::Solution::findBestARBothOnBlockBorder( Move &bestMove ) const
+bool NurseRostering::Solution::findBestARBothOnBlockBorder( EvalContext &ctx, Move &bestMove ) const
 {
     RandSelect<ObjValue> rs;
 #ifdef INRC2_USE_TABU
@@ -1973,7 +2289,7 @@ bool NurseRostering::Solution::findBestARBothOnBlockBorder( Move &bestMove ) con
 #endif
 
     Move move;
-    for (move.nurse = 0; move.nurse < problem.scenario.nurseNum; ++move.nurse) {
+    for (move.nurse = 0; move.nurse < problem.scenario->nurseNum; ++move.nurse) {
         const Consecutive &c( consecutives[move.nurse] );
         for (move.weekday = Weekday::Mon; move.weekday <= Weekday::Sun;) {
             if (assign.isWorking( move.nurse, move.weekday )) {
@@ -1981,13 +2297,13 @@ bool NurseRostering::Solution::findBestARBothOnBlockBorder( Move &bestMove ) con
 #ifdef INRC2_USE_TABU
                 if (noRemoveTabu( move )) {
 #endif
-                    if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                    if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                         bestMove = move;
                         bestMove.mode = Move::Mode::Remove;
                     }
 #ifdef INRC2_USE_TABU
                 } else {    // tabu
-                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                    if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                         bestMove_tabu = move;
                         bestMove_tabu.mode = Move::Mode::Remove;
                     }
@@ -1995,20 +2311,20 @@ bool NurseRostering::Solution::findBestARBothOnBlockBorder( Move &bestMove ) con
 #endif
             } else {
                 for (move.assign.shift = NurseRostering::Scenario::Shift::ID_BEGIN;
-                    move.assign.shift < problem.scenario.shiftSize; ++move.assign.shift) {
+                    move.assign.shift < problem.scenario->shiftSize; ++move.assign.shift) {
                     for (move.assign.skill = NurseRostering::Scenario::Skill::ID_BEGIN;
-                        move.assign.skill < problem.scenario.skillSize; ++move.assign.skill) {
+                        move.assign.skill < problem.scenario->skillSize; ++move.assign.skill) {
                         move.delta = tryAddAssign( move );
 #ifdef INRC2_USE_TABU
                         if (noAddTabu( move )) {
 #endif
-                            if (rs.isMinimal( move.delta, bestMove.delta, solver.randGen )) {
+                            if (rs.isMinimal( move.delta, bestMove.delta, ctx.randGen )) {
                                 bestMove = move;
                                 bestMove.mode = Move::Mode::Add;
                             }
 #ifdef INRC2_USE_TABU
                         } else {    // tabu
-                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, solver.randGen )) {
+                            if (rs_tabu.isMinimal( move.delta, bestMove_tabu.delta, ctx.randGen )) {
                                 bestMove_tabu = move;
                                 bestMove_tabu.mode = Move::Mode::Add;
                             }
@@ -2031,7 +2347,8 @@ bool NurseRostering::Solution::findBestARBothOnBlockBorder( Move &bestMove ) con
 }
 
 
-NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( int weekday, NurseID nurse, const Assign &a ) const
+template <typename PenaltyPolicy>
+NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( const PenaltyPolicy &pm, int weekday, NurseID nurse, const Assign &a ) const
 {
     ObjValue delta = 0;
 
@@ -2039,25 +2356,25 @@ NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( int weekday, Nu
     if (!a.isWorking() || assign.isWorking( nurse, weekday )) { return DefaultPenalty::FORBIDDEN_MOVE; }
 
     // hard constraint check
-    delta += penalty.MissSkill() * (!problem.scenario.nurses[nurse].skills[a.skill]);
+    delta += pm.MissSkill() * (!problem.scenario->nurses[nurse].hasSkill( a.skill ));
 
-    delta += penalty.Succession() * (!isValidSuccession( nurse, a.shift, weekday ));
-    delta += penalty.Succession() * (!isValidPrior( nurse, a.shift, weekday ));
+    delta += pm.Succession() * (!isValidSuccession( nurse, a.shift, weekday ));
+    delta += pm.Succession() * (!isValidPrior( nurse, a.shift, weekday ));
 
     if (delta >= DefaultPenalty::MAX_OBJ_VALUE) { return delta; }
 
     const WeekData &weekData( problem.weekData );
-    delta -= penalty.UnderStaff() * (weekData.minNurseNums[weekday][a.shift][a.skill] >
+    delta -= pm.UnderStaff() * (weekData.minNurseNums[weekday][a.shift][a.skill] >
         (weekData.optNurseNums[weekday][a.shift][a.skill] - missingNurseNums[weekday][a.shift][a.skill]));
 
     int prevDay = weekday - 1;
     int nextDay = weekday + 1;
-    ContractID contractID = problem.scenario.nurses[nurse].contract;
-    const Scenario::Contract &contract( problem.scenario.contracts[contractID] );
+    ContractID contractID = problem.scenario->nurses[nurse].contract;
+    const Scenario::Contract &contract( problem.scenario->contracts[contractID] );
     const Consecutive &c( consecutives[nurse] );
 
     // insufficient staff
-    delta -= penalty.InsufficientStaff() *
+    delta -= pm.InsufficientStaff() *
         (missingNurseNums[weekday][a.shift][a.skill] > 0);
 
     if (nurseWeights[nurse] == 0) {
@@ -2065,7 +2382,7 @@ NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( int weekday, Nu
     }
 
     // consecutive shift
-    const vector<Scenario::Shift> &shifts( problem.scenario.shifts );
+    const vector<Scenario::Shift> &shifts( problem.scenario->shifts );
     const Scenario::Shift &shift( shifts[a.shift] );
     ShiftID prevShiftID = assign[nurse][prevDay].shift;
     if (weekday == Weekday::Sun) {  // there is no blocks on the right
@@ -2073,13 +2390,13 @@ NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( int weekday, Nu
         if ((Weekday::Sun == c.shiftLow[weekday])
             && (a.shift == prevShiftID)) {
             const Scenario::Shift &prevShift( shifts[prevShiftID] );
-            delta -= penalty.ConsecutiveShift() *
+            delta -= pm.ConsecutiveShift() *
                 distanceToRange( Weekday::Sun - c.shiftLow[Weekday::Sat],
                 prevShift.minConsecutiveShiftNum, prevShift.maxConsecutiveShiftNum );
-            delta += penalty.ConsecutiveShift() * exceedCount(
+            delta += pm.ConsecutiveShift() * exceedCount(
                 Weekday::Sun - c.shiftLow[Weekday::Sat] + 1, shift.maxConsecutiveShiftNum );
         } else {    // have nothing to do with previous block
-            delta += penalty.ConsecutiveShift() *    // penalty on day off is counted later
+            delta += pm.ConsecutiveShift() *    // penalty on day off is counted later
                 exceedCount( 1, shift.maxConsecutiveShiftNum );
         }
     } else {
@@ -2090,31 +2407,31 @@ NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( int weekday, Nu
             if (prevShiftID == a.shift) {
                 const Scenario::Shift &prevShift( shifts[prevShiftID] );
                 low = c.shiftLow[prevDay];
-                delta -= penalty.ConsecutiveShift() *
+                delta -= pm.ConsecutiveShift() *
                     distanceToRange( weekday - c.shiftLow[prevDay],
                     prevShift.minConsecutiveShiftNum, prevShift.maxConsecutiveShiftNum );
             }
             if (nextShiftID == a.shift) {
                 const Scenario::Shift &nextShift( shifts[nextShiftID] );
                 high = c.shiftHigh[nextDay];
-                delta -= penalty.ConsecutiveShift() * penaltyDayNum(
+                delta -= pm.ConsecutiveShift() * penaltyDayNum(
                     c.shiftHigh[nextDay] - weekday, c.shiftHigh[nextDay],
                     nextShift.minConsecutiveShiftNum, nextShift.maxConsecutiveShiftNum );
             }
-            delta += penalty.ConsecutiveShift() * penaltyDayNum( high - low + 1, high,
+            delta += pm.ConsecutiveShift() * penaltyDayNum( high - low + 1, high,
                 shift.minConsecutiveShiftNum, shift.maxConsecutiveShiftNum );
         } else if (weekday == c.shiftHigh[weekday]) {
             if (a.shift == nextShiftID) {
                 const Scenario::Shift &nextShift( shifts[nextShiftID] );
                 int consecutiveShiftOfNextBlock = c.shiftHigh[nextDay] - weekday;
                 if (consecutiveShiftOfNextBlock >= nextShift.maxConsecutiveShiftNum) {
-                    delta += penalty.ConsecutiveShift();
+                    delta += pm.ConsecutiveShift();
                 } else if ((c.shiftHigh[nextDay] < Weekday::Sun)
                     && (consecutiveShiftOfNextBlock < nextShift.minConsecutiveShiftNum)) {
-                    delta -= penalty.ConsecutiveShift();
+                    delta -= pm.ConsecutiveShift();
                 }
             } else {
-                delta += penalty.ConsecutiveShift() * distanceToRange( 1,
+                delta += pm.ConsecutiveShift() * distanceToRange( 1,
                     shift.minConsecutiveShiftNum, shift.maxConsecutiveShiftNum );
             }
         } else if (weekday == c.shiftLow[weekday]) {
@@ -2122,16 +2439,16 @@ NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( int weekday, Nu
                 const Scenario::Shift &prevShift( shifts[prevShiftID] );
                 int consecutiveShiftOfPrevBlock = weekday - c.shiftLow[prevDay];
                 if (consecutiveShiftOfPrevBlock >= prevShift.maxConsecutiveShiftNum) {
-                    delta += penalty.ConsecutiveShift();
+                    delta += pm.ConsecutiveShift();
                 } else if (consecutiveShiftOfPrevBlock < prevShift.minConsecutiveShiftNum) {
-                    delta -= penalty.ConsecutiveShift();
+                    delta -= pm.ConsecutiveShift();
                 }
             } else {
-                delta += penalty.ConsecutiveShift() * distanceToRange( 1,
+                delta += pm.ConsecutiveShift() * distanceToRange( 1,
                     shift.minConsecutiveShiftNum, shift.maxConsecutiveShiftNum );
             }
         } else {
-            delta += penalty.ConsecutiveShift() * distanceToRange( 1,
+            delta += pm.ConsecutiveShift() * distanceToRange( 1,
                 shift.minConsecutiveShiftNum, shift.maxConsecutiveShiftNum );
         }
     }
@@ -2140,78 +2457,78 @@ NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( int weekday, Nu
     if (weekday == Weekday::Sun) {  // there is no block on the right
         // dayHigh[weekday] will always be equal to Weekday::Sun
         if (Weekday::Sun == c.dayLow[weekday]) {
-            delta -= penalty.ConsecutiveDay() *
+            delta -= pm.ConsecutiveDay() *
                 distanceToRange( Weekday::Sun - c.dayLow[Weekday::Sat],
                 contract.minConsecutiveDayNum, contract.maxConsecutiveDayNum );
-            delta -= penalty.ConsecutiveDayOff() *
+            delta -= pm.ConsecutiveDayOff() *
                 exceedCount( 1, contract.maxConsecutiveDayoffNum );
-            delta += penalty.ConsecutiveDay() * exceedCount(
+            delta += pm.ConsecutiveDay() * exceedCount(
                 Weekday::Sun - c.dayLow[Weekday::Sat] + 1, contract.maxConsecutiveDayNum );
         } else {    // day off block length over 1
-            delta -= penalty.ConsecutiveDayOff() * exceedCount(
+            delta -= pm.ConsecutiveDayOff() * exceedCount(
                 Weekday::Sun - c.dayLow[Weekday::Sun] + 1, contract.maxConsecutiveDayoffNum );
-            delta += penalty.ConsecutiveDayOff() * distanceToRange( Weekday::Sun - c.dayLow[Weekday::Sun],
+            delta += pm.ConsecutiveDayOff() * distanceToRange( Weekday::Sun - c.dayLow[Weekday::Sun],
                 contract.minConsecutiveDayoffNum, contract.maxConsecutiveDayoffNum );
-            delta += penalty.ConsecutiveDay() * exceedCount( 1, contract.maxConsecutiveDayNum );
+            delta += pm.ConsecutiveDay() * exceedCount( 1, contract.maxConsecutiveDayNum );
         }
     } else {
         if (c.dayHigh[weekday] == c.dayLow[weekday]) {
-            delta -= penalty.ConsecutiveDay() * distanceToRange( weekday - c.dayLow[prevDay],
+            delta -= pm.ConsecutiveDay() * distanceToRange( weekday - c.dayLow[prevDay],
                 contract.minConsecutiveDayNum, contract.maxConsecutiveDayNum );
-            delta -= penalty.ConsecutiveDayOff() * distanceToRange( 1,
+            delta -= pm.ConsecutiveDayOff() * distanceToRange( 1,
                 contract.minConsecutiveDayoffNum, contract.maxConsecutiveDayoffNum );
-            delta -= penalty.ConsecutiveDay() * penaltyDayNum(
+            delta -= pm.ConsecutiveDay() * penaltyDayNum(
                 c.dayHigh[nextDay] - weekday, c.dayHigh[nextDay],
                 contract.minConsecutiveDayNum, contract.maxConsecutiveDayNum );
-            delta += penalty.ConsecutiveDay() * penaltyDayNum(
+            delta += pm.ConsecutiveDay() * penaltyDayNum(
                 c.dayHigh[nextDay] - c.dayLow[prevDay] + 1, c.dayHigh[nextDay],
                 contract.minConsecutiveDayNum, contract.maxConsecutiveDayNum );
         } else if (weekday == c.dayHigh[weekday]) {
             int consecutiveDayOfNextBlock = c.dayHigh[nextDay] - weekday;
             if (consecutiveDayOfNextBlock >= contract.maxConsecutiveDayNum) {
-                delta += penalty.ConsecutiveDay();
+                delta += pm.ConsecutiveDay();
             } else if ((c.dayHigh[nextDay] < Weekday::Sun)
                 && (consecutiveDayOfNextBlock < contract.minConsecutiveDayNum)) {
-                delta -= penalty.ConsecutiveDay();
+                delta -= pm.ConsecutiveDay();
             }
             int consecutiveDayOfThisBlock = weekday - c.dayLow[weekday] + 1;
             if (consecutiveDayOfThisBlock > contract.maxConsecutiveDayoffNum) {
-                delta -= penalty.ConsecutiveDayOff();
+                delta -= pm.ConsecutiveDayOff();
             } else if (consecutiveDayOfThisBlock <= contract.minConsecutiveDayoffNum) {
-                delta += penalty.ConsecutiveDayOff();
+                delta += pm.ConsecutiveDayOff();
             }
         } else if (weekday == c.dayLow[weekday]) {
             int consecutiveDayOfPrevBlock = weekday - c.dayLow[prevDay];
             if (consecutiveDayOfPrevBlock >= contract.maxConsecutiveDayNum) {
-                delta += penalty.ConsecutiveDay();
+                delta += pm.ConsecutiveDay();
             } else if (consecutiveDayOfPrevBlock < contract.minConsecutiveDayNum) {
-                delta -= penalty.ConsecutiveDay();
+                delta -= pm.ConsecutiveDay();
             }
             int consecutiveDayOfThisBlock = c.dayHigh[weekday] - weekday + 1;
             if (consecutiveDayOfThisBlock > contract.maxConsecutiveDayoffNum) {
-                delta -= penalty.ConsecutiveDayOff();
+                delta -= pm.ConsecutiveDayOff();
             } else if ((c.dayHigh[weekday] < Weekday::Sun)
                 && (consecutiveDayOfThisBlock <= contract.minConsecutiveDayoffNum)) {
-                delta += penalty.ConsecutiveDayOff();
+                delta += pm.ConsecutiveDayOff();
             }
         } else {
-            delta -= penalty.ConsecutiveDayOff() * penaltyDayNum(
+            delta -= pm.ConsecutiveDayOff() * penaltyDayNum(
                 c.dayHigh[weekday] - c.dayLow[weekday] + 1, c.dayHigh[weekday],
                 contract.minConsecutiveDayoffNum, contract.maxConsecutiveDayoffNum );
-            delta += penalty.ConsecutiveDayOff() *
+            delta += pm.ConsecutiveDayOff() *
                 distanceToRange( weekday - c.dayLow[weekday],
                 contract.minConsecutiveDayoffNum, contract.maxConsecutiveDayoffNum );
-            delta += penalty.ConsecutiveDay() * distanceToRange( 1,
+            delta += pm.ConsecutiveDay() * distanceToRange( 1,
                 contract.minConsecutiveDayNum, contract.maxConsecutiveDayNum );
-            delta += penalty.ConsecutiveDayOff() * penaltyDayNum(
+            delta += pm.ConsecutiveDayOff() * penaltyDayNum(
                 c.dayHigh[weekday] - weekday, c.dayHigh[weekday],
                 contract.minConsecutiveDayoffNum, contract.maxConsecutiveDayoffNum );
         }
     }
 
     // preference
-    delta += penalty.Preference() *
-        weekData.shiftOffs[weekday][a.shift][nurse];
+    delta += pm.Preference() *
+        weekData.isShiftOff( nurse, weekday, a.shift );
 
     int currentWeek = problem.history.currentWeek;
     if (weekday > Weekday::Fri) {
@@ -2219,9 +2536,9 @@ NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( int weekday, Nu
         // complete weekend
         if (contract.completeWeekend) {
             if (assign.isWorking( nurse, theOtherDay )) {
-                delta -= penalty.CompleteWeekend();
+                delta -= pm.CompleteWeekend();
             } else {
-                delta += penalty.CompleteWeekend();
+                delta += pm.CompleteWeekend();
             }
         }
 
@@ -2229,47 +2546,55 @@ NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( int weekday, Nu
         if (!assign.isWorking( nurse, theOtherDay )) {
 #ifdef INRC2_AVERAGE_MAX_WORKING_WEEKEND
             const History &history( problem.history );
-            delta -= penalty.TotalWorkingWeekend() * exceedCount(
-                history.totalWorkingWeekendNums[nurse] * problem.scenario.totalWeekNum,
-                contract.maxWorkingWeekendNum * currentWeek ) / problem.scenario.totalWeekNum;
-            delta += penalty.TotalWorkingWeekend() * exceedCount(
-                (history.totalWorkingWeekendNums[nurse] + 1) * problem.scenario.totalWeekNum,
-                contract.maxWorkingWeekendNum * currentWeek ) / problem.scenario.totalWeekNum;
+            delta -= pm.TotalWorkingWeekend() * exceedCount(
+                history.totalWorkingWeekendNums[nurse] * problem.scenario->totalWeekNum,
+                contract.maxWorkingWeekendNum * currentWeek ) / problem.scenario->totalWeekNum;
+            delta += pm.TotalWorkingWeekend() * exceedCount(
+                (history.totalWorkingWeekendNums[nurse] + 1) * problem.scenario->totalWeekNum,
+                contract.maxWorkingWeekendNum * currentWeek ) / problem.scenario->totalWeekNum;
 #else
-            delta -= penalty.TotalWorkingWeekend() * exceedCount( 0,
-                problem.scenario.nurses[nurse].restMaxWorkingWeekendNum ) / problem.history.restWeekCount;
-            delta += penalty.TotalWorkingWeekend() * exceedCount( problem.history.restWeekCount,
-                problem.scenario.nurses[nurse].restMaxWorkingWeekendNum ) / problem.history.restWeekCount;
+            delta -= pm.TotalWorkingWeekend() * exceedCount( 0,
+                problem.restRanges[nurse].restMaxWorkingWeekendNum ) / problem.history.restWeekCount;
+            delta += pm.TotalWorkingWeekend() * exceedCount( problem.history.restWeekCount,
+                problem.restRanges[nurse].restMaxWorkingWeekendNum ) / problem.history.restWeekCount;
 #endif
         }
     }
 
     // total assign (expand problem.history.restWeekCount times)
 #ifdef INRC2_AVERAGE_TOTAL_SHIFT_NUM
-    int totalAssign = (totalAssignNums[nurse] + problem.history.totalAssignNums[nurse]) * problem.scenario.totalWeekNum;
-    delta -= penalty.TotalAssign() * distanceToRange( totalAssign,
-        contract.minShiftNum * currentWeek, contract.maxShiftNum * currentWeek ) / problem.scenario.totalWeekNum;
-    delta += penalty.TotalAssign() * distanceToRange( totalAssign + problem.scenario.totalWeekNum,
-        contract.minShiftNum * currentWeek, contract.maxShiftNum * currentWeek ) / problem.scenario.totalWeekNum;
+    int totalAssign = (totalAssignNums[nurse] + problem.history.totalAssignNums[nurse]) * problem.scenario->totalWeekNum;
+    delta -= pm.TotalAssign() * distanceToRange( totalAssign,
+        contract.minShiftNum * currentWeek, contract.maxShiftNum * currentWeek ) / problem.scenario->totalWeekNum;
+    delta += pm.TotalAssign() * distanceToRange( totalAssign + problem.scenario->totalWeekNum,
+        contract.minShiftNum * currentWeek, contract.maxShiftNum * currentWeek ) / problem.scenario->totalWeekNum;
 #else
-    int restMinShift = problem.scenario.nurses[nurse].restMinShiftNum;
-    int restMaxShift = problem.scenario.nurses[nurse].restMaxShiftNum;
+    int restMinShift = problem.restRanges[nurse].restMinShiftNum;
+    int restMaxShift = problem.restRanges[nurse].restMaxShiftNum;
     int totalAssign = totalAssignNums[nurse] * problem.history.restWeekCount;
-    delta -= penalty.TotalAssign() * distanceToRange( totalAssign,
+    delta -= pm.TotalAssign() * distanceToRange( totalAssign,
         restMinShift, restMaxShift ) / problem.history.restWeekCount;
-    delta += penalty.TotalAssign() * distanceToRange( totalAssign + problem.history.restWeekCount,
+    delta += pm.TotalAssign() * distanceToRange( totalAssign + problem.history.restWeekCount,
         restMinShift, restMaxShift ) / problem.history.restWeekCount;
 #endif
 
     return delta;   // TODO : weight ?
 }
 
+NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( int weekday, NurseID nurse, const Assign &a ) const
+{
+    return (penalty.isDefaultMode()
+        ? tryAddAssign( Penalty::DefaultMode(), weekday, nurse, a )
+        : tryAddAssign( penalty, weekday, nurse, a ));
+}
+
 NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign( const Move &move ) const
 {
     return tryAddAssign( move.weekday, move.nurse, move.assign );
 }
 
-NurseRostering::ObjValue NurseRostering::Solution::tryChangeAssign( int weekday, NurseID nurse, const Assign &a ) const
+template <typename PenaltyPolicy>
+NurseRostering::ObjValue NurseRostering::Solution::tryChangeAssign( const PenaltyPolicy &pm, int weekday, NurseID nurse, const Assign &a ) const
 {
     ObjValue delta = 0;
 
@@ -2281,21 +2606,21 @@ NurseRostering::ObjValue NurseRostering::Solution::tryChangeAssign( int weekday,
         return DefaultPenalty::FORBIDDEN_MOVE;
     }
 
-    delta += penalty.MissSkill() * (!problem.scenario.nurses[nurse].skills[a.skill]);
+    delta += pm.MissSkill() * (!problem.scenario->nurses[nurse].hasSkill( a.skill ));
 
-    delta += penalty.Succession() * (!isValidSuccession( nurse, a.shift, weekday ));
-    delta += penalty.Succession() * (!isValidPrior( nurse, a.shift, weekday ));
+    delta += pm.Succession() * (!isValidSuccession( nurse, a.shift, weekday ));
+    delta += pm.Succession() * (!isValidPrior( nurse, a.shift, weekday ));
 
     const WeekData &weekData( problem.weekData );
-    delta += penalty.UnderStaff() * (weekData.minNurseNums[weekday][oldShiftID][oldSkillID] >=
+    delta += pm.UnderStaff() * (weekData.minNurseNums[weekday][oldShiftID][oldSkillID] >=
         (weekData.optNurseNums[weekday][oldShiftID][oldSkillID] - missingNurseNums[weekday][oldShiftID][oldSkillID]));
 
     if (delta >= DefaultPenalty::MAX_OBJ_VALUE) { return delta; }
 
-    delta -= penalty.Succession() * (!isValidSuccession( nurse, oldShiftID, weekday ));
-    delta -= penalty.Succession() * (!isValidPrior( nurse, oldShiftID, weekday ));
+    delta -= pm.Succession() * (!isValidSuccession( nurse, oldShiftID, weekday ));
+    delta -= pm.Succession() * (!isValidPrior( nurse, oldShiftID, weekday ));
 
-    delta -= penalty.UnderStaff() * (weekData.minNurseNums[weekday][a.shift][a.skill] >
+    delta -= pm.UnderStaff() * (weekData.minNurseNums[weekday][a.shift][a.skill] >
         (weekData.optNurseNums[weekday][a.shift][a.skill] - missingNurseNums[weekday][a.shift][a.skill]));
 
     int prevDay = weekday - 1;
@@ -2303,9 +2628,9 @@ NurseRostering::ObjValue NurseRostering::Solution::tryChangeAssign( int weekday,
     const Consecutive &c( consecutives[nurse] );
 
     // insufficient staff
-    delta += penalty.InsufficientStaff() *
+    delta += pm.InsufficientStaff() *
         (missingNurseNums[weekday][oldShiftID][oldSkillID] >= 0);
-    delta -= penalty.InsufficientStaff() *
+    delta -= pm.InsufficientStaff() *
         (missingNurseNums[weekday][a.shift][a.skill] > 0);
 
     if (nurseWeights[nurse] == 0) {
@@ -2314,7 +2639,7 @@ NurseRostering::ObjValue NurseRostering::Solution::tryChangeAssign( int weekday,
 
     if (a.shift != oldShiftID) {
         // consecutive shift
-        const vector<Scenario::Shift> &shifts( problem.scenario.shifts );
+        const vector<Scenario::Shift> &shifts( problem.scenario->shifts );
         const Scenario::Shift &shift( shifts[a.shift] );
         const Scenario::Shift &oldShift( shifts[oldShiftID] );
         ShiftID prevShiftID = assign[nurse][prevDay].shift;
@@ -2323,25 +2648,25 @@ NurseRostering::ObjValue NurseRostering::Solution::tryChangeAssign( int weekday,
             if (Weekday::Sun == c.shiftLow[weekday]) {
                 if (a.shift == prevShiftID) {
                     const Scenario::Shift &prevShift( shifts[prevShiftID] );
-                    delta -= penalty.ConsecutiveShift() *
+                    delta -= pm.ConsecutiveShift() *
                         distanceToRange( Weekday::Sun - c.shiftLow[Weekday::Sat],
                         prevShift.minConsecutiveShiftNum, prevShift.maxConsecutiveShiftNum );
-                    delta -= penalty.ConsecutiveShift() *
+                    delta -= pm.ConsecutiveShift() *
                         exceedCount( 1, oldShift.maxConsecutiveShiftNum );
-                    delta += penalty.ConsecutiveShift() * exceedCount(
+                    delta += pm.ConsecutiveShift() * exceedCount(
                         Weekday::Sun - c.shiftLow[Weekday::Sat] + 1, shift.maxConsecutiveShiftNum );
                 } else {
-                    delta -= penalty.ConsecutiveShift() *
+                    delta -= pm.ConsecutiveShift() *
                         exceedCount( 1, oldShift.maxConsecutiveShiftNum );
-                    delta += penalty.ConsecutiveShift() *
+                    delta += pm.ConsecutiveShift() *
                         exceedCount( 1, shift.maxConsecutiveShiftNum );
                 }
             } else {    // block length over 1
-                delta -= penalty.ConsecutiveShift() * exceedCount(
+                delta -= pm.ConsecutiveShift() * exceedCount(
                     Weekday::Sun - c.shiftLow[Weekday::Sun] + 1, oldShift.maxConsecutiveShiftNum );
-                delta += penalty.ConsecutiveShift() * distanceToRange( Weekday::Sun - c.shiftLow[Weekday::Sun],
+                delta += pm.ConsecutiveShift() * distanceToRange( Weekday::Sun - c.shiftLow[Weekday::Sun],
                     oldShift.minConsecutiveShiftNum, oldShift.maxConsecutiveShiftNum );
-                delta += penalty.ConsecutiveShift() *
+                delta += pm.ConsecutiveShift() *
                     exceedCount( 1, shift.maxConsecutiveShiftNum );
             }
         } else {
@@ -2352,92 +2677,100 @@ NurseRostering::ObjValue NurseRostering::Solution::tryChangeAssign( int weekday,
                 if (prevShiftID == a.shift) {
                     const Scenario::Shift &prevShift( shifts[prevShiftID] );
                     low = c.shiftLow[prevDay];
-                    delta -= penalty.ConsecutiveShift() *
+                    delta -= pm.ConsecutiveShift() *
                         distanceToRange( weekday - c.shiftLow[prevDay],
                         prevShift.minConsecutiveShiftNum, prevShift.maxConsecutiveShiftNum );
                 }
                 if (nextShiftID == a.shift) {
                     const Scenario::Shift &nextShift( shifts[nextShiftID] );
                     high = c.shiftHigh[nextDay];
-                    delta -= penalty.ConsecutiveShift() * penaltyDayNum(
+                    delta -= pm.ConsecutiveShift() * penaltyDayNum(
                         c.shiftHigh[nextDay] - weekday, c.shiftHigh[nextDay],
                         nextShift.minConsecutiveShiftNum, nextShift.maxConsecutiveShiftNum );
                 }
-                delta -= penalty.ConsecutiveShift() * distanceToRange( 1,
+                delta -= pm.ConsecutiveShift() * distanceToRange( 1,
                     oldShift.minConsecutiveShiftNum, oldShift.maxConsecutiveShiftNum );
-                delta += penalty.ConsecutiveShift() * penaltyDayNum( high - low + 1, high,
+                delta += pm.ConsecutiveShift() * penaltyDayNum( high - low + 1, high,
                     shift.minConsecutiveShiftNum, shift.maxConsecutiveShiftNum );
             } else if (weekday == c.shiftHigh[weekday]) {
                 if (nextShiftID == a.shift) {
                     const Scenario::Shift &nextShift( shifts[nextShiftID] );
                     int consecutiveShiftOfNextBlock = c.shiftHigh[nextDay] - weekday;
                     if (consecutiveShiftOfNextBlock >= nextShift.maxConsecutiveShiftNum) {
-                        delta += penalty.ConsecutiveShift();
+                        delta += pm.ConsecutiveShift();
                     } else if ((c.shiftHigh[nextDay] < Weekday::Sun)
                         && (consecutiveShiftOfNextBlock < nextShift.minConsecutiveShiftNum)) {
-                        delta -= penalty.ConsecutiveShift();
+                        delta -= pm.ConsecutiveShift();
                     }
                 } else {
-                    delta += penalty.ConsecutiveShift() * distanceToRange( 1,
+                    delta += pm.ConsecutiveShift() * distanceToRange( 1,
                         shift.minConsecutiveShiftNum, shift.maxConsecutiveShiftNum );
                 }
                 int consecutiveShiftOfThisBlock = weekday - c.shiftLow[weekday] + 1;
                 if (consecutiveShiftOfThisBlock > oldShift.maxConsecutiveShiftNum) {
-                    delta -= penalty.ConsecutiveShift();
+                    delta -= pm.ConsecutiveShift();
                 } else if (consecutiveShiftOfThisBlock <= oldShift.minConsecutiveShiftNum) {
-                    delta += penalty.ConsecutiveShift();
+                    delta += pm.ConsecutiveShift();
                 }
             } else if (weekday == c.shiftLow[weekday]) {
                 if (prevShiftID == a.shift) {
                     const Scenario::Shift &prevShift( shifts[prevShiftID] );
                     int consecutiveShiftOfPrevBlock = weekday - c.shiftLow[prevDay];
                     if (consecutiveShiftOfPrevBlock >= prevShift.maxConsecutiveShiftNum) {
-                        delta += penalty.ConsecutiveShift();
+                        delta += pm.ConsecutiveShift();
                     } else if (consecutiveShiftOfPrevBlock < prevShift.minConsecutiveShiftNum) {
-                        delta -= penalty.ConsecutiveShift();
+                        delta -= pm.ConsecutiveShift();
                     }
                 } else {
-                    delta += penalty.ConsecutiveShift() * distanceToRange( 1,
+                    delta += pm.ConsecutiveShift() * distanceToRange( 1,
                         shift.minConsecutiveShiftNum, shift.maxConsecutiveShiftNum );
                 }
                 int consecutiveShiftOfThisBlock = c.shiftHigh[weekday] - weekday + 1;
                 if (consecutiveShiftOfThisBlock > oldShift.maxConsecutiveShiftNum) {
-                    delta -= penalty.ConsecutiveShift();
+                    delta -= pm.ConsecutiveShift();
                 } else if ((c.shiftHigh[weekday] < Weekday::Sun)
                     && (consecutiveShiftOfThisBlock <= oldShift.minConsecutiveShiftNum)) {
-                    delta += penalty.ConsecutiveShift();
+                    delta += pm.ConsecutiveShift();
                 }
             } else {
-                delta -= penalty.ConsecutiveShift() * penaltyDayNum(
+                delta -= pm.ConsecutiveShift() * penaltyDayNum(
                     c.shiftHigh[weekday] - c.shiftLow[weekday] + 1, c.shiftHigh[weekday],
                     oldShift.minConsecutiveShiftNum, oldShift.maxConsecutiveShiftNum );
-                delta += penalty.ConsecutiveShift() *
+                delta += pm.ConsecutiveShift() *
                     distanceToRange( weekday - c.shiftLow[weekday],
                     oldShift.minConsecutiveShiftNum, oldShift.maxConsecutiveShiftNum );
-                delta += penalty.ConsecutiveShift() * distanceToRange( 1,
+                delta += pm.ConsecutiveShift() * distanceToRange( 1,
                     shift.minConsecutiveShiftNum, shift.maxConsecutiveShiftNum );
-                delta += penalty.ConsecutiveShift() *
+                delta += pm.ConsecutiveShift() *
                     penaltyDayNum( c.shiftHigh[weekday] - weekday, c.shiftHigh[weekday],
                     oldShift.minConsecutiveShiftNum, oldShift.maxConsecutiveShiftNum );
             }
         }
 
         // preference
-        delta += penalty.Preference() *
-            weekData.shiftOffs[weekday][a.shift][nurse];
-        delta -= penalty.Preference() *
-            weekData.shiftOffs[weekday][oldShiftID][nurse];
+        delta += pm.Preference() *
+            weekData.isShiftOff( nurse, weekday, a.shift );
+        delta -= pm.Preference() *
+            weekData.isShiftOff( nurse, weekday, oldShiftID );
     }
 
     return delta;   // TODO : weight ?
 }
 
+NurseRostering::ObjValue NurseRostering::Solution::tryChangeAssign( int weekday, NurseID nurse, const Assign &a ) const
+{
+    return (penalty.isDefaultMode()
+        ? tryChangeAssign( Penalty::DefaultMode(), weekday, nurse, a )
+        : tryChangeAssign( penalty, weekday, nurse, a ));
+}
+
 NurseRostering::ObjValue NurseRostering::Solution::tryChangeAssign( const Move &move ) const
 {
     return tryChangeAssign( move.weekday, move.nurse, move.assign );
 }
 
-NurseRostering::ObjValue NurseRostering::Solution::tryRemoveAssign( int weekday, NurseID nurse ) const
+template <typename PenaltyPolicy>
+NurseRostering::ObjValue NurseRostering::Solution::tryRemoveAssign( const PenaltyPolicy &pm, int weekday, NurseID nurse ) const
 {
     ObjValue delta = 0;
 
@@ -2447,22 +2780,22 @@ NurseRostering::ObjValue NurseRostering::Solution::tryRemoveAssign( int weekday,
     if (!Assign::isWorking( oldShiftID )) { return DefaultPenalty::FORBIDDEN_MOVE; }
 
     const WeekData &weekData( problem.weekData );
-    delta += penalty.UnderStaff() * (weekData.minNurseNums[weekday][oldShiftID][oldSkillID] >=
+    delta += pm.UnderStaff() * (weekData.minNurseNums[weekday][oldShiftID][oldSkillID] >=
         (weekData.optNurseNums[weekday][oldShiftID][oldSkillID] - missingNurseNums[weekday][oldShiftID][oldSkillID]));
 
     if (delta >= DefaultPenalty::MAX_OBJ_VALUE) { return delta; }
 
-    delta -= penalty.Succession() * (!isValidSuccession( nurse, oldShiftID, weekday ));
-    delta -= penalty.Succession() * (!isValidPrior( nurse, oldShiftID, weekday ));
+    delta -= pm.Succession() * (!isValidSuccession( nurse, oldShiftID, weekday ));
+    delta -= pm.Succession() * (!isValidPrior( nurse, oldShiftID, weekday ));
 
     int prevDay = weekday - 1;
     int nextDay = weekday + 1;
-    ContractID contractID = problem.scenario.nurses[nurse].contract;
-    const Scenario::Contract &contract( problem.scenario.contracts[contractID] );
+    ContractID contractID = problem.scenario->nurses[nurse].contract;
+    const Scenario::Contract &contract( problem.scenario->contracts[contractID] );
     const Consecutive &c( consecutives[nurse] );
 
     // insufficient staff
-    delta += penalty.InsufficientStaff() *
+    delta += pm.InsufficientStaff() *
         (missingNurseNums[weekday][oldShiftID][oldSkillID] >= 0);
 
     if (nurseWeights[nurse] == 0) {
@@ -2470,43 +2803,43 @@ NurseRostering::ObjValue NurseRostering::Solution::tryRemoveAssign( int weekday,
     }
 
     // consecutive shift
-    const vector<Scenario::Shift> &shifts( problem.scenario.shifts );
+    const vector<Scenario::Shift> &shifts( problem.scenario->shifts );
     const Scenario::Shift &oldShift( shifts[oldShiftID] );
     if (weekday == Weekday::Sun) {  // there is no block on the right
         if (Weekday::Sun == c.shiftLow[weekday]) {
-            delta -= penalty.ConsecutiveShift() * exceedCount( 1, oldShift.maxConsecutiveShiftNum );
+            delta -= pm.ConsecutiveShift() * exceedCount( 1, oldShift.maxConsecutiveShiftNum );
         } else {
-            delta -= penalty.ConsecutiveShift() * exceedCount(
+            delta -= pm.ConsecutiveShift() * exceedCount(
                 Weekday::Sun - c.shiftLow[weekday] + 1, oldShift.maxConsecutiveShiftNum );
-            delta += penalty.ConsecutiveShift() * distanceToRange( Weekday::Sun - c.shiftLow[weekday],
+            delta += pm.ConsecutiveShift() * distanceToRange( Weekday::Sun - c.shiftLow[weekday],
                 oldShift.minConsecutiveShiftNum, oldShift.maxConsecutiveShiftNum );
         }
     } else {
         if (c.shiftHigh[weekday] == c.shiftLow[weekday]) {
-            delta -= penalty.ConsecutiveShift() * distanceToRange( 1,
+            delta -= pm.ConsecutiveShift() * distanceToRange( 1,
                 oldShift.minConsecutiveShiftNum, oldShift.maxConsecutiveShiftNum );
         } else if (weekday == c.shiftHigh[weekday]) {
             int consecutiveShiftOfThisBlock = weekday - c.shiftLow[weekday] + 1;
             if (consecutiveShiftOfThisBlock > oldShift.maxConsecutiveShiftNum) {
-                delta -= penalty.ConsecutiveShift();
+                delta -= pm.ConsecutiveShift();
             } else if (consecutiveShiftOfThisBlock <= oldShift.minConsecutiveShiftNum) {
-                delta += penalty.ConsecutiveShift();
+                delta += pm.ConsecutiveShift();
             }
         } else if (weekday == c.shiftLow[weekday]) {
             int consecutiveShiftOfThisBlock = c.shiftHigh[weekday] - weekday + 1;
             if (consecutiveShiftOfThisBlock > oldShift.maxConsecutiveShiftNum) {
-                delta -= penalty.ConsecutiveShift();
+                delta -= pm.ConsecutiveShift();
             } else if ((c.shiftHigh[weekday] < Weekday::Sun)
                 && (consecutiveShiftOfThisBlock <= oldShift.minConsecutiveShiftNum)) {
-                delta += penalty.ConsecutiveShift();
+                delta += pm.ConsecutiveShift();
             }
         } else {
-            delta -= penalty.ConsecutiveShift() * penaltyDayNum(
+            delta -= pm.ConsecutiveShift() * penaltyDayNum(
                 c.shiftHigh[weekday] - c.shiftLow[weekday] + 1, c.shiftHigh[weekday],
                 oldShift.minConsecutiveShiftNum, oldShift.maxConsecutiveShiftNum );
-            delta += penalty.ConsecutiveShift() * distanceToRange( weekday - c.shiftLow[weekday],
+            delta += pm.ConsecutiveShift() * distanceToRange( weekday - c.shiftLow[weekday],
                 oldShift.minConsecutiveShiftNum, oldShift.maxConsecutiveShiftNum );
-            delta += penalty.ConsecutiveShift() * penaltyDayNum(
+            delta += pm.ConsecutiveShift() * penaltyDayNum(
                 c.shiftHigh[weekday] - weekday, c.shiftHigh[weekday],
                 oldShift.minConsecutiveShiftNum, oldShift.maxConsecutiveShiftNum );
         }
@@ -2516,80 +2849,80 @@ NurseRostering::ObjValue NurseRostering::Solution::tryRemoveAssign( int weekday,
     if (weekday == Weekday::Sun) {  // there is no blocks on the right
         // dayHigh[weekday] will always be equal to Weekday::Sun
         if (Weekday::Sun == c.dayLow[weekday]) {
-            delta -= penalty.ConsecutiveDayOff() *
+            delta -= pm.ConsecutiveDayOff() *
                 distanceToRange( Weekday::Sun - c.dayLow[Weekday::Sat],
                 contract.minConsecutiveDayoffNum, contract.maxConsecutiveDayoffNum );
-            delta -= penalty.ConsecutiveDay() *
+            delta -= pm.ConsecutiveDay() *
                 exceedCount( 1, contract.maxConsecutiveDayNum );
-            delta += penalty.ConsecutiveDayOff() * exceedCount(
+            delta += pm.ConsecutiveDayOff() * exceedCount(
                 Weekday::Sun - c.dayLow[Weekday::Sat] + 1, contract.maxConsecutiveDayoffNum );
         } else {    // day off block length over 1
-            delta -= penalty.ConsecutiveDay() * exceedCount(
+            delta -= pm.ConsecutiveDay() * exceedCount(
                 Weekday::Sun - c.dayLow[Weekday::Sun] + 1, contract.maxConsecutiveDayNum );
-            delta += penalty.ConsecutiveDay() * distanceToRange( Weekday::Sun - c.dayLow[Weekday::Sun],
+            delta += pm.ConsecutiveDay() * distanceToRange( Weekday::Sun - c.dayLow[Weekday::Sun],
                 contract.minConsecutiveDayNum, contract.maxConsecutiveDayNum );
-            delta += penalty.ConsecutiveDayOff() * exceedCount( 1, contract.maxConsecutiveDayoffNum );
+            delta += pm.ConsecutiveDayOff() * exceedCount( 1, contract.maxConsecutiveDayoffNum );
         }
     } else {
         if (c.dayHigh[weekday] == c.dayLow[weekday]) {
-            delta -= penalty.ConsecutiveDayOff() *
+            delta -= pm.ConsecutiveDayOff() *
                 distanceToRange( weekday - c.dayLow[prevDay],
                 contract.minConsecutiveDayoffNum, contract.maxConsecutiveDayoffNum );
-            delta -= penalty.ConsecutiveDay() *
+            delta -= pm.ConsecutiveDay() *
                 distanceToRange( 1,
                 contract.minConsecutiveDayNum, contract.maxConsecutiveDayNum );
-            delta -= penalty.ConsecutiveDayOff() * penaltyDayNum(
+            delta -= pm.ConsecutiveDayOff() * penaltyDayNum(
                 c.dayHigh[nextDay] - weekday, c.dayHigh[nextDay],
                 contract.minConsecutiveDayoffNum, contract.maxConsecutiveDayoffNum );
-            delta += penalty.ConsecutiveDayOff() * penaltyDayNum(
+            delta += pm.ConsecutiveDayOff() * penaltyDayNum(
                 c.dayHigh[nextDay] - c.dayLow[prevDay] + 1, c.dayHigh[nextDay],
                 contract.minConsecutiveDayoffNum, contract.maxConsecutiveDayoffNum );
         } else if (weekday == c.dayHigh[weekday]) {
             int consecutiveDayOfNextBlock = c.dayHigh[nextDay] - weekday;
             if (consecutiveDayOfNextBlock >= contract.maxConsecutiveDayoffNum) {
-                delta += penalty.ConsecutiveDayOff();
+                delta += pm.ConsecutiveDayOff();
             } else if ((c.dayHigh[nextDay] < Weekday::Sun)
                 && (consecutiveDayOfNextBlock < contract.minConsecutiveDayoffNum)) {
-                delta -= penalty.ConsecutiveDayOff();
+                delta -= pm.ConsecutiveDayOff();
             }
             int consecutiveDayOfThisBlock = weekday - c.dayLow[weekday] + 1;
             if (consecutiveDayOfThisBlock > contract.maxConsecutiveDayNum) {
-                delta -= penalty.ConsecutiveDay();
+                delta -= pm.ConsecutiveDay();
             } else if (consecutiveDayOfThisBlock <= contract.minConsecutiveDayNum) {
-                delta += penalty.ConsecutiveDay();
+                delta += pm.ConsecutiveDay();
             }
         } else if (weekday == c.dayLow[weekday]) {
             int consecutiveDayOfPrevBlock = weekday - c.dayLow[prevDay];
             if (consecutiveDayOfPrevBlock >= contract.maxConsecutiveDayoffNum) {
-                delta += penalty.ConsecutiveDayOff();
+                delta += pm.ConsecutiveDayOff();
             } else if (consecutiveDayOfPrevBlock < contract.minConsecutiveDayoffNum) {
-                delta -= penalty.ConsecutiveDayOff();
+                delta -= pm.ConsecutiveDayOff();
             }
             int consecutiveDayOfThisBlock = c.dayHigh[weekday] - weekday + 1;
             if (consecutiveDayOfThisBlock > contract.maxConsecutiveDayNum) {
-                delta -= penalty.ConsecutiveDay();
+                delta -= pm.ConsecutiveDay();
             } else if ((c.dayHigh[weekday] < Weekday::Sun)
                 && (consecutiveDayOfThisBlock <= contract.minConsecutiveDayNum)) {
-                delta += penalty.ConsecutiveDay();
+                delta += pm.ConsecutiveDay();
             }
         } else {
-            delta -= penalty.ConsecutiveDay() * penaltyDayNum(
+            delta -= pm.ConsecutiveDay() * penaltyDayNum(
                 c.dayHigh[weekday] - c.dayLow[weekday] + 1, c.dayHigh[weekday],
                 contract.minConsecutiveDayNum, contract.maxConsecutiveDayNum );
-            delta += penalty.ConsecutiveDay() *
+            delta += pm.ConsecutiveDay() *
                 distanceToRange( weekday - c.dayLow[weekday],
                 contract.minConsecutiveDayNum, contract.maxConsecutiveDayNum );
-            delta += penalty.ConsecutiveDayOff() * distanceToRange( 1,
+            delta += pm.ConsecutiveDayOff() * distanceToRange( 1,
                 contract.minConsecutiveDayoffNum, contract.maxConsecutiveDayoffNum );
-            delta += penalty.ConsecutiveDay() *
+            delta += pm.ConsecutiveDay() *
                 penaltyDayNum( c.dayHigh[weekday] - weekday, c.dayHigh[weekday],
                 contract.minConsecutiveDayNum, contract.maxConsecutiveDayNum );
         }
     }
 
     // preference
-    delta -= penalty.Preference() *
-        weekData.shiftOffs[weekday][oldShiftID][nurse];
+    delta -= pm.Preference() *
+        weekData.isShiftOff( nurse, weekday, oldShiftID );
 
     int currentWeek = problem.history.currentWeek;
     if (weekday > Weekday::Fri) {
@@ -2597,9 +2930,9 @@ NurseRostering::ObjValue NurseRostering::Solution::tryRemoveAssign( int weekday,
         // complete weekend
         if (contract.completeWeekend) {
             if (assign.isWorking( nurse, theOtherDay )) {
-                delta += penalty.CompleteWeekend();
+                delta += pm.CompleteWeekend();
             } else {
-                delta -= penalty.CompleteWeekend();
+                delta -= pm.CompleteWeekend();
             }
         }
 
@@ -2607,359 +2940,600 @@ NurseRostering::ObjValue NurseRostering::Solution::tryRemoveAssign( int weekday,
         if (!assign.isWorking( nurse, theOtherDay )) {
 #ifdef INRC2_AVERAGE_MAX_WORKING_WEEKEND
             const History &history( problem.history );
-            delta -= penalty.TotalWorkingWeekend() * exceedCount(
-                (history.totalWorkingWeekendNums[nurse] + 1) * problem.scenario.totalWeekNum,
-                contract.maxWorkingWeekendNum * currentWeek ) / problem.scenario.totalWeekNum;
-            delta += penalty.TotalWorkingWeekend() * exceedCount(
-                history.totalWorkingWeekendNums[nurse] * problem.scenario.totalWeekNum,
-                contract.maxWorkingWeekendNum * currentWeek ) / problem.scenario.totalWeekNum;
+            delta -= pm.TotalWorkingWeekend() * exceedCount(
+                (history.totalWorkingWeekendNums[nurse] + 1) * problem.scenario->totalWeekNum,
+                contract.maxWorkingWeekendNum * currentWeek ) / problem.scenario->totalWeekNum;
+            delta += pm.TotalWorkingWeekend() * exceedCount(
+                history.totalWorkingWeekendNums[nurse] * problem.scenario->totalWeekNum,
+                contract.maxWorkingWeekendNum * currentWeek ) / problem.scenario->totalWeekNum;
 #else
-            delta -= penalty.TotalWorkingWeekend() * exceedCount( problem.history.restWeekCount,
-                problem.scenario.nurses[nurse].restMaxWorkingWeekendNum ) / problem.history.restWeekCount;
-            delta += penalty.TotalWorkingWeekend() * exceedCount( 0,
-                problem.scenario.nurses[nurse].restMaxWorkingWeekendNum ) / problem.history.restWeekCount;
+            delta -= pm.TotalWorkingWeekend() * exceedCount( problem.history.restWeekCount,
+                problem.restRanges[nurse].restMaxWorkingWeekendNum ) / problem.history.restWeekCount;
+            delta += pm.TotalWorkingWeekend() * exceedCount( 0,
+                problem.restRanges[nurse].restMaxWorkingWeekendNum ) / problem.history.restWeekCount;
 #endif
         }
     }
 
     // total assign (expand problem.history.restWeekCount times)
 #ifdef INRC2_AVERAGE_TOTAL_SHIFT_NUM
-    int totalAssign = (totalAssignNums[nurse] + problem.history.totalAssignNums[nurse]) * problem.scenario.totalWeekNum;
-    delta -= penalty.TotalAssign() * distanceToRange( totalAssign,
-        contract.minShiftNum * currentWeek, contract.maxShiftNum * currentWeek ) / problem.scenario.totalWeekNum;
-    delta += penalty.TotalAssign() * distanceToRange( totalAssign - problem.scenario.totalWeekNum,
-        contract.minShiftNum * currentWeek, contract.maxShiftNum * currentWeek ) / problem.scenario.totalWeekNum;
+    int totalAssign = (totalAssignNums[nurse] + problem.history.totalAssignNums[nurse]) * problem.scenario->totalWeekNum;
+    delta -= pm.TotalAssign() * distanceToRange( totalAssign,
+        contract.minShiftNum * currentWeek, contract.maxShiftNum * currentWeek ) / problem.scenario->totalWeekNum;
+    delta += pm.TotalAssign() * distanceToRange( totalAssign - problem.scenario->totalWeekNum,
+        contract.minShiftNum * currentWeek, contract.maxShiftNum * currentWeek ) / problem.scenario->totalWeekNum;
 #else
-    int restMinShift = problem.scenario.nurses[nurse].restMinShiftNum;
-    int restMaxShift = problem.scenario.nurses[nurse].restMaxShiftNum;
+    int restMinShift = problem.restRanges[nurse].restMinShiftNum;
+    int restMaxShift = problem.restRanges[nurse].restMaxShiftNum;
     int totalAssign = totalAssignNums[nurse] * problem.history.restWeekCount;
-    delta -= penalty.TotalAssign() * distanceToRange( totalAssign,
+    delta -= pm.TotalAssign() * distanceToRange( totalAssign,
         restMinShift, restMaxShift ) / problem.history.restWeekCount;
-    delta += penalty.TotalAssign() * distanceToRange( totalAssign - problem.history.restWeekCount,
+    delta += pm.TotalAssign() * distanceToRange( totalAssign - problem.history.restWeekCount,
         restMinShift, restMaxShift ) / problem.history.restWeekCount;
 #endif
 
     return delta;   // TODO : weight ?
 }
 
+NurseRostering::ObjValue NurseRostering::Solution::tryRemoveAssign( int weekday, NurseID nurse ) const
+{
+    return (penalty.isDefaultMode()
+        ? tryRemoveAssign( Penalty::DefaultMode(), weekday, nurse )
+        : tryRemoveAssign( penalty, weekday, nurse ));
+}
+
 NurseRostering::ObjValue NurseRostering::Solution::tryRemoveAssign( const Move &move ) const
 {
     return tryRemoveAssign( move.weekday, move.nurse );
 }
 
-NurseRostering::ObjValue NurseRostering::Solution::trySwapNurse( int weekday, NurseID nurse, NurseID nurse2 ) const
+bool NurseRostering::Solution::isAssignDeltaCacheEnabled() const
+{
+#ifdef INRC2_USE_ASSIGN_DELTA_CACHE
+    // cached part is evaluated with fixed weights
+    return penalty.isDefaultMode();
+#else
+    return false;
+#endif
+}
+
+NurseRostering::ObjValue NurseRostering::Solution::tryAddAssign_cached( const Move &move ) const
+{
+    const Assign &a( move.assign );
+    ObjValue &delta( assignDeltaCache.assignDelta( move.nurse, move.weekday, a ) );
+    if (!assignDeltaCache.isAddValid[move.nurse]) {
+        // swap mode leaves out UnderStaff and InsufficientStaff
+        delta = tryAddAssign( Penalty::SwapMode(), move.weekday, move.nurse, a );
+    }
+
+    // hard constraints on the nurse are violated
+    if (delta >= DefaultPenalty::MAX_OBJ_VALUE) { return delta; }
+
+    const WeekData &weekData( problem.weekData );
+    const int missingNurseNum = missingNurseNums[move.weekday][a.shift][a.skill];
+    return (delta
+        - DefaultPenalty::UnderStaff * (weekData.minNurseNums[move.weekday][a.shift][a.skill] >
+        (weekData.optNurseNums[move.weekday][a.shift][a.skill] - missingNurseNum))
+        - DefaultPenalty::InsufficientStaff * (missingNurseNum > 0));
+}
+
+NurseRostering::ObjValue NurseRostering::Solution::tryChangeAssign_cached( const Move &move ) const
+{
+    const Assign &a( move.assign );
+    const Assign &oldAssign( assign[move.nurse][move.weekday] );
+    if (a == oldAssign) { return DefaultPenalty::FORBIDDEN_MOVE; }
+
+    ObjValue &delta( assignDeltaCache.assignDelta( move.nurse, move.weekday, a ) );
+    if (!assignDeltaCache.isChangeValid[move.nurse]) {
+        delta = tryChangeAssign( Penalty::SwapMode(), move.weekday, move.nurse, a );
+    }
+
+    const WeekData &weekData( problem.weekData );
+    const int oldMissingNurseNum = missingNurseNums[move.weekday][oldAssign.shift][oldAssign.skill];
+    if (weekData.minNurseNums[move.weekday][oldAssign.shift][oldAssign.skill] >=
+        (weekData.optNurseNums[move.weekday][oldAssign.shift][oldAssign.skill] - oldMissingNurseNum)) {
+        // tryChangeAssign() returns before considering other terms
+        return (DefaultPenalty::UnderStaff + DefaultPenalty::MissSkill
+            * (!problem.scenario->nurses[move.nurse].hasSkill( a.skill ))
+            + DefaultPenalty::Succession * (!isValidSuccession( move.nurse, a.shift, move.weekday ))
+            + DefaultPenalty::Succession * (!isValidPrior( move.nurse, a.shift, move.weekday )));
+    }
+
+    if (delta >= DefaultPenalty::MAX_OBJ_VALUE) { return delta; }
+
+    const int missingNurseNum = missingNurseNums[move.weekday][a.shift][a.skill];
+    return (delta
+        - DefaultPenalty::UnderStaff * (weekData.minNurseNums[move.weekday][a.shift][a.skill] >
+        (weekData.optNurseNums[move.weekday][a.shift][a.skill] - missingNurseNum))
+        + DefaultPenalty::InsufficientStaff * (oldMissingNurseNum >= 0)
+        - DefaultPenalty::InsufficientStaff * (missingNurseNum > 0));
+}
+
+NurseRostering::ObjValue NurseRostering::Solution::tryRemoveAssign_cached( const Move &move ) const
+{
+    // always refresh the cache since the flag will be set for all days
+    ObjValue &delta( assignDeltaCache.removeDelta( move.nurse, move.weekday ) );
+    if (!assignDeltaCache.isRemoveValid[move.nurse]) {
+        delta = tryRemoveAssign( Penalty::SwapMode(), move.weekday, move.nurse );
+    }
+
+    const WeekData &weekData( problem.weekData );
+    const Assign &oldAssign( assign[move.nurse][move.weekday] );
+    const int oldMissingNurseNum = missingNurseNums[move.weekday][oldAssign.shift][oldAssign.skill];
+    if (weekData.minNurseNums[move.weekday][oldAssign.shift][oldAssign.skill] >=
+        (weekData.optNurseNums[move.weekday][oldAssign.shift][oldAssign.skill] - oldMissingNurseNum)) {
+        return DefaultPenalty::UnderStaff;
+    }
+
+    return (delta + DefaultPenalty::InsufficientStaff * (oldMissingNurseNum >= 0));
+}
+
+void NurseRostering::Solution::BlockSwapSelector::operator()( int w, int w2, const SwapDelta &swapDelta, bool isNoTabu )
+{
+#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
+    if (!isNoTabu) {
+        if (rs_tabu.isMinimal( swapDelta.delta, best_tabu.delta, randGen )) {
+            best_tabu = swapDelta;
+            weekday_tabu = w;
+            weekday2_tabu = w2;
+        }
+        return;
+    }
+#else
+    (void)isNoTabu; // all block swaps are not tabu
+#endif
+    if (rs.isMinimal( swapDelta.delta, best.delta, randGen )) {
+        best = swapDelta;
+        weekday = w;
+        weekday2 = w2;
+    }
+}
+
+NurseRostering::Solution::SwapDelta NurseRostering::Solution::BlockSwapSelector::getBest( int &w, int &w2 ) const
 {
+#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
+    if (sln.aspirationCritiera( best.delta, best_tabu.delta )) {
+        w = weekday_tabu;
+        w2 = weekday2_tabu;
+        return best_tabu;
+    }
+#endif
+    w = weekday;
+    w2 = weekday2;
+    return best;
+}
+
+template <typename PenaltyPolicy>
+NurseRostering::Solution::SwapDelta NurseRostering::Solution::trySwapNurse( const PenaltyPolicy &pm, int weekday, NurseID nurse, NurseID nurse2 ) const
+{
+    SwapDelta swapDelta;
+
     // TODO : make sure they won't be the same and leave out this
-    if (nurse == nurse2) { return DefaultPenalty::FORBIDDEN_MOVE; }
+    if (nurse == nurse2) { return swapDelta; }
 
     if (assign.isWorking( nurse, weekday )) {
         if (assign.isWorking( nurse2, weekday )) {
-            nurseDelta = tryChangeAssign( weekday, nurse, assign[nurse2][weekday] );
-            nurse2Delta = ((nurseDelta >= DefaultPenalty::MAX_OBJ_VALUE)
-                ? 0 : tryChangeAssign( weekday, nurse2, assign[nurse][weekday] ));
+            swapDelta.nurseDelta = tryChangeAssign( pm, weekday, nurse, assign[nurse2][weekday] );
+            swapDelta.nurse2Delta = ((swapDelta.nurseDelta >= DefaultPenalty::MAX_OBJ_VALUE)
+                ? 0 : tryChangeAssign( pm, weekday, nurse2, assign[nurse][weekday] ));
         } else {
-            nurseDelta = tryRemoveAssign( weekday, nurse );
-            nurse2Delta = ((nurseDelta >= DefaultPenalty::MAX_OBJ_VALUE)
-                ? 0 : tryAddAssign( weekday, nurse2, assign[nurse][weekday] ));
+            swapDelta.nurseDelta = tryRemoveAssign( pm, weekday, nurse );
+            swapDelta.nurse2Delta = ((swapDelta.nurseDelta >= DefaultPenalty::MAX_OBJ_VALUE)
+                ? 0 : tryAddAssign( pm, weekday, nurse2, assign[nurse][weekday] ));
         }
     } else {
         if (assign.isWorking( nurse2, weekday )) {
-            nurseDelta = tryAddAssign( weekday, nurse, assign[nurse2][weekday] );
-            nurse2Delta = ((nurseDelta >= DefaultPenalty::MAX_OBJ_VALUE)
-                ? 0 : tryRemoveAssign( weekday, nurse2 ));
+            swapDelta.nurseDelta = tryAddAssign( pm, weekday, nurse, assign[nurse2][weekday] );
+            swapDelta.nurse2Delta = ((swapDelta.nurseDelta >= DefaultPenalty::MAX_OBJ_VALUE)
+                ? 0 : tryRemoveAssign( pm, weekday, nurse2 ));
         } else {    // no change
-            nurseDelta = 0;
-            nurse2Delta = 0;
-            return DefaultPenalty::FORBIDDEN_MOVE;
+            return swapDelta;
         }
     }
 
-    return (nurseDelta + nurse2Delta);
+    swapDelta.delta = swapDelta.nurseDelta + swapDelta.nurse2Delta;
+    return swapDelta;
 }
 
 NurseRostering::ObjValue NurseRostering::Solution::trySwapNurse( const Move &move ) const
 {
-    penalty.setSwapMode();
-    ObjValue delta = trySwapNurse( move.weekday, move.nurse, move.nurse2 );
-    penalty.recoverLastMode();
-
-    return delta;
+    return (penalty.isDefaultMode()
+        ? trySwapNurse( Penalty::SwapMode(), move.weekday, move.nurse, move.nurse2 ).delta
+        : trySwapNurse( penalty.withSwapMode(), move.weekday, move.nurse, move.nurse2 ).delta);
 }
 
-NurseRostering::ObjValue NurseRostering::Solution::trySwapBlock( int weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const
+template <typename PenaltyPolicy>
+NurseRostering::Solution::SwapDelta NurseRostering::Solution::trySwapBlock( EvalContext &ctx, const PenaltyPolicy &pm, int weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const
 {
     // TODO : make sure they won't be the same and leave out this
     if (nurse == nurse2) {
-        return DefaultPenalty::FORBIDDEN_MOVE;
+        return SwapDelta();
     }
 
-    if (!(isValidSuccession( nurse, assign[nurse2][weekday].shift, weekday )
-        && isValidSuccession( nurse2, assign[nurse][weekday].shift, weekday ))) {
-        return DefaultPenalty::FORBIDDEN_MOVE;
-    }
+    BlockSwapRow row;
+    BlockSwapRow row2;
+    buildBlockSwapRow( pm, nurse, row );
+    buildBlockSwapRow( pm, nurse2, row2 );
 
-    RandSelect<ObjValue> rs;
-    ObjValue delta = 0;
-    ObjValue delta1 = 0;
-    ObjValue delta2 = 0;
-    ObjValue minDelta = DefaultPenalty::FORBIDDEN_MOVE;
-    ObjValue minNurseDelta = DefaultPenalty::FORBIDDEN_MOVE;
-    ObjValue minNurse2Delta = DefaultPenalty::FORBIDDEN_MOVE;
-#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
-    RandSelect<ObjValue> rs_tabu;
-    ObjValue minDelta_tabu = DefaultPenalty::FORBIDDEN_MOVE;
-    ObjValue minNurseDelta_tabu = DefaultPenalty::FORBIDDEN_MOVE;
-    ObjValue minNurse2Delta_tabu = DefaultPenalty::FORBIDDEN_MOVE;
-    int weekday2_tabu = weekday;
-
-    int count = 0;
-    int noTabuCount = 0;
-#endif
-    // try each block length
-    int w = weekday;
-    while (problem.scenario.nurses[nurse].skills[assign[nurse2][w].skill]
-        && problem.scenario.nurses[nurse2].skills[assign[nurse][w].skill]) {
-        // longer blocks will also miss this skill
-        delta += trySwapNurse( w, nurse, nurse2 );
-        delta1 += nurseDelta;
-        delta2 += nurse2Delta;
+    return trySwapBlock( ctx, pm, row, row2, weekday, weekday2, nurse, nurse2 );
+}
 
-#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
-        ++count;
-        noTabuCount += noSwapTabu( w, nurse, nurse2 );
-#endif
+template <typename PenaltyPolicy>
+NurseRostering::Solution::SwapDelta NurseRostering::Solution::trySwapBlock( EvalContext &ctx, const PenaltyPolicy &pm, const BlockSwapRow &row, const BlockSwapRow &row2,
+    int weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const
+{
+    // TODO : make sure they won't be the same and leave out this
+    if (nurse == nurse2) {
+        return SwapDelta();
+    }
 
-        if (delta < DefaultPenalty::MAX_OBJ_VALUE) {
-            if (isValidPrior( nurse, assign[nurse2][w].shift, w )
-                && isValidPrior( nurse2, assign[nurse][w].shift, w )) {
-#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
-                if (noBlockSwapTabu( noTabuCount, count )) {
-#endif
-                    if (rs.isMinimal( delta, minDelta, solver.randGen )) {
-                        minDelta = delta;
-                        weekday2 = w;
-                        minNurseDelta = delta1;
-                        minNurse2Delta = delta2;
-                    }
-#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
-                } else {    // tabu
-                    if (rs_tabu.isMinimal( delta, minDelta_tabu, solver.randGen )) {
-                        minDelta_tabu = delta;
-                        weekday2_tabu = w;
-                        minNurseDelta_tabu = delta1;
-                        minNurse2Delta_tabu = delta2;
-                    }
-                }
-#endif
-            }
-        } else {    // two day off
-            delta -= DefaultPenalty::FORBIDDEN_MOVE;
-        }
+    BlockSwapSelector select( *this, ctx.randGen );
+    sweepBlockSwap( pm, row, row2, nurse, nurse2, weekday, weekday, select );
 
-        if (w >= Weekday::Sun) { break; }
+    int w;
+    return select.getBest( w, weekday2 );
+}
 
-        (const_cast<Solution*>(this))->swapNurse( w, nurse, nurse2 );
-        ++w;
-    }
+NurseRostering::ObjValue NurseRostering::Solution::trySwapBlock( EvalContext &ctx, const Move &move ) const
+{
+    return (penalty.isDefaultMode()
+        ? trySwapBlock( ctx, Penalty::BlockSwapMode(), move.weekday, move.weekday2, move.nurse, move.nurse2 ).delta
+        : trySwapBlock( ctx, penalty.withBlockSwapMode(), move.weekday, move.weekday2, move.nurse, move.nurse2 ).delta);
+}
 
-    nurseDelta = minNurseDelta;
-    nurse2Delta = minNurse2Delta;
-#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
-    if (aspirationCritiera( minDelta, minDelta_tabu )) {
-        minDelta = minDelta_tabu;
-        weekday2 = weekday2_tabu;
-        nurseDelta = minNurseDelta_tabu;
-        nurse2Delta = minNurse2Delta_tabu;
+template <typename PenaltyPolicy>
+NurseRostering::Solution::SwapDelta NurseRostering::Solution::trySwapBlock_fast( EvalContext &ctx, const PenaltyPolicy &pm, int &weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const
+{
+    // TODO : make sure they won't be the same and leave out this
+    if (nurse == nurse2) {
+        return SwapDelta();
     }
-#endif
 
-    // recover original data
-    while ((--w) >= weekday) {
-        (const_cast<Solution*>(this))->swapNurse( w, nurse, nurse2 );
-    }
+    BlockSwapRow row;
+    BlockSwapRow row2;
+    buildBlockSwapRow( pm, nurse, row );
+    buildBlockSwapRow( pm, nurse2, row2 );
 
-    return minDelta;
+    BlockSwapSelector select( *this, ctx.randGen );
+    sweepBlockSwap( pm, row, row2, nurse, nurse2, Weekday::Mon, Weekday::Sun, select );
+
+    return select.getBest( weekday, weekday2 );
 }
 
-NurseRostering::ObjValue NurseRostering::Solution::trySwapBlock( const Move &move ) const
+NurseRostering::ObjValue NurseRostering::Solution::trySwapBlock_fast( EvalContext &ctx, const Move &move ) const
 {
-    penalty.setBlockSwapMode();
-    ObjValue delta = trySwapBlock( move.weekday, move.weekday2, move.nurse, move.nurse2 );
-    penalty.recoverLastMode();
-
-    return delta;
+    return (penalty.isDefaultMode()
+        ? trySwapBlock_fast( ctx, Penalty::BlockSwapMode(), move.weekday, move.weekday2, move.nurse, move.nurse2 ).delta
+        : trySwapBlock_fast( ctx, penalty.withBlockSwapMode(), move.weekday, move.weekday2, move.nurse, move.nurse2 ).delta);
 }
 
-NurseRostering::ObjValue NurseRostering::Solution::trySwapBlock_fast( int &weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const
+NurseRostering::ObjValue NurseRostering::Solution::trySwapBlock_sweep( EvalContext &ctx, int &weekday, int &weekday2, NurseID nurse, NurseID nurse2 ) const
 {
     // TODO : make sure they won't be the same and leave out this
     if (nurse == nurse2) {
         return DefaultPenalty::FORBIDDEN_MOVE;
     }
 
-    RandSelect<ObjValue> rs;
-    ObjValue delta = 0;
-    ObjValue delta1 = 0;
-    ObjValue delta2 = 0;
-    ObjValue minDelta = DefaultPenalty::FORBIDDEN_MOVE;
-    ObjValue minNurseDelta = DefaultPenalty::FORBIDDEN_MOVE;
-    ObjValue minNurse2Delta = DefaultPenalty::FORBIDDEN_MOVE;
-
-    // prepare for hard constraint check and tabu judgment
-    bool hasSkill[Weekday::SIZE];
-    for (int w = Weekday::Mon; w <= Weekday::Sun; ++w) {
-        hasSkill[w] = (problem.scenario.nurses[nurse].skills[assign[nurse2][w].skill]
-            && problem.scenario.nurses[nurse2].skills[assign[nurse][w].skill]);
-    }
-
-    weekday = Weekday::Mon;
-    weekday2 = Weekday::Mon;
+    BlockSwapSelector select( *this, ctx.randGen );
+    sweepBlockSwap( Penalty::BlockSwapMode(), blockSwapRows[nurse], blockSwapRows[nurse2],
+        nurse, nurse2, Weekday::Mon, Weekday::Sun, select );
 
-#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
-    RandSelect<ObjValue> rs_tabu;
-    ObjValue minDelta_tabu = DefaultPenalty::FORBIDDEN_MOVE;
-    ObjValue minNurseDelta_tabu = DefaultPenalty::FORBIDDEN_MOVE;
-    ObjValue minNurse2Delta_tabu = DefaultPenalty::FORBIDDEN_MOVE;
+    return select.getBest( weekday, weekday2 ).delta;
+}
 
-    int noTabuCount[Weekday::SIZE][Weekday::SIZE];
-    bool noTabu[Weekday::SIZE][Weekday::SIZE];
-    for (int w = Weekday::Mon; w <= Weekday::Sun; ++w) {
-        noTabuCount[w][w] = noSwapTabu( w, nurse, nurse2 );
-        noTabu[w][w] = (noTabuCount[w][w] > 0);
-    }
-    for (int w = Weekday::Mon; w <= Weekday::Sun; ++w) {
-        for (int w2 = w + 1; w2 <= Weekday::Sun; ++w2) {
-            noTabuCount[w][w2] = noTabuCount[w][w2 - 1] + noTabuCount[w2][w2];
-            noTabu[w][w2] = noBlockSwapTabu( noTabuCount[w][w2], w2 - w + 1 );
+template <typename PenaltyPolicy, typename BlockSelector>
+void NurseRostering::Solution::sweepBlockSwap( const PenaltyPolicy &pm, const BlockSwapRow &row, const BlockSwapRow &row2,
+    NurseID nurse, NurseID nurse2, int firstDay, int lastDay, BlockSelector &select ) const
+{
+    const WeekData &weekData( problem.weekData );
+    const NurseID nurses[2] = { nurse, nurse2 };
+    const BlockSwapRow *rows[2] = { &row, &row2 };
+    // weight 0 leaves out all constraints on the nurse itself
+    const bool isWeighted[2] = { (nurseWeights[nurse] != 0), (nurseWeights[nurse2] != 0) };
+
+    // prefix sum of delta on additive terms if days in [Mon, w] are swapped
+    ObjValue preferenceDelta[2][Weekday::SIZE];
+    int assignNumDelta[2][Weekday::SIZE];
+    for (int i = 0; i < 2; ++i) {
+        if (!isWeighted[i]) { continue; }
+        const NurseID n = nurses[i];
+        const BlockSwapRow &r( *rows[i] );
+        const BlockSwapRow &r2( *rows[1 - i] );
+        preferenceDelta[i][Weekday::HIS] = 0;
+        assignNumDelta[i][Weekday::HIS] = 0;
+        for (int w = Weekday::Mon; w <= Weekday::Sun; ++w) {
+            preferenceDelta[i][w] = preferenceDelta[i][w - 1] + pm.Preference()
+                * (weekData.isShiftOff( n, w, r2.key[BlockSwapRow::ShiftBlock][w] )
+                - weekData.isShiftOff( n, w, r.key[BlockSwapRow::ShiftBlock][w] ));
+            assignNumDelta[i][w] = assignNumDelta[i][w - 1]
+                + r2.key[BlockSwapRow::DayBlock][w] - r.key[BlockSwapRow::DayBlock][w];
         }
     }
 
-    int weekday_tabu = weekday;
-    int weekday2_tabu = weekday2;
-#endif
-
-    // try each block length
-    for (int w = Weekday::Mon, w2; w <= Weekday::Sun; ++w) {
+    for (int w = firstDay; w <= lastDay; ++w) {
         if (!(isValidSuccession( nurse, assign[nurse2][w].shift, w )
             && isValidSuccession( nurse2, assign[nurse][w].shift, w ))) {
             continue;
         }
 
-        w2 = w;
-        for (; (w2 <= Weekday::Sun) && hasSkill[w2]; ++w2) { // longer blocks will also miss this skill
-            delta += trySwapNurse( w2, nurse, nurse2 );
-            delta1 += nurseDelta;
-            delta2 += nurse2Delta;
-
-            if (delta < DefaultPenalty::MAX_OBJ_VALUE) {
-                (const_cast<Solution*>(this))->swapNurse( w2, nurse, nurse2 );
-
-                if (isValidPrior( nurse, assign[nurse][w2].shift, w2 )
-                    && isValidPrior( nurse2, assign[nurse2][w2].shift, w2 )) {
-#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
-                    if (noTabu[w][w2]) {
-#endif
-                        if (rs.isMinimal( delta, minDelta, solver.randGen )) {
-                            minDelta = delta;
-                            weekday = w;
-                            weekday2 = w2;
-                            minNurseDelta = delta1;
-                            minNurse2Delta = delta2;
-                        }
+        // blocks of swapped rows on the left of w2
+        BlockSwapRow::BlockState state[2][BlockSwapRow::BlockKindNum];
+        for (int i = 0; i < 2; ++i) {
+            for (int k = 0; k < BlockSwapRow::BlockKindNum; ++k) {
+                state[i][k] = rows[i]->prefix[k][w];
+            }
+        }
 #if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
-                    } else {    // tabu
-                        if (rs_tabu.isMinimal( delta, minDelta_tabu, solver.randGen )) {
-                            minDelta_tabu = delta;
-                            weekday_tabu = w;
-                            weekday2_tabu = w2;
-                            minNurseDelta_tabu = delta1;
-                            minNurse2Delta_tabu = delta2;
-                        }
-                    }
+        int count = 0;
+        int noTabuCount = 0;
 #endif
+        for (int w2 = w; w2 <= Weekday::Sun; ++w2) {
+            // longer blocks will also miss this skill
+            if (!(problem.scenario->nurses[nurse].hasSkill( assign[nurse2][w2].skill )
+                && problem.scenario->nurses[nurse2].hasSkill( assign[nurse][w2].skill ))) {
+                break;
+            }
+            for (int i = 0; i < 2; ++i) {
+                if (!isWeighted[i]) { continue; }
+                for (int k = 0; k < BlockSwapRow::BlockKindNum; ++k) {
+                    appendBlockDay( pm, nurses[i], k, w2, rows[1 - i]->key[k][w2], state[i][k] );
                 }
-            } else {    // two day off
-                delta -= DefaultPenalty::FORBIDDEN_MOVE;
             }
-        }
-
-        if (w == w2) { continue; }  // the first day is not swapped
+#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
+            ++count;
+            noTabuCount += noSwapTabu( w2, nurse, nurse2 );
+#endif
 
-        do {
-            delta += trySwapNurse( w, nurse, nurse2 );
-            delta1 += nurseDelta;
-            delta2 += nurse2Delta;
-            if (delta < DefaultPenalty::MAX_OBJ_VALUE) {
-                (const_cast<Solution*>(this))->swapNurse( w, nurse, nurse2 );
-            } else {    // two day off
-                delta -= DefaultPenalty::FORBIDDEN_MOVE;
+            // block ending with two day off or the same assign is the same as the shorter one
+            if (!(assign.isWorking( nurse, w2 ) || assign.isWorking( nurse2, w2 ))
+                || (assign[nurse][w2] == assign[nurse2][w2])) {
+                continue;
+            }
+            if (!(isValidPrior( nurse, assign[nurse2][w2].shift, w2 )
+                && isValidPrior( nurse2, assign[nurse][w2].shift, w2 ))) {
+                continue;
             }
-            ++w;
-        } while ((w < w2)
-            && !(isValidSuccession( nurse, assign[nurse][w].shift, w )
-            && isValidSuccession( nurse2, assign[nurse2][w].shift, w )));
 
-        while (w < (w2--)) {
-            if (isValidPrior( nurse, assign[nurse][w2].shift, w2 )
-                && isValidPrior( nurse2, assign[nurse2][w2].shift, w2 )) {
-#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
-                if (noTabu[w][w2]) {
-#endif
-                    if (rs.isMinimal( delta, minDelta, solver.randGen )) {
-                        minDelta = delta;
-                        weekday = w;
-                        weekday2 = w2;
-                        minNurseDelta = delta1;
-                        minNurse2Delta = delta2;
-                    }
-#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
-                } else {    // tabu
-                    if (rs_tabu.isMinimal( delta, minDelta_tabu, solver.randGen )) {
-                        minDelta_tabu = delta;
-                        weekday_tabu = w;
-                        weekday2_tabu = w2;
-                        minNurseDelta_tabu = delta1;
-                        minNurse2Delta_tabu = delta2;
+            ObjValue nurseDelta[2] = { 0, 0 };
+            for (int i = 0; i < 2; ++i) {
+                if (!isWeighted[i]) { continue; }
+                const NurseID n = nurses[i];
+                const BlockSwapRow &r( *rows[i] );
+                const BlockSwapRow &r2( *rows[1 - i] );
+                ObjValue &delta( nurseDelta[i] );
+                // close the open block with the rest days without swap
+                for (int k = 0; k < BlockSwapRow::BlockKindNum; ++k) {
+                    const BlockSwapRow::BlockState &st( state[i][k] );
+                    const bool isShiftBlock = (k == BlockSwapRow::ShiftBlock);
+                    delta += st.closedObj;
+                    if (w2 == Weekday::Sun) {
+                        delta += evaluateConsecutiveBlock( pm, n, isShiftBlock, st.low, w2, st.key );
+                    } else if (r.key[k][w2 + 1] == st.key) {
+                        const int high = r.high[k][w2 + 1];
+                        delta += evaluateConsecutiveBlock( pm, n, isShiftBlock, st.low, high, st.key );
+                        delta += r.suffixObj[k][high + 1];
+                    } else {
+                        delta += evaluateConsecutiveBlock( pm, n, isShiftBlock, st.low, w2, st.key );
+                        delta += r.suffixObj[k][w2 + 1];
                     }
                 }
-#endif
+                const BlockSwapRow &satRow( ((w <= Weekday::Sat) && (Weekday::Sat <= w2)) ? r2 : r );
+                const BlockSwapRow &sunRow( (w2 == Weekday::Sun) ? r2 : r );
+                delta += evaluateWeekend( pm, n, (satRow.key[BlockSwapRow::DayBlock][Weekday::Sat] != 0),
+                    (sunRow.key[BlockSwapRow::DayBlock][Weekday::Sun] != 0) );
+                delta += evaluateTotalAssign( pm, n,
+                    totalAssignNums[n] + assignNumDelta[i][w2] - assignNumDelta[i][w - 1] );
+                delta += preferenceDelta[i][w2] - preferenceDelta[i][w - 1];
+                delta -= r.obj;
             }
 
-            delta += trySwapNurse( w2, nurse, nurse2 );
-            delta1 += nurseDelta;
-            delta2 += nurse2Delta;
-            if (delta < DefaultPenalty::MAX_OBJ_VALUE) {
-                (const_cast<Solution*>(this))->swapNurse( w2, nurse, nurse2 );
-            } else {    // two day off
-                delta -= DefaultPenalty::FORBIDDEN_MOVE;
+            SwapDelta swapDelta( nurseDelta[0] + nurseDelta[1], nurseDelta[0], nurseDelta[1] );
+#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
+            select( w, w2, swapDelta, noBlockSwapTabu( noTabuCount, count ) );
+#else
+            select( w, w2, swapDelta, true );
+#endif
+        }
+    }
+}
+
+template <typename PenaltyPolicy>
+void NurseRostering::Solution::buildBlockSwapRow( const PenaltyPolicy &pm, NurseID nurse, BlockSwapRow &row ) const
+{
+    for (int w = Weekday::Mon; w <= Weekday::Sun; ++w) {
+        row.key[BlockSwapRow::ShiftBlock][w] = assign[nurse][w].shift;
+        row.key[BlockSwapRow::DayBlock][w] = assign.isWorking( nurse, w );
+    }
+
+    // preference is left out since it is evaluated as delta
+    row.obj = evaluateWeekend( pm, nurse, assign.isWorking( nurse, Weekday::Sat ),
+        assign.isWorking( nurse, Weekday::Sun ) ) + evaluateTotalAssign( pm, nurse, totalAssignNums[nurse] );
+    for (int k = 0; k < BlockSwapRow::BlockKindNum; ++k) {
+        const int *key = row.key[k];
+        row.suffixObj[k][Weekday::Sun + 1] = 0;
+        for (int w = Weekday::Sun; w >= Weekday::Mon; --w) {
+            row.high[k][w] = ((w < Weekday::Sun) && (key[w + 1] == key[w])) ? row.high[k][w + 1] : w;
+            row.suffixObj[k][w] = row.suffixObj[k][row.high[k][w] + 1] + evaluateConsecutiveBlock(
+                pm, nurse, (k == BlockSwapRow::ShiftBlock), w, row.high[k][w], key[w] );
+        }
+        row.obj += row.suffixObj[k][Weekday::Mon];
+
+        BlockSwapRow::BlockState state = { 0, Weekday::Mon, key[Weekday::Mon] };
+        for (int w = Weekday::Mon; w <= Weekday::Sun; ++w) {
+            row.prefix[k][w] = state;
+            appendBlockDay( pm, nurse, k, w, key[w], state );
+        }
+    }
+}
+
+template <typename PenaltyPolicy>
+void NurseRostering::Solution::buildBlockSwapRows( const PenaltyPolicy &pm, vector<BlockSwapRow> &rows ) const
+{
+    rows.resize( problem.scenario->nurseNum );
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
+        buildBlockSwapRow( pm, nurse, rows[nurse] );
+    }
+}
+
+void NurseRostering::Solution::updateBlockSwapRow( NurseID nurse ) const
+{
+    buildBlockSwapRow( Penalty::BlockSwapMode(), nurse, blockSwapRows[nurse] );
+}
+
+template <typename PenaltyPolicy>
+void NurseRostering::Solution::appendBlockDay( const PenaltyPolicy &pm, NurseID nurse, int kind, int weekday, int key, BlockSwapRow::BlockState &state ) const
+{
+    if (weekday == Weekday::Mon) {
+        state.closedObj = 0;
+        state.low = weekday;
+        state.key = key;
+    } else if (key != state.key) {
+        state.closedObj += evaluateConsecutiveBlock( pm, nurse,
+            (kind == BlockSwapRow::ShiftBlock), state.low, weekday - 1, state.key );
+        state.low = weekday;
+        state.key = key;
+    }
+}
+
+template <typename PenaltyPolicy>
+NurseRostering::ObjValue NurseRostering::Solution::evaluateConsecutiveBlock( const PenaltyPolicy &pm, NurseID nurse, bool isShiftBlock, int low, int high, int key ) const
+{
+    ObjValue obj = 0;
+
+    const History &history( problem.history );
+    const ShiftID lastShift = history.lastShifts[nurse];
+    const bool isLastWorking = Assign::isWorking( lastShift );
+    const int len = high - low + 1;
+
+    if (isShiftBlock) {
+        const vector<Scenario::Shift> &shifts( problem.scenario->shifts );
+        const bool isWorking = Assign::isWorking( key );
+        if (low == Weekday::Mon) {  // handle first block with history
+            if (isWorking && (key == lastShift)) {
+                const Scenario::Shift &shift( shifts[key] );
+                if (history.consecutiveShiftNums[nurse] > shift.maxConsecutiveShiftNum) {
+                    // exceeding part in previous week has been counted
+                    return (pm.ConsecutiveShift() * len);
+                }
+                return (pm.ConsecutiveShift() * penaltyDayNum( len + history.consecutiveShiftNums[nurse],
+                    high, shift.minConsecutiveShiftNum, shift.maxConsecutiveShiftNum ));
             }
+            if (isLastWorking) {    // the block in history ends
+                obj += pm.ConsecutiveShift() * absentCount( history.consecutiveShiftNums[nurse],
+                    shifts[lastShift].minConsecutiveShiftNum );
+            }
+        }
+        if (isWorking) {
+            const Scenario::Shift &shift( shifts[key] );
+            obj += pm.ConsecutiveShift() * penaltyDayNum( len, high,
+                shift.minConsecutiveShiftNum, shift.maxConsecutiveShiftNum );
         }
+        return obj;
     }
 
-    nurseDelta = minNurseDelta;
-    nurse2Delta = minNurse2Delta;
-#if INRC2_BLOCK_SWAP_TABU_STRENGTH != INRC2_BLOCK_SWAP_NO_TABU
-    if (aspirationCritiera( minDelta, minDelta_tabu )) {
-        minDelta = minDelta_tabu;
-        weekday = weekday_tabu;
-        weekday2 = weekday2_tabu;
-        nurseDelta = minNurseDelta_tabu;
-        nurse2Delta = minNurse2Delta_tabu;
+    const ContractID contractID = problem.scenario->nurses[nurse].contract;
+    const Scenario::Contract &contract( problem.scenario->contracts[contractID] );
+    const bool isWorking = (key != 0);
+    const ObjValue weight = isWorking ? pm.ConsecutiveDay() : pm.ConsecutiveDayOff();
+    const int minNum = isWorking ? contract.minConsecutiveDayNum : contract.minConsecutiveDayoffNum;
+    const int maxNum = isWorking ? contract.maxConsecutiveDayNum : contract.maxConsecutiveDayoffNum;
+    if (low == Weekday::Mon) {  // handle first block with history
+        const int hisNum = isWorking
+            ? history.consecutiveDayNums[nurse] : history.consecutiveDayoffNums[nurse];
+        if (hisNum > maxNum) {
+            // exceeding part in previous week has been counted
+            obj += weight * len;
+        } else {
+            obj += weight * penaltyDayNum( len + ((isWorking == isLastWorking) ? hisNum : 0),
+                high, minNum, maxNum );
+        }
+        if (isWorking != isLastWorking) {   // the block in history ends
+            obj += isLastWorking
+                ? (pm.ConsecutiveDay() * absentCount( history.consecutiveDayNums[nurse], contract.minConsecutiveDayNum ))
+                : (pm.ConsecutiveDayOff() * absentCount( history.consecutiveDayoffNums[nurse], contract.minConsecutiveDayoffNum ));
+        }
+        return obj;
     }
+    return (weight * penaltyDayNum( len, high, minNum, maxNum ));
+}
+
+template <typename PenaltyPolicy>
+NurseRostering::ObjValue NurseRostering::Solution::evaluateWeekend( const PenaltyPolicy &pm, NurseID nurse, bool isSatWorking, bool isSunWorking ) const
+{
+    ObjValue obj = 0;
+
+    const History &history( problem.history );
+    const ContractID contractID = problem.scenario->nurses[nurse].contract;
+    const Scenario::Contract &contract( problem.scenario->contracts[contractID] );
+
+    // complete weekend
+    obj += pm.CompleteWeekend() * (contract.completeWeekend && (isSatWorking != isSunWorking));
+
+    // total working weekend
+#ifdef INRC2_AVERAGE_MAX_WORKING_WEEKEND
+    int exceedingWeekend = history.totalWorkingWeekendNums[nurse] * problem.scenario->totalWeekNum
+        - (contract.maxWorkingWeekendNum * history.currentWeek)
+        + ((isSatWorking || isSunWorking) * problem.scenario->totalWeekNum);
+    if (exceedingWeekend > 0) {
+        obj += pm.TotalWorkingWeekend() * exceedingWeekend / problem.scenario->totalWeekNum;
+    }
+#else
+    obj += pm.TotalWorkingWeekend() * exceedCount(
+        (isSatWorking || isSunWorking) * history.restWeekCount,
+        problem.restRanges[nurse].restMaxWorkingWeekendNum ) / history.restWeekCount;
 #endif
-    return minDelta;
+
+    return obj;
 }
 
-NurseRostering::ObjValue NurseRostering::Solution::trySwapBlock_fast( const Move &move ) const
+template <typename PenaltyPolicy>
+NurseRostering::ObjValue NurseRostering::Solution::evaluateTotalAssign( const PenaltyPolicy &pm, NurseID nurse, int assignNum ) const
 {
-    penalty.setBlockSwapMode();
-    ObjValue delta = trySwapBlock_fast( move.weekday, move.weekday2, move.nurse, move.nurse2 );
-    penalty.recoverLastMode();
+#ifdef INRC2_AVERAGE_TOTAL_SHIFT_NUM
+    const ContractID contractID = problem.scenario->nurses[nurse].contract;
+    const Scenario::Contract &contract( problem.scenario->contracts[contractID] );
+    const int currentWeek = problem.history.currentWeek;
+    return pm.TotalAssign() * distanceToRange(
+        (assignNum + problem.history.totalAssignNums[nurse]) * problem.scenario->totalWeekNum,
+        contract.minShiftNum * currentWeek, contract.maxShiftNum * currentWeek ) / problem.scenario->totalWeekNum;
+#else
+    return pm.TotalAssign() * distanceToRange( assignNum * problem.history.restWeekCount,
+        problem.restRanges[nurse].restMinShiftNum,
+        problem.restRanges[nurse].restMaxShiftNum ) / problem.history.restWeekCount;
+#endif
+}
 
-    return delta;
+template <typename PenaltyPolicy>
+NurseRostering::ObjValue NurseRostering::Solution::evaluateNurseRow( const PenaltyPolicy &pm, NurseID nurse, const Assign a[] ) const
+{
+    ObjValue obj = 0;
+
+    // consecutive shift, day and day-off
+    for (int w = Weekday::Mon, high; w <= Weekday::Sun; w = high + 1) {
+        for (high = w; (high < Weekday::Sun) && (a[high + 1].shift == a[w].shift); ++high) {}
+        obj += evaluateConsecutiveBlock( pm, nurse, true, w, high, a[w].shift );
+    }
+    for (int w = Weekday::Mon, high; w <= Weekday::Sun; w = high + 1) {
+        for (high = w; (high < Weekday::Sun) && (a[high + 1].isWorking() == a[w].isWorking()); ++high) {}
+        obj += evaluateConsecutiveBlock( pm, nurse, false, w, high, a[w].isWorking() );
+    }
+
+    // preference and total assign
+    int assignNum = 0;
+    for (int w = Weekday::Mon; w <= Weekday::Sun; ++w) {
+        obj += pm.Preference() * problem.weekData.isShiftOff( nurse, w, a[w].shift );
+        assignNum += a[w].isWorking();
+    }
+    obj += evaluateTotalAssign( pm, nurse, assignNum );
+
+    // complete weekend and total working weekend
+    obj += evaluateWeekend( pm, nurse, a[Weekday::Sat].isWorking(), a[Weekday::Sun].isWorking() );
+
+    return obj;
 }
 
-NurseRostering::ObjValue NurseRostering::Solution::tryExchangeDay( int weekday, NurseID nurse, int weekday2 ) const
+template <typename PenaltyPolicy>
+NurseRostering::ObjValue NurseRostering::Solution::tryExchangeDay( const PenaltyPolicy &pm, int weekday, NurseID nurse, int weekday2 ) const
 {
     // TODO : make sure they won't be the same and leave out this
     if (weekday == weekday2) {
@@ -2976,13 +3550,13 @@ NurseRostering::ObjValue NurseRostering::Solution::tryExchangeDay( int weekday,
     ShiftID shift2 = assign[nurse][weekday2].shift;
     if (weekday == weekday2 + 1) {
         if (!(isValidSuccession( nurse, shift, weekday2 )
-            && problem.scenario.shifts[shift].legalNextShifts[shift2]
+            && problem.scenario->shifts[shift].isLegalNextShift( shift2 )
             && isValidPrior( nurse, shift2, weekday ))) {
             return DefaultPenalty::FORBIDDEN_MOVE;
         }
     } else if (weekday == weekday2 - 1) {
         if (!(isValidSuccession( nurse, shift2, weekday )
-            && problem.scenario.shifts[shift2].legalNextShifts[shift]
+            && problem.scenario->shifts[shift2].isLegalNextShift( shift )
             && isValidPrior( nurse, shift, weekday2 ))) {
             return DefaultPenalty::FORBIDDEN_MOVE;
         }
@@ -2995,47 +3569,111 @@ NurseRostering::ObjValue NurseRostering::Solution::tryExchangeDay( int weekday,
         }
     }
 
-    ObjValue delta = 0;
+    // exchanging the same Assign will change nothing
+    if (assign[nurse][weekday] == assign[nurse][weekday2]) {
+        return DefaultPenalty::FORBIDDEN_MOVE;
+    }
 
-    if (assign.isWorking( nurse, weekday )) {
-        if (assign.isWorking( nurse, weekday2 )) {
-            delta += tryChangeAssign( weekday, nurse, assign[nurse][weekday2] );
-            if (delta < DefaultPenalty::MAX_OBJ_VALUE) {
-                Assign a( assign[nurse][weekday] );
-                (const_cast<Solution*>(this))->changeAssign( weekday, nurse, assign[nurse][weekday2] );
-                delta += tryChangeAssign( weekday2, nurse, a );
-                (const_cast<Solution*>(this))->changeAssign( weekday, nurse, a );
-            }
-        } else {
-            delta += tryRemoveAssign( weekday, nurse );
-            if (delta < DefaultPenalty::MAX_OBJ_VALUE) {
-                Assign a( assign[nurse][weekday] );
-                (const_cast<Solution*>(this))->removeAssign( weekday, nurse );
-                delta += tryAddAssign( weekday2, nurse, a );
-                (const_cast<Solution*>(this))->addAssign( weekday, nurse, a );
-            }
+    // staffing on each day which is evaluated as removing the old Assign and adding the new one
+    const WeekData &weekData( problem.weekData );
+    const int days[2] = { weekday, weekday2 };
+    ObjValue delta = 0;
+    for (int i = 0; i < 2; ++i) {
+        const int w = days[i];
+        const Assign &oldAssign( assign[nurse][w] );
+        const Assign &newAssign( assign[nurse][days[1 - i]] );
+        if (oldAssign.isWorking()) {
+            const int oldMissingNurseNum = missingNurseNums[w][oldAssign.shift][oldAssign.skill];
+            ObjValue underStaff = pm.UnderStaff() * (weekData.minNurseNums[w][oldAssign.shift][oldAssign.skill] >=
+                (weekData.optNurseNums[w][oldAssign.shift][oldAssign.skill] - oldMissingNurseNum));
+            if (underStaff >= DefaultPenalty::MAX_OBJ_VALUE) { return (delta + underStaff); }
+            delta += underStaff;
+            delta += pm.InsufficientStaff() * (oldMissingNurseNum >= 0);
         }
-    } else {
-        delta += tryAddAssign( weekday, nurse, assign[nurse][weekday2] );
-        if (delta < DefaultPenalty::MAX_OBJ_VALUE) {
-            (const_cast<Solution*>(this))->addAssign( weekday, nurse, assign[nurse][weekday2] );
-            delta += tryRemoveAssign( weekday2, nurse );
-            (const_cast<Solution*>(this))->removeAssign( weekday, nurse );
+        if (newAssign.isWorking()) {
+            const int missingNurseNum = missingNurseNums[w][newAssign.shift][newAssign.skill];
+            delta -= pm.UnderStaff() * (weekData.minNurseNums[w][newAssign.shift][newAssign.skill] >
+                (weekData.optNurseNums[w][newAssign.shift][newAssign.skill] - missingNurseNum));
+            delta -= pm.InsufficientStaff() * (missingNurseNum > 0);
         }
     }
 
+    if (nurseWeights[nurse] == 0) {
+        return delta;   // TODO : weight ?
+    }
+
+    // constraints on the nurse itself are evaluated on the exchanged row
+    Assign row[Weekday::SIZE];
+    for (int w = Weekday::Mon; w <= Weekday::Sun; ++w) {
+        row[w] = assign[nurse][w];
+    }
+    delta -= evaluateNurseRow( pm, nurse, row );
+    swap( row[weekday], row[weekday2] );
+    delta += evaluateNurseRow( pm, nurse, row );
+
     return delta;
 }
 
 NurseRostering::ObjValue NurseRostering::Solution::tryExchangeDay( const Move &move ) const
 {
-    penalty.setExchangeMode();
-    ObjValue delta = tryExchangeDay( move.weekday, move.nurse, move.weekday2 );
-    penalty.recoverLastMode();
+    return (penalty.isDefaultMode()
+        ? tryExchangeDay( Penalty::ExchangeMode(), move.weekday, move.nurse, move.weekday2 )
+        : tryExchangeDay( penalty.withExchangeMode(), move.weekday, move.nurse, move.weekday2 ));
+}
 
-    return delta;
+void NurseRostering::Solution::applyMove( const Move &move )
+{
+    switch (move.mode) {
+        case Move::Mode::Add:
+            addAssign( move );
+            break;
+        case Move::Mode::Remove:
+            removeAssign( move );
+            break;
+        case Move::Mode::Change:
+            changeAssign( move );
+            break;
+        case Move::Mode::Exchange:
+            exchangeDay( move );
+            break;
+        case Move::Mode::Swap:
+            swapNurse( move );
+            break;
+        case Move::Mode::BlockSwap:
+            swapBlock( move );
+            break;
+        default:
+            break;
+    }
 }
 
+#ifdef INRC2_USE_TABU
+void NurseRostering::Solution::updateTabu( const Move &move )
+{
+    switch (move.mode) {
+        case Move::Mode::Add:
+            updateAddTabu( move );
+            break;
+        case Move::Mode::Remove:
+            updateRemoveTabu( move );
+            break;
+        case Move::Mode::Change:
+            updateChangeTabu( move );
+            break;
+        case Move::Mode::Exchange:
+            updateExchangeTabu( move );
+            break;
+        case Move::Mode::Swap:
+            updateSwapTabu( move );
+            break;
+        case Move::Mode::BlockSwap:
+            updateBlockSwapTabu( move );
+            break;
+        default:
+            break;
+    }
+}
+#endif
 
 void NurseRostering::Solution::addAssign( int weekday, NurseID nurse, const Assign &a )
 {
@@ -3259,14 +3897,14 @@ void NurseRostering::Solution::assignSingle( int weekday, int high[], int low[],
 #ifdef INRC2_USE_TABU
 void NurseRostering::Solution::updateDayTabu( NurseID nurse, int weekday )
 {
-    dayTabu[nurse][weekday] = iterCount +
-        solver.DayTabuTenureBase() + (solver.randGen() % solver.DayTabuTenureAmp());
+    dayTabu.update( dayTabu.index( nurse, weekday ), iterCount,
+        solver.DayTabuTenureBase() + (evalContext.randGen() % solver.DayTabuTenureAmp()) );
 }
 
 void NurseRostering::Solution::updateShiftTabu( NurseID nurse, int weekday, const Assign &a )
 {
-    shiftTabu[nurse][weekday][a.shift][a.skill] = iterCount +
-        solver.ShiftTabuTenureBase() + (solver.randGen() % solver.ShiftTabuTenureAmp());
+    shiftTabu.update( shiftTabu.index( nurse, weekday, a ), iterCount,
+        solver.ShiftTabuTenureBase() + (evalContext.randGen() % solver.ShiftTabuTenureAmp()) );
 }
 #endif
 
@@ -3302,9 +3940,9 @@ NurseRostering::ObjValue NurseRostering::Solution::evaluateInsufficientStaff()
 
     for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
         for (ShiftID shift = NurseRostering::Scenario::Shift::ID_BEGIN;
-            shift < problem.scenario.shiftSize; ++shift) {
+            shift < problem.scenario->shiftSize; ++shift) {
             for (SkillID skill = NurseRostering::Scenario::Skill::ID_BEGIN;
-                skill < problem.scenario.skillSize; ++skill) {
+                skill < problem.scenario->skillSize; ++skill) {
                 if (missingNurseNums[weekday][shift][skill] > 0) {
                     obj += penalty.InsufficientStaff() * missingNurseNums[weekday][shift][skill];
                 }
@@ -3321,7 +3959,7 @@ NurseRostering::ObjValue NurseRostering::Solution::evaluateConsecutiveShift( Nur
 
     const History &history( problem.history );
     const Consecutive &c( consecutives[nurse] );
-    const vector<Scenario::Shift> &shifts( problem.scenario.shifts );
+    const vector<Scenario::Shift> &shifts( problem.scenario->shifts );
 
     int nextday = c.shiftHigh[Weekday::Mon] + 1;
     if (nextday <= Weekday::Sun) {   // the entire week is not one block
@@ -3365,7 +4003,7 @@ NurseRostering::ObjValue NurseRostering::Solution::evaluateConsecutiveShift( Nur
     int consecutiveShift = c.shiftHigh[Weekday::Sun] - c.shiftLow[Weekday::Sun] + 1;
     if (assign.isWorking( nurse, Weekday::Sun )) {
         const ShiftID &shiftID( assign[nurse][Weekday::Sun].shift );
-        const Scenario::Shift &shift( problem.scenario.shifts[shiftID] );
+        const Scenario::Shift &shift( problem.scenario->shifts[shiftID] );
         if (c.isSingleConsecutiveShift()) { // the entire week is one block
             if (history.lastShifts[nurse] == assign[nurse][Weekday::Sun].shift) {
                 if (history.consecutiveShiftNums[nurse] > shift.maxConsecutiveShiftNum) {
@@ -3403,8 +4041,8 @@ NurseRostering::ObjValue NurseRostering::Solution::evaluateConsecutiveDay( Nurse
 
     const History &history( problem.history );
     const Consecutive &c( consecutives[nurse] );
-    const ContractID &contractID( problem.scenario.nurses[nurse].contract );
-    const Scenario::Contract &contract( problem.scenario.contracts[contractID] );
+    const ContractID &contractID( problem.scenario->nurses[nurse].contract );
+    const Scenario::Contract &contract( problem.scenario->contracts[contractID] );
 
     int nextday = c.dayHigh[Weekday::Mon] + 1;
     if (nextday <= Weekday::Sun) {   // the entire week is not one block
@@ -3460,8 +4098,8 @@ NurseRostering::ObjValue NurseRostering::Solution::evaluateConsecutiveDayOff( Nu
 
     const History &history( problem.history );
     const Consecutive &c( consecutives[nurse] );
-    const ContractID &contractID( problem.scenario.nurses[nurse].contract );
-    const Scenario::Contract &contract( problem.scenario.contracts[contractID] );
+    const ContractID &contractID( problem.scenario->nurses[nurse].contract );
+    const Scenario::Contract &contract( problem.scenario->contracts[contractID] );
 
     int nextday = c.dayHigh[Weekday::Mon] + 1;
     if (nextday <= Weekday::Sun) {   // the entire week is not one block
@@ -3517,7 +4155,7 @@ NurseRostering::ObjValue NurseRostering::Solution::evaluatePreference( NurseID n
     for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
         const ShiftID &shift = assign[nurse][weekday].shift;
         obj += penalty.Preference() *
-            problem.weekData.shiftOffs[weekday][shift][nurse];
+            problem.weekData.isShiftOff( nurse, weekday, shift );
     }
 
     return obj;
@@ -3528,7 +4166,7 @@ NurseRostering::ObjValue NurseRostering::Solution::evaluateCompleteWeekend( Nurs
     ObjValue obj = 0;
 
     obj += penalty.CompleteWeekend() *
-        (problem.scenario.contracts[problem.scenario.nurses[nurse].contract].completeWeekend
+        (problem.scenario->contracts[problem.scenario->nurses[nurse].contract].completeWeekend
         && (assign.isWorking( nurse, Weekday::Sat ) != assign.isWorking( nurse, Weekday::Sun )));
 
     return obj;
@@ -3538,8 +4176,8 @@ NurseRostering::ObjValue NurseRostering::Solution::evaluateTotalAssign( NurseID
 {
     ObjValue obj = 0;
 
-    int min = problem.scenario.nurses[nurse].restMinShiftNum;
-    int max = problem.scenario.nurses[nurse].restMaxShiftNum;
+    int min = problem.restRanges[nurse].restMinShiftNum;
+    int max = problem.restRanges[nurse].restMaxShiftNum;
     obj += penalty.TotalAssign() * distanceToRange(
         totalAssignNums[nurse] * problem.history.restWeekCount,
         min, max ) / problem.history.restWeekCount;
@@ -3552,19 +4190,19 @@ NurseRostering::ObjValue NurseRostering::Solution::evaluateTotalWorkingWeekend(
     ObjValue obj = 0;
 
 #ifdef INRC2_AVERAGE_MAX_WORKING_WEEKEND
-    int maxWeekend = problem.scenario.contracts[problem.scenario.nurses[nurse].contract].maxWorkingWeekendNum;
-    int historyWeekend = problem.history.totalWorkingWeekendNums[nurse] * problem.scenario.totalWeekNum;
+    int maxWeekend = problem.scenario->contracts[problem.scenario->nurses[nurse].contract].maxWorkingWeekendNum;
+    int historyWeekend = problem.history.totalWorkingWeekendNums[nurse] * problem.scenario->totalWeekNum;
     int exceedingWeekend = historyWeekend - (maxWeekend * problem.history.currentWeek) +
-        ((assign.isWorking( nurse, Weekday::Sat ) || assign.isWorking( nurse, Weekday::Sun )) * problem.scenario.totalWeekNum);
+        ((assign.isWorking( nurse, Weekday::Sat ) || assign.isWorking( nurse, Weekday::Sun )) * problem.scenario->totalWeekNum);
     if (exceedingWeekend > 0) {
         obj += penalty.TotalWorkingWeekend() *
-            exceedingWeekend / problem.scenario.totalWeekNum;
+            exceedingWeekend / problem.scenario->totalWeekNum;
     }
 #else
     int workingWeekendNum = (assign.isWorking( nurse, Weekday::Sat ) || assign.isWorking( nurse, Weekday::Sun ));
     obj += penalty.TotalWorkingWeekend() * exceedCount(
         workingWeekendNum * problem.history.restWeekCount,
-        problem.scenario.nurses[nurse].restMaxWorkingWeekendNum) / problem.history.restWeekCount;
+        problem.restRanges[nurse].restMaxWorkingWeekendNum) / problem.history.restWeekCount;
 #endif
 
     return obj;
@@ -3572,8 +4210,8 @@ NurseRostering::ObjValue NurseRostering::Solution::evaluateTotalWorkingWeekend(
 
 
 
-NurseRostering::Solution::AvailableNurses::AvailableNurses( const Solution &s )
-    : sln( s ), nurseWithSkill( s.solver.getNurseWithSkill() )
+NurseRostering::Solution::AvailableNurses::AvailableNurses( const Solution &s, std::mt19937 &rgen )
+    : sln( s ), randGen( rgen ), nurseWithSkill( s.solver.getNurseWithSkill() )
 {
 }
 
@@ -3612,7 +4250,7 @@ NurseRostering::NurseID NurseRostering::Solution::AvailableNurses::getNurse()
 
         // select one nurse from it
         while (true) {
-            int n = sln.solver.randGen() % validNurseNum_CurShift[minSkillNum];
+            int n = randGen() % validNurseNum_CurShift[minSkillNum];
             NurseID nurse = nurseWithSkill[skill][minSkillNum][n];
             vector<NurseID> &nurseSet = nurseWithSkill[skill][minSkillNum];
             if (sln.getAssignTable().isWorking( nurse, weekday )) { // set the nurse invalid for current day
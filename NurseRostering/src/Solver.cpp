@@ -9,18 +9,24 @@ const double NurseRostering::Solver::INIT_PERTURB_STRENGTH = 0.2;
 const double NurseRostering::Solver::PERTURB_STRENGTH_DELTA = 0.01;
 const double NurseRostering::Solver::MAX_PERTURB_STRENGTH = 0.6;
 
+const double NurseRostering::Portfolio::DISCOUNT = 0.8;
+const double NurseRostering::Portfolio::EXPLORATION = 0.5;
+const Timer::Duration NurseRostering::Portfolio::MIN_EPOCH = Timer::Duration( 50 );
+
 const vector<string> NurseRostering::Solver::solveAlgorithmName = {
-    "[RW]", "[ILS]", "[TSP]", "[TSL]", "[TSR]", "[BTS]", "[SCS]"
+    "[RW]", "[ILS]", "[TSP]", "[TSL]", "[TSR]", "[BTS]", "[SCS]", "[PR]", "[MA]"
 };
 
 
 NurseRostering::Solver::Solver( const NurseRostering &input, Timer::TimePoint st )
-    : problem( input ), startTime( st ), timer( problem.timeout, startTime )
+    : problem( input ), startTime( st ), timer( problem.timeout, startTime ),
+    sharedOptima( NULL ), portfolio( NULL ), arm( 0 ), randSeed( input.randSeed )
 {
 }
 
 NurseRostering::Solver::Solver( const NurseRostering &input, const Output &opt, Timer::TimePoint st )
-    : problem( input ), startTime( st ), optima( opt ), timer( problem.timeout, startTime )
+    : problem( input ), startTime( st ), optima( opt ), timer( problem.timeout, startTime ),
+    sharedOptima( NULL ), portfolio( NULL ), arm( 0 ), randSeed( input.randSeed )
 {
 }
 
@@ -49,8 +55,8 @@ NurseRostering::ObjValue NurseRostering::Solver::checkFeasibility( const AssignT
 
     // check H2: Under-staffing
     for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
-        for (ShiftID shift = NurseRostering::Scenario::Shift::ID_BEGIN; shift < problem.scenario.shiftSize; ++shift) {
-            for (SkillID skill = NurseRostering::Scenario::Skill::ID_BEGIN; skill < problem.scenario.skillSize; ++skill) {
+        for (ShiftID shift = NurseRostering::Scenario::Shift::ID_BEGIN; shift < problem.scenario->shiftSize; ++shift) {
+            for (SkillID skill = NurseRostering::Scenario::Skill::ID_BEGIN; skill < problem.scenario->skillSize; ++skill) {
                 if (nurseNum[weekday][shift][skill] < problem.weekData.minNurseNums[weekday][shift][skill]) {
                     objValue += DefaultPenalty::UnderStaff_Repair *
                         (problem.weekData.minNurseNums[weekday][shift][skill] - nurseNum[weekday][shift][skill]);
@@ -61,17 +67,17 @@ NurseRostering::ObjValue NurseRostering::Solver::checkFeasibility( const AssignT
 
     // check H3: Shift type successions
     for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
-        for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+        for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
             objValue += DefaultPenalty::Succession_Repair *
-                (!problem.scenario.shifts[assign[nurse][weekday - 1].shift].legalNextShifts[assign[nurse][weekday].shift]);
+                (!problem.scenario->shifts[assign[nurse][weekday - 1].shift].isLegalNextShift( assign[nurse][weekday].shift ));
         }
     }
 
     // check H4: Missing required skill
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
             if (assign[nurse][weekday].isWorking() &&
-                !problem.scenario.nurses[nurse].skills[assign[nurse][weekday].skill]) {
+                !problem.scenario->nurses[nurse].hasSkill( assign[nurse][weekday].skill )) {
                 return DefaultPenalty::FORBIDDEN_MOVE;
             }
         }
@@ -92,8 +98,8 @@ NurseRostering::ObjValue NurseRostering::Solver::checkObjValue( const AssignTabl
 
     // check S1: Insufficient staffing for optimal coverage (30)
     for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
-        for (ShiftID shift = NurseRostering::Scenario::Shift::ID_BEGIN; shift < problem.scenario.shiftSize; ++shift) {
-            for (SkillID skill = NurseRostering::Scenario::Skill::ID_BEGIN; skill < problem.scenario.skillSize; ++skill) {
+        for (ShiftID shift = NurseRostering::Scenario::Shift::ID_BEGIN; shift < problem.scenario->shiftSize; ++shift) {
+            for (SkillID skill = NurseRostering::Scenario::Skill::ID_BEGIN; skill < problem.scenario->skillSize; ++skill) {
                 int missingNurse = (problem.weekData.optNurseNums[weekday][shift][skill]
                     - nurseNums[weekday][shift][skill]);
                 if (missingNurse > 0) {
@@ -105,7 +111,7 @@ NurseRostering::ObjValue NurseRostering::Solver::checkObjValue( const AssignTabl
 
     // check S2: Consecutive assignments (15/30)
     // check S3: Consecutive days off (30)
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         int consecutiveShift = problem.history.consecutiveShiftNums[nurse];
         int consecutiveDay = problem.history.consecutiveDayNums[nurse];
         int consecutiveDayOff = problem.history.consecutiveDayoffNums[nurse];
@@ -124,19 +130,19 @@ NurseRostering::ObjValue NurseRostering::Solver::checkObjValue( const AssignTabl
         }
         // since penalty was calculated when switching assign, the penalty of last 
         // consecutive assignments are not considered. so finish it here.
-        const ContractID &contractID( problem.scenario.nurses[nurse].contract );
-        const Scenario::Contract &contract( problem.scenario.contracts[contractID] );
+        const ContractID &contractID( problem.scenario->nurses[nurse].contract );
+        const Scenario::Contract &contract( problem.scenario->contracts[contractID] );
         if (dayoffBegin && problem.history.consecutiveDayoffNums[nurse] > contract.maxConsecutiveDayoffNum) {
             objValue += DefaultPenalty::ConsecutiveDayOff * Weekday::NUM;
         } else if (consecutiveDayOff > contract.maxConsecutiveDayoffNum) {
             objValue += DefaultPenalty::ConsecutiveDayOff *
                 (consecutiveDayOff - contract.maxConsecutiveDayoffNum);
         } else if (consecutiveDayOff == 0) {    // working day
-            if (shiftBegin && problem.history.consecutiveShiftNums[nurse] > problem.scenario.shifts[assign[nurse][Weekday::Sun].shift].maxConsecutiveShiftNum) {
+            if (shiftBegin && problem.history.consecutiveShiftNums[nurse] > problem.scenario->shifts[assign[nurse][Weekday::Sun].shift].maxConsecutiveShiftNum) {
                 objValue += DefaultPenalty::ConsecutiveShift * Weekday::NUM;
-            } else if (consecutiveShift > problem.scenario.shifts[assign[nurse][Weekday::Sun].shift].maxConsecutiveShiftNum) {
+            } else if (consecutiveShift > problem.scenario->shifts[assign[nurse][Weekday::Sun].shift].maxConsecutiveShiftNum) {
                 objValue += DefaultPenalty::ConsecutiveShift *
-                    (consecutiveShift - problem.scenario.shifts[assign[nurse][Weekday::Sun].shift].maxConsecutiveShiftNum);
+                    (consecutiveShift - problem.scenario->shifts[assign[nurse][Weekday::Sun].shift].maxConsecutiveShiftNum);
             }
             if (dayBegin && problem.history.consecutiveDayNums[nurse] > contract.maxConsecutiveDayNum) {
                 objValue += DefaultPenalty::ConsecutiveDay * Weekday::NUM;
@@ -148,57 +154,57 @@ NurseRostering::ObjValue NurseRostering::Solver::checkObjValue( const AssignTabl
     }
 
     // check S4: Preferences (10)
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
             const ShiftID &shift = assign[nurse][weekday].shift;
             objValue += DefaultPenalty::Preference *
-                problem.weekData.shiftOffs[weekday][shift][nurse];
+                problem.weekData.isShiftOff( nurse, weekday, shift );
         }
     }
 
     // check S5: Complete weekend (30)
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         objValue += DefaultPenalty::CompleteWeekend *
-            (problem.scenario.contracts[problem.scenario.nurses[nurse].contract].completeWeekend
+            (problem.scenario->contracts[problem.scenario->nurses[nurse].contract].completeWeekend
             && (assign.isWorking( nurse, Weekday::Sat )
             != assign.isWorking( nurse, Weekday::Sun )));
     }
 
     // check S6: Total assignments (20)
     // check S7: Total working weekends (30)
-    if (problem.history.currentWeek == problem.scenario.totalWeekNum) {
-        for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    if (problem.history.currentWeek == problem.scenario->totalWeekNum) {
+        for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
             int assignNum = 0;
             for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
                 assignNum += assign.isWorking( nurse, weekday );
             }
 #ifdef INRC2_AVERAGE_TOTAL_SHIFT_NUM
             assignNum += problem.history.totalAssignNums[nurse];
-            int min = problem.scenario.contracts[problem.scenario.nurses[nurse].contract].minShiftNum;
-            int max = problem.scenario.contracts[problem.scenario.nurses[nurse].contract].maxShiftNum;
+            int min = problem.scenario->contracts[problem.scenario->nurses[nurse].contract].minShiftNum;
+            int max = problem.scenario->contracts[problem.scenario->nurses[nurse].contract].maxShiftNum;
             objValue += DefaultPenalty::TotalAssign * distanceToRange(
-                assignNum * problem.scenario.totalWeekNum, min * problem.history.currentWeek,
-                max * problem.history.currentWeek ) / problem.scenario.totalWeekNum;
+                assignNum * problem.scenario->totalWeekNum, min * problem.history.currentWeek,
+                max * problem.history.currentWeek ) / problem.scenario->totalWeekNum;
 #else
-            int min = problem.scenario.nurses[nurse].restMinShiftNum;
-            int max = problem.scenario.nurses[nurse].restMaxShiftNum;
+            int min = problem.restRanges[nurse].restMinShiftNum;
+            int max = problem.restRanges[nurse].restMaxShiftNum;
             objValue += DefaultPenalty::TotalAssign * distanceToRange(
                 assignNum * problem.history.restWeekCount, min, max ) / problem.history.restWeekCount;
 #endif
 
 #ifdef INRC2_AVERAGE_MAX_WORKING_WEEKEND
-            int maxWeekend = problem.scenario.contracts[problem.scenario.nurses[nurse].contract].maxWorkingWeekendNum;
-            int historyWeekend = problem.history.totalWorkingWeekendNums[nurse] * problem.scenario.totalWeekNum;
+            int maxWeekend = problem.scenario->contracts[problem.scenario->nurses[nurse].contract].maxWorkingWeekendNum;
+            int historyWeekend = problem.history.totalWorkingWeekendNums[nurse] * problem.scenario->totalWeekNum;
             int exceedingWeekend = historyWeekend - (maxWeekend * problem.history.currentWeek) +
-                ((assign.isWorking( nurse, Weekday::Sat ) || assign.isWorking( nurse, Weekday::Sun )) * problem.scenario.totalWeekNum);
+                ((assign.isWorking( nurse, Weekday::Sat ) || assign.isWorking( nurse, Weekday::Sun )) * problem.scenario->totalWeekNum);
             if (exceedingWeekend > 0) {
-                objValue += DefaultPenalty::TotalWorkingWeekend * exceedingWeekend / problem.scenario.totalWeekNum;
+                objValue += DefaultPenalty::TotalWorkingWeekend * exceedingWeekend / problem.scenario->totalWeekNum;
             }
 #else
             int workingWeekendNum = (assign.isWorking( nurse, Weekday::Sat ) || assign.isWorking( nurse, Weekday::Sun ));
             objValue += DefaultPenalty::TotalWorkingWeekend * exceedCount(
                 workingWeekendNum * problem.history.restWeekCount,
-                problem.scenario.nurses[nurse].restMaxWorkingWeekendNum ) / problem.history.restWeekCount;
+                problem.restRanges[nurse].restMaxWorkingWeekendNum ) / problem.history.restWeekCount;
 #endif
         }
     }
@@ -242,7 +248,7 @@ void NurseRostering::Solver::record( const std::string logFileName, const std::s
         << runID << ","
         << instanceName << ","
         << algorithmName << ","
-        << problem.randSeed << ","
+        << randSeed << ","
         << generationCount << ","
         << iterationCount << ","
         << chrono::duration_cast<std::chrono::milliseconds>(optima.getFindTime() - startTime).count() / 1000.0 << "s,"
@@ -251,10 +257,10 @@ void NurseRostering::Solver::record( const std::string logFileName, const std::s
         << optima.getObjValue() / static_cast<double>(DefaultPenalty::AMP) << ","
         << (optima.getObjValue() + problem.history.accObjValue) / static_cast<double>(DefaultPenalty::AMP) << ",";
 
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
-            csvFile << optima.getAssign( nurse, weekday ).shift << ' '
-                << optima.getAssign( nurse, weekday ).skill << ' ';
+            csvFile << static_cast<ShiftID>(optima.getAssign( nurse, weekday ).shift) << ' '
+                << static_cast<SkillID>(optima.getAssign( nurse, weekday ).skill) << ' ';
         }
     }
 
@@ -270,12 +276,19 @@ void NurseRostering::Solver::errorLog( const std::string &msg ) const
 #endif
 }
 
+void NurseRostering::Solver::yieldToPortfolio( IterCount iterCount ) const
+{
+    if ((portfolio != NULL) && isIterForTimeCheck( iterCount )) {
+        portfolio->yield( arm );
+    }
+}
+
 
 NurseRostering::NurseNumsOnSingleAssign NurseRostering::Solver::countNurseNums( const AssignTable &assign ) const
 {
     NurseNumsOnSingleAssign nurseNums( Weekday::SIZE,
-        vector< vector<int> >( problem.scenario.shiftSize, vector<int>( problem.scenario.skillSize, 0 ) ) );
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
+        vector< vector<int> >( problem.scenario->shiftSize, vector<int>( problem.scenario->skillSize, 0 ) ) );
+    for (NurseID nurse = 0; nurse < problem.scenario->nurseNum; ++nurse) {
         for (int weekday = Weekday::Mon; weekday <= Weekday::Sun; ++weekday) {
             ++nurseNums[weekday][assign[nurse][weekday].shift][assign[nurse][weekday].skill];
         }
@@ -289,8 +302,8 @@ void NurseRostering::Solver::checkConsecutiveViolation( int &objValue,
     int &consecutiveShift, int &consecutiveDay, int &consecutiveDayOff,
     bool &shiftBegin, bool &dayBegin, bool &dayoffBegin ) const
 {
-    const ContractID &contractID = problem.scenario.nurses[nurse].contract;
-    const Scenario::Contract &contract( problem.scenario.contracts[contractID] );
+    const ContractID &contractID = problem.scenario->nurses[nurse].contract;
+    const Scenario::Contract &contract( problem.scenario->contracts[contractID] );
     const ShiftID &shift = assign[nurse][weekday].shift;
     if (Assign::isWorking( shift )) {    // working day
         if (consecutiveDay == 0) {  // switch from consecutive day off to working
@@ -312,7 +325,7 @@ void NurseRostering::Solver::checkConsecutiveViolation( int &objValue,
             if (shift == lastShiftID) {
                 ++consecutiveShift;
             } else { // another shift
-                const Scenario::Shift &lastShift( problem.scenario.shifts[lastShiftID] );
+                const Scenario::Shift &lastShift( problem.scenario->shifts[lastShiftID] );
                 if (shiftBegin) {
                     if (problem.history.consecutiveShiftNums[nurse] > lastShift.maxConsecutiveShiftNum) {
                         objValue += DefaultPenalty::ConsecutiveShift * (weekday - Weekday::Mon);
@@ -331,7 +344,7 @@ void NurseRostering::Solver::checkConsecutiveViolation( int &objValue,
         ++consecutiveDay;
     } else {    // day off
         if (consecutiveDayOff == 0) {   // switch from consecutive working to day off
-            const Scenario::Shift &lastShift( problem.scenario.shifts[lastShiftID] );
+            const Scenario::Shift &lastShift( problem.scenario->shifts[lastShiftID] );
             if (shiftBegin) {
                 if (problem.history.consecutiveShiftNums[nurse] > lastShift.maxConsecutiveShiftNum) {
                     objValue += DefaultPenalty::ConsecutiveShift * (weekday - Weekday::Mon);
@@ -365,37 +378,19 @@ void NurseRostering::Solver::checkConsecutiveViolation( int &objValue,
 
 void NurseRostering::Solver::discoverNurseSkillRelation()
 {
-    nurseNumOfSkill = vector<SkillID>( problem.scenario.skillSize, 0 );
-    nurseWithSkill = vector< vector< vector<NurseID> > >( problem.scenario.skillSize );
-    nursesHasSameSkill = vector< vector<bool> >( problem.scenario.nurseNum, vector<bool>( problem.scenario.nurseNum ) );
-
-    for (NurseID nurse = 0; nurse < problem.scenario.nurseNum; ++nurse) {
-        const vector<bool> &skills = problem.scenario.nurses[nurse].skills;
-        unsigned skillNum = problem.scenario.nurses[nurse].skillNum;
-        for (SkillID skill = NurseRostering::Scenario::Skill::ID_BEGIN; skill < problem.scenario.skillSize; ++skill) {
-            if (skills[skill]) {
-                ++nurseNumOfSkill[skill];
-                if (skillNum > nurseWithSkill[skill].size()) {
-                    nurseWithSkill[skill].resize( skillNum );
-                }
-                nurseWithSkill[skill][skillNum - 1].push_back( nurse );
-            }
-        }
-        for (NurseID nurse2 = 0; nurse2 < problem.scenario.nurseNum; ++nurse2) {
-            nursesHasSameSkill[nurse][nurse2] = problem.haveSameSkill( nurse, nurse2 );
-        }
-    }
+    nurseSkillRelation = (problem.nurseSkillRelation != NULL)
+        ? problem.nurseSkillRelation : problem.discoverNurseSkillRelation();
 }
 
 
 
 NurseRostering::TabuSolver::TabuSolver( const NurseRostering &input, Timer::TimePoint st )
-    :Solver( input, st ), sln( *this ), dayTabuTenureBase( 1 ), shiftTabuTenureBase( 1 )
+    :Solver( input, st ), scanPool( input.scanThreadNum ), sln( *this ), dayTabuTenureBase( 1 ), shiftTabuTenureBase( 1 )
 {
 }
 
 NurseRostering::TabuSolver::TabuSolver( const NurseRostering &input, const Output &opt, Timer::TimePoint st )
-    : Solver( input, opt, st ), sln( *this ), dayTabuTenureBase( 1 ), shiftTabuTenureBase( 1 )
+    : Solver( input, opt, st ), scanPool( input.scanThreadNum ), sln( *this ), dayTabuTenureBase( 1 ), shiftTabuTenureBase( 1 )
 {
 }
 
@@ -406,7 +401,9 @@ void NurseRostering::TabuSolver::init( const Config &cfg, const std::string &id
     algorithmName = "Tabu";
     iterationCount = 0;
     generationCount = 0;
-    randGen.seed( problem.randSeed );
+    randGen.seed( randSeed );
+    sln.setRandSeed( randGen() );
+    sln.setScanPool( &scanPool );
 
     setTabuTenure();
     setMaxNoImprove( config.maxNoImproveCoefficient );
@@ -419,6 +416,9 @@ void NurseRostering::TabuSolver::init( const Config &cfg, const std::string &id
         case InitAlgorithm::Exact:
             exactInit();
             break;
+        case InitAlgorithm::WarmStart:
+            warmStartInit();
+            break;
         case InitAlgorithm::Greedy:
         default:
             greedyInit();
@@ -430,6 +430,11 @@ void NurseRostering::TabuSolver::init( const Config &cfg, const std::string &id
 
 void NurseRostering::TabuSolver::solve()
 {
+    // suspended arms should not start searching
+    if (portfolio != NULL) {
+        portfolio->checkpoint( arm, 0 );
+    }
+
     switch (config.solveAlgorithm) {
         case SolveAlgorithm::RandomWalk:
             randomWalk();
@@ -449,13 +454,19 @@ void NurseRostering::TabuSolver::solve()
         case Solver::SolveAlgorithm::SwapChainSearch:
             swapChainSearch( config.modeSeq );
             break;
+        case Solver::SolveAlgorithm::PathRelinking:
+            pathRelinking( config.modeSeq );
+            break;
+        case Solver::SolveAlgorithm::Memetic:
+            memeticSearch( config.modeSeq );
+            break;
         case SolveAlgorithm::TabuSearch_Rand:
         default:
             tabuSearch( config.modeSeq, &Solution::tabuSearch_Rand, MaxNoImproveForAllNeighborhood() );
             break;
     }
 #ifdef INRC2_LOG
-    if (problem.history.currentWeek < problem.scenario.totalWeekNum) {
+    if (problem.history.currentWeek < problem.scenario->totalWeekNum) {
         sln.rebuild( optima );
         sln.evaluateObjValue( false );
         optima = Output( sln.getObjValue(), sln.getAssignTable(),
@@ -466,9 +477,11 @@ void NurseRostering::TabuSolver::solve()
 
 bool NurseRostering::TabuSolver::updateOptima( const Output &localOptima )
 {
+    ObjValue lastObjValue = optima.getObjValue();
+    bool isUpdated = false;
     if (localOptima.getObjValue() < optima.getObjValue()) {
         optima = localOptima;
-        return true;
+        isUpdated = true;
     } else if (localOptima.getObjValue() == optima.getObjValue()) {
 #ifdef INRC2_SECONDARY_OBJ_VALUE
         bool  isSelected = (localOptima.getSecondaryObjValue() < optima.getSecondaryObjValue());
@@ -477,11 +490,29 @@ bool NurseRostering::TabuSolver::updateOptima( const Output &localOptima )
 #endif
         if (isSelected) {
             optima = localOptima;
-            return true;
+            isUpdated = true;
+        }
+    }
+
+    if (sharedOptima != NULL) {
+        if (isUpdated) {
+            sharedOptima->update( optima );
+        } else if ((sharedOptima->getObjValue() < optima.getObjValue())
+            && ((randGen() % SHARED_OPTIMA_SELECT) == 0)) {
+            // restarts from optima will start from the shared one
+            sharedOptima->get( optima );
+        }
+    }
+
+    if (portfolio != NULL) {
+        double improvement = 0;
+        if (isUpdated && (lastObjValue > 0) && (lastObjValue < DefaultPenalty::FORBIDDEN_MOVE)) {
+            improvement = static_cast<double>(lastObjValue - localOptima.getObjValue()) / lastObjValue;
         }
+        portfolio->checkpoint( arm, improvement );
     }
 
-    return false;
+    return isUpdated;
 }
 
 NurseRostering::History NurseRostering::TabuSolver::genHistory() const
@@ -489,11 +520,86 @@ NurseRostering::History NurseRostering::TabuSolver::genHistory() const
     return Solution( *this, optima ).genHistory();
 }
 
+NurseRostering::TabuSolver::Restart::Restart( TabuSolver &solver, const Solution::ModeSeqPattern &pattern,
+    Solution::TabuSearch searchMethod, IterCount maxNoImprove, bool swapChainFollowed )
+    : s( solver ), modeSeqPat( pattern ), search( searchMethod ),
+    maxNoImproveCount( std::max( maxNoImprove / std::max( solver.problem.restartNum, 1 ), 1 ) ),
+    isSwapChainFollowed( swapChainFollowed ), origin( NULL )
+{
+    // leave the random sequence of the sequential search untouched
+    if (solver.problem.restartNum > 1) {
+        for (int i = 0; i < solver.scanPool.size(); ++i) {
+            slns.push_back( new Solution( solver ) );
+        }
+    }
+}
+
+NurseRostering::TabuSolver::Restart::~Restart()
+{
+    for (std::vector<Solution*>::iterator iter = slns.begin(); iter != slns.end(); ++iter) {
+        delete *iter;
+    }
+}
+
+const NurseRostering::Output& NurseRostering::TabuSolver::Restart::run(
+    const Output &originOutput, double perturbStrength, double perturbStrengthDelta )
+{
+    origin = &originOutput;
+    strengths.resize( s.problem.restartNum );
+    seeds.resize( s.problem.restartNum );
+    for (int k = 0; k < s.problem.restartNum; ++k) {
+        strengths[k] = std::min( perturbStrength + k * perturbStrengthDelta, MAX_PERTURB_STRENGTH );
+        seeds[k] = s.randGen();
+    }
+    results.assign( s.problem.restartNum, Output() );
+
+    s.scanPool.run( *this );
+
+    int best = 0;
+    for (int k = 1; k < s.problem.restartNum; ++k) {
+        if (results[k].getObjValue() < results[best].getObjValue()) { best = k; }
+    }
+    return results[best];
+}
+
+NurseRostering::IterCount NurseRostering::TabuSolver::Restart::getIterCount() const
+{
+    IterCount iterCount = 0;
+    for (std::vector<Solution*>::const_iterator iter = slns.begin(); iter != slns.end(); ++iter) {
+        iterCount += (*iter)->getIterCount();
+    }
+    return iterCount;
+}
+
+void NurseRostering::TabuSolver::Restart::operator()( int workerIndex )
+{
+    Solution &sln( *slns[workerIndex] );
+    for (int k = workerIndex; k < static_cast<int>(results.size()); k += static_cast<int>(slns.size())) {
+        // each restart is reproducible regardless of the worker number
+        sln.setRandSeed( seeds[k] );
+#ifdef INRC2_PERTRUB_IN_REBUILD
+        sln.rebuild( *origin, strengths[k] );
+#else
+        sln.rebuild( *origin );
+        sln.perturb( strengths[k] );
+#endif
+        (sln.*search)(s.timer, modeSeqPat, maxNoImproveCount);
+        if (isSwapChainFollowed) {
+#ifdef INRC2_SWAP_CHAIN_DOUBLE_HEAD
+            sln.swapChainSearch_DoubleHead( s.timer, s.MaxNoImproveSwapChainLength() );
+#else
+            sln.swapChainSearch( s.timer, s.MaxNoImproveSwapChainLength() );
+#endif
+        }
+        results[k] = sln.getOptima();
+    }
+}
+
 void NurseRostering::TabuSolver::greedyInit()
 {
     algorithmName += "[GreedyInit]";
 
-    if (sln.genInitAssign( static_cast<int>(sqrt( problem.scenario.nurseNum )) + 1 ) == false) {
+    if (sln.genInitAssign( static_cast<int>(sqrt( problem.scenario->nurseNum )) + 1 ) == false) {
         errorLog( "fail to generate feasible init solution." );
     }
 }
@@ -507,6 +613,16 @@ void NurseRostering::TabuSolver::exactInit()
     }
 }
 
+void NurseRostering::TabuSolver::warmStartInit()
+{
+    if ((problem.lastWeekAssign.size() == problem.scenario->nurseNum)
+        && sln.genInitAssign_WarmStart( problem.lastWeekAssign )) {
+        algorithmName += "[WarmStartInit]";
+    } else {
+        greedyInit();
+    }
+}
+
 void NurseRostering::TabuSolver::randomWalk()
 {
     algorithmName += solveAlgorithmName[config.solveAlgorithm];
@@ -522,21 +638,12 @@ void NurseRostering::TabuSolver::iterativeLocalSearch( Solution::ModeSeq modeSeq
     algorithmName += solveAlgorithmName[config.solveAlgorithm];
     algorithmName += Solution::modeSeqNames[modeSeq];
 
-    const vector<int> &modeSeqPat( Solution::modeSeqPatterns[modeSeq] );
-    int modeSeqLen = modeSeqPat.size();
-
-    Solution::FindBestMoveTable fbmt( modeSeqLen );
-    Solution::FindBestMoveTable fbmtobb( modeSeqLen );
-
-    for (int i = 0; i < modeSeqLen; ++i) {
-        fbmt[i] = Solution::findBestMove[modeSeqPat[i]];
-        fbmtobb[i] = Solution::findBestMoveOnBlockBorder[modeSeqPat[i]];
-    }
+    const Solution::ModeSeqPattern &modeSeqPat( Solution::modeSeqPatterns[modeSeq] );
 
     double perturbStrength = INIT_PERTURB_STRENGTH;
     double perturbStrengthDelta = PERTURB_STRENGTH_DELTA;
     while (!timer.isTimeOut() && (iterationCount < problem.maxIterCount)) {
-        sln.localSearch( timer, ((randGen() % 2) ? fbmt : fbmtobb) );
+        sln.localSearch( timer, modeSeqPat, ((randGen() % 2) == 0) );
         ++generationCount;
 
         if (updateOptima( sln.getOptima() )) {
@@ -561,22 +668,25 @@ void NurseRostering::TabuSolver::tabuSearch( Solution::ModeSeq modeSeq, Solution
     algorithmName += solveAlgorithmName[config.solveAlgorithm];
     algorithmName += Solution::modeSeqNames[modeSeq];
 
-    const vector<int> &modeSeqPat( Solution::modeSeqPatterns[modeSeq] );
-    int modeSeqLen = modeSeqPat.size();
+    const Solution::ModeSeqPattern &modeSeqPat( Solution::modeSeqPatterns[modeSeq] );
 
-    Solution::FindBestMoveTable fbmt( modeSeqLen );
-
-    for (int i = 0; i < modeSeqLen; ++i) {
-        fbmt[i] = Solution::findBestMove[modeSeqPat[i]];
-    }
+    Restart restart( *this, modeSeqPat, search, maxNoImproveCount, false );
+    Output origin;
 
     double perturbStrength = INIT_PERTURB_STRENGTH;
     double perturbStrengthDelta = PERTURB_STRENGTH_DELTA;
     while (!timer.isTimeOut() && (iterationCount < problem.maxIterCount)) {
-        (sln.*search)(timer, fbmt, maxNoImproveCount);
-        ++generationCount;
+        const Output *localOptima = &sln.getOptima();
+        if ((problem.restartNum > 1) && (generationCount > 0)) {
+            localOptima = &restart.run( origin, perturbStrength, perturbStrengthDelta );
+            generationCount += problem.restartNum;
+            iterationCount = sln.getIterCount() + restart.getIterCount();
+        } else {
+            (sln.*search)(timer, modeSeqPat, maxNoImproveCount);
+            ++generationCount;
+        }
 
-        if (updateOptima( sln.getOptima() )) {
+        if (updateOptima( *localOptima )) {
 #ifdef INRC2_INC_PERTURB_STRENGTH_DELTA
             perturbStrengthDelta = PERTURB_STRENGTH_DELTA;
 #endif
@@ -588,7 +698,11 @@ void NurseRostering::TabuSolver::tabuSearch( Solution::ModeSeq modeSeq, Solution
             perturbStrength += perturbStrengthDelta;
         }
         const Output &output( (randGen() % PERTURB_ORIGIN_SELECT)
-            ? optima : sln.getOptima() );
+            ? optima : *localOptima );
+        if (problem.restartNum > 1) {
+            origin = output;
+            continue;
+        }
 #ifdef INRC2_PERTRUB_IN_REBUILD
         sln.rebuild( output, perturbStrength );
 #else
@@ -597,7 +711,7 @@ void NurseRostering::TabuSolver::tabuSearch( Solution::ModeSeq modeSeq, Solution
 #endif
     }
 
-    iterationCount = sln.getIterCount();
+    iterationCount = sln.getIterCount() + restart.getIterCount();
 }
 
 void NurseRostering::TabuSolver::biasTabuSearch( Solution::ModeSeq modeSeq )
@@ -605,17 +719,10 @@ void NurseRostering::TabuSolver::biasTabuSearch( Solution::ModeSeq modeSeq )
     algorithmName += solveAlgorithmName[config.solveAlgorithm];
     algorithmName += Solution::modeSeqNames[modeSeq];
 
-    const vector<int> &modeSeqPat( Solution::modeSeqPatterns[modeSeq] );
-    int modeSeqLen = modeSeqPat.size();
-
-    Solution::FindBestMoveTable fbmt( modeSeqLen );
-
-    for (int i = 0; i < modeSeqLen; ++i) {
-        fbmt[i] = Solution::findBestMove[modeSeqPat[i]];
-    }
+    const Solution::ModeSeqPattern &modeSeqPat( Solution::modeSeqPatterns[modeSeq] );
 
     while (!timer.isTimeOut() && (iterationCount < problem.maxIterCount)) {
-        sln.tabuSearch_Rand( timer, fbmt, MaxNoImproveForAllNeighborhood() );
+        sln.tabuSearch_Rand( timer, modeSeqPat, MaxNoImproveForAllNeighborhood() );
 
         updateOptima( sln.getOptima() );
         const Output &output( (randGen() % BIAS_TS_ORIGIN_SELECT)
@@ -623,7 +730,7 @@ void NurseRostering::TabuSolver::biasTabuSearch( Solution::ModeSeq modeSeq )
         sln.rebuild( output );
 
         sln.adjustWeightToBiasNurseWithGreaterPenalty( INVERSE_TOTAL_BIAS_RATIO, INVERSE_PENALTY_BIAS_RATIO );
-        sln.tabuSearch_Rand( timer, fbmt, MaxNoImproveForBiasTabuSearch() );
+        sln.tabuSearch_Rand( timer, modeSeqPat, MaxNoImproveForBiasTabuSearch() );
         ++generationCount;
         sln.rebuild( sln.getOptima() );
         sln.evaluateObjValue();
@@ -637,27 +744,151 @@ void NurseRostering::TabuSolver::swapChainSearch( Solution::ModeSeq modeSeq )
     algorithmName += solveAlgorithmName[config.solveAlgorithm];
     algorithmName += Solution::modeSeqNames[modeSeq];
 
-    const vector<int> &modeSeqPat( Solution::modeSeqPatterns[modeSeq] );
-    int modeSeqLen = modeSeqPat.size();
-
-    Solution::FindBestMoveTable fbmt( modeSeqLen );
+    const Solution::ModeSeqPattern &modeSeqPat( Solution::modeSeqPatterns[modeSeq] );
 
-    for (int i = 0; i < modeSeqLen; ++i) {
-        fbmt[i] = Solution::findBestMove[modeSeqPat[i]];
-    }
+    Restart restart( *this, modeSeqPat, &Solution::tabuSearch_Rand, MaxNoImproveForAllNeighborhood(), true );
+    Output origin;
 
     double perturbStrength = INIT_PERTURB_STRENGTH;
     double perturbStrengthDelta = PERTURB_STRENGTH_DELTA;
     while (!timer.isTimeOut() && (iterationCount < problem.maxIterCount)) {
-        sln.tabuSearch_Rand( timer, fbmt, MaxNoImproveForAllNeighborhood() );
+        const Output *localOptima = &sln.getOptima();
+        if ((problem.restartNum > 1) && (generationCount > 0)) {
+            localOptima = &restart.run( origin, perturbStrength, perturbStrengthDelta );
+            generationCount += problem.restartNum;
+            iterationCount = sln.getIterCount() + restart.getIterCount();
+        } else {
+            sln.tabuSearch_Rand( timer, modeSeqPat, MaxNoImproveForAllNeighborhood() );
 #ifdef INRC2_SWAP_CHAIN_DOUBLE_HEAD
-        sln.swapChainSearch_DoubleHead( timer, MaxNoImproveSwapChainLength() );
+            sln.swapChainSearch_DoubleHead( timer, MaxNoImproveSwapChainLength() );
+#else
+            sln.swapChainSearch( timer, MaxNoImproveSwapChainLength() );
+#endif
+            ++generationCount;
+        }
+
+        if (updateOptima( *localOptima )) {
+#ifdef INRC2_INC_PERTURB_STRENGTH_DELTA
+            perturbStrengthDelta = PERTURB_STRENGTH_DELTA;
+#endif
+            perturbStrength = INIT_PERTURB_STRENGTH;
+        } else if (perturbStrength < MAX_PERTURB_STRENGTH) {
+#ifdef INRC2_INC_PERTURB_STRENGTH_DELTA
+            perturbStrengthDelta += PERTURB_STRENGTH_DELTA;
+#endif
+            perturbStrength += perturbStrengthDelta;
+        }
+        const Output &output( (randGen() % PERTURB_ORIGIN_SELECT)
+            ? optima : *localOptima );
+        if (problem.restartNum > 1) {
+            origin = output;
+            continue;
+        }
+#ifdef INRC2_PERTRUB_IN_REBUILD
+        sln.rebuild( output, perturbStrength );
 #else
-        sln.swapChainSearch( timer, MaxNoImproveSwapChainLength() );
+        sln.rebuild( output );
+        sln.perturb( perturbStrength );
 #endif
+    }
+
+    iterationCount = sln.getIterCount() + restart.getIterCount();
+}
+
+void NurseRostering::TabuSolver::pathRelinking( Solution::ModeSeq modeSeq )
+{
+    algorithmName += solveAlgorithmName[config.solveAlgorithm];
+    algorithmName += Solution::modeSeqNames[modeSeq];
+
+    const Solution::ModeSeqPattern &modeSeqPat( Solution::modeSeqPatterns[modeSeq] );
+
+    ElitePool elites( ELITE_POOL_SIZE,
+        problem.scenario->nurseNum * Weekday::NUM / INVERSE_ELITE_DISTANCE_RATIO );
+
+    // relink the k-th pair of elites and improve the best solution
+    // on the path with the solution of worker (k % workerNum)
+    class Relink : public ThreadPool::Job
+    {
+    public:
+        Relink( TabuSolver &solver, const ElitePool &elitePool, const Solution::ModeSeqPattern &pattern, int workerNum )
+            : s( solver ), elites( elitePool ), modeSeqPat( pattern )
+        {
+            for (int i = 0; i < workerNum; ++i) {
+                slns.push_back( new Solution( solver ) );
+                slns.back()->setRandSeed( solver.randGen() );
+            }
+        }
+        ~Relink()
+        {
+            for (std::vector<Solution*>::iterator iter = slns.begin(); iter != slns.end(); ++iter) {
+                delete *iter;
+            }
+        }
+
+        virtual void operator()( int workerIndex )
+        {
+            Solution &sln( *slns[workerIndex] );
+            for (int k = workerIndex; k < static_cast<int>(pairs.size()); k += static_cast<int>(slns.size())) {
+                Output bestOnPath;
+                sln.rebuild( elites[pairs[k].first] );
+                if (sln.pathRelinking( s.timer, elites[pairs[k].second].getAssignTable(), bestOnPath )) {
+                    sln.rebuild( bestOnPath );
+                    sln.tabuSearch_Rand( s.timer, modeSeqPat, s.MaxNoImproveForAllNeighborhood() );
+                    results[k] = sln.getOptima();
+                }
+            }
+        }
+
+        IterCount getIterCount() const
+        {
+            IterCount iterCount = 0;
+            for (std::vector<Solution*>::const_iterator iter = slns.begin(); iter != slns.end(); ++iter) {
+                iterCount += (*iter)->getIterCount();
+            }
+            return iterCount;
+        }
+
+        TabuSolver &s;
+        const ElitePool &elites;
+        const Solution::ModeSeqPattern &modeSeqPat;
+        std::vector<Solution*> slns;
+        // (initial elite, guiding elite)
+        std::vector< std::pair<int, int> > pairs;
+        std::vector<Output> results;
+    };
+
+    Relink relink( *this, elites, modeSeqPat, scanPool.size() );
+
+    double perturbStrength = INIT_PERTURB_STRENGTH;
+    double perturbStrengthDelta = PERTURB_STRENGTH_DELTA;
+    while (!timer.isTimeOut() && (iterationCount < problem.maxIterCount)) {
+        sln.tabuSearch_Rand( timer, modeSeqPat, MaxNoImproveForAllNeighborhood() );
         ++generationCount;
 
-        if (updateOptima( sln.getOptima() )) {
+        elites.add( sln.getOptima() );
+        bool isUpdated = updateOptima( sln.getOptima() );
+
+        // relink a pair of different elites for each worker
+        if (elites.size() > 1) {
+            relink.pairs.clear();
+            for (int i = 0; i < scanPool.size(); ++i) {
+                int initial = randGen() % elites.size();
+                int guiding = (initial + 1 + randGen() % (elites.size() - 1)) % elites.size();
+                relink.pairs.push_back( std::make_pair( initial, guiding ) );
+            }
+            relink.results.assign( relink.pairs.size(), Output() );
+            scanPool.run( relink );
+            iterationCount = sln.getIterCount() + relink.getIterCount();
+            for (std::vector<Output>::const_iterator iter = relink.results.begin();
+                iter != relink.results.end(); ++iter) {
+                if (iter->getObjValue() < DefaultPenalty::MAX_OBJ_VALUE) {
+                    elites.add( *iter );
+                    isUpdated |= updateOptima( *iter );
+                }
+            }
+        }
+
+        if (isUpdated) {
 #ifdef INRC2_INC_PERTURB_STRENGTH_DELTA
             perturbStrengthDelta = PERTURB_STRENGTH_DELTA;
 #endif
@@ -678,7 +909,109 @@ void NurseRostering::TabuSolver::swapChainSearch( Solution::ModeSeq modeSeq )
 #endif
     }
 
-    iterationCount = sln.getIterCount();
+    iterationCount = sln.getIterCount() + relink.getIterCount();
+}
+
+void NurseRostering::TabuSolver::memeticSearch( Solution::ModeSeq modeSeq )
+{
+    algorithmName += solveAlgorithmName[config.solveAlgorithm];
+    algorithmName += Solution::modeSeqNames[modeSeq];
+
+    const Solution::ModeSeqPattern &modeSeqPat( Solution::modeSeqPatterns[modeSeq] );
+
+    int populationSize = std::max( static_cast<int>(MIN_POPULATION_SIZE), scanPool.size() );
+    ElitePool population( populationSize,
+        problem.scenario->nurseNum * Weekday::NUM / INVERSE_ELITE_DISTANCE_RATIO );
+
+    // breed the k-th child and improve it with the solution of worker (k % workerNum)
+    class Breed : public ThreadPool::Job
+    {
+    public:
+        // a child is generated by greedy init if parent is negative
+        struct Parents
+        {
+            int parent;
+            int parent2;
+            bool isRowWise;
+        };
+
+        Breed( TabuSolver &solver, const ElitePool &pool, const Solution::ModeSeqPattern &pattern, int workerNum )
+            : s( solver ), population( pool ), modeSeqPat( pattern )
+        {
+            for (int i = 0; i < workerNum; ++i) {
+                slns.push_back( new Solution( solver ) );
+                slns.back()->setRandSeed( solver.randGen() );
+            }
+        }
+        ~Breed()
+        {
+            for (std::vector<Solution*>::iterator iter = slns.begin(); iter != slns.end(); ++iter) {
+                delete *iter;
+            }
+        }
+
+        virtual void operator()( int workerIndex )
+        {
+            Solution &sln( *slns[workerIndex] );
+            for (int k = workerIndex; k < static_cast<int>(parents.size()); k += static_cast<int>(slns.size())) {
+                const Parents &p( parents[k] );
+                bool isFeasible = (p.parent < 0)
+                    ? sln.genInitAssign( static_cast<int>(sqrt( s.problem.scenario->nurseNum )) + 1 )
+                    : sln.crossover( s.timer, population[p.parent].getAssignTable(),
+                    population[p.parent2].getAssignTable(), p.isRowWise );
+                if (isFeasible) {
+                    sln.tabuSearch_Rand( s.timer, modeSeqPat, s.MaxNoImproveForAllNeighborhood() );
+                    results[k] = sln.getOptima();
+                }
+            }
+        }
+
+        IterCount getIterCount() const
+        {
+            IterCount iterCount = 0;
+            for (std::vector<Solution*>::const_iterator iter = slns.begin(); iter != slns.end(); ++iter) {
+                iterCount += (*iter)->getIterCount();
+            }
+            return iterCount;
+        }
+
+        TabuSolver &s;
+        const ElitePool &population;
+        const Solution::ModeSeqPattern &modeSeqPat;
+        std::vector<Solution*> slns;
+        std::vector<Parents> parents;
+        std::vector<Output> results;
+    };
+
+    Breed breed( *this, population, modeSeqPat, scanPool.size() );
+
+    while (!timer.isTimeOut() && (iterationCount < problem.maxIterCount)) {
+        // restart with new individuals if the population collapses
+        breed.parents.resize( populationSize );
+        for (std::vector<Breed::Parents>::iterator iter = breed.parents.begin();
+            iter != breed.parents.end(); ++iter) {
+            if (population.size() > 1) {
+                iter->parent = randGen() % population.size();
+                iter->parent2 = (iter->parent + 1 + randGen() % (population.size() - 1)) % population.size();
+                iter->isRowWise = ((randGen() % 2) == 0);
+            } else {
+                iter->parent = -1;
+            }
+        }
+        breed.results.assign( breed.parents.size(), Output() );
+        scanPool.run( breed );
+        ++generationCount;
+
+        for (std::vector<Output>::const_iterator iter = breed.results.begin();
+            iter != breed.results.end(); ++iter) {
+            if (iter->getObjValue() < DefaultPenalty::MAX_OBJ_VALUE) {
+                population.add( *iter );
+                updateOptima( *iter );
+            }
+        }
+
+        iterationCount = breed.getIterCount();
+    }
 }
 
 void NurseRostering::TabuSolver::setTabuTenure()
@@ -709,7 +1042,7 @@ void NurseRostering::TabuSolver::setDayTabuTenure_TableSize( double coefficient
 
         // plus 1 to make sure it will not be 0
         dayTabuTenureBase *= static_cast<IterCount>(1 + coefficient *
-            problem.scenario.nurseNum * Weekday::NUM);
+            problem.scenario->nurseNum * Weekday::NUM);
     }
 }
 
@@ -723,7 +1056,7 @@ void NurseRostering::TabuSolver::setShiftTabuTenure_TableSize( double coefficien
 
         // plus 1 to make sure it will not be 0
         shiftTabuTenureBase *= static_cast<IterCount>(1 + coefficient *
-            problem.scenario.nurseNum * Weekday::NUM * problem.scenario.shiftTypeNum * problem.scenario.skillTypeNum);
+            problem.scenario->nurseNum * Weekday::NUM * problem.scenario->shiftTypeNum * problem.scenario->skillTypeNum);
     }
 }
 
@@ -736,7 +1069,7 @@ void NurseRostering::TabuSolver::setDayTabuTenure_NurseNum( double coefficient )
         algorithmName += oss.str();
 
         // plus 1 to make sure it will not be 0
-        dayTabuTenureBase *= static_cast<IterCount>(1 + coefficient * problem.scenario.nurseNum);
+        dayTabuTenureBase *= static_cast<IterCount>(1 + coefficient * problem.scenario->nurseNum);
     }
 }
 
@@ -749,7 +1082,7 @@ void NurseRostering::TabuSolver::setShiftTabuTenure_NurseNum( double coefficient
         algorithmName += oss.str();
 
         // plus 1 to make sure it will not be 0
-        shiftTabuTenureBase *= static_cast<IterCount>(1 + coefficient * problem.scenario.nurseNum);
+        shiftTabuTenureBase *= static_cast<IterCount>(1 + coefficient * problem.scenario->nurseNum);
     }
 }
 
@@ -789,7 +1122,7 @@ void NurseRostering::TabuSolver::setDayTabuTenure_ShiftNum( double coefficient )
 
         // plus 1 to make sure it will not be 0
         dayTabuTenureBase *= static_cast<IterCount>(1 + coefficient *
-            problem.scenario.shiftTypeNum * problem.scenario.skillTypeNum);
+            problem.scenario->shiftTypeNum * problem.scenario->skillTypeNum);
     }
 }
 
@@ -803,6 +1136,217 @@ void NurseRostering::TabuSolver::setShiftTabuTenure_ShiftNum( double coefficient
 
         // plus 1 to make sure it will not be 0
         shiftTabuTenureBase *= static_cast<IterCount>(1 + coefficient *
-            problem.scenario.shiftTypeNum * problem.scenario.skillTypeNum);
+            problem.scenario->shiftTypeNum * problem.scenario->skillTypeNum);
+    }
+}
+
+
+
+bool NurseRostering::ElitePool::add( const Output &output )
+{
+    // decide whether output is admitted before modifying the pool
+    bool isCloseToElite = false;
+    std::vector<Output>::iterator worst = elites.end();
+    for (std::vector<Output>::iterator iter = elites.begin(); iter != elites.end(); ++iter) {
+        if (AssignTable::distance( output.getAssignTable(), iter->getAssignTable() ) < minDistance) {
+            if (output.getObjValue() >= iter->getObjValue()) { return false; }
+            isCloseToElite = true;
+        } else if ((worst == elites.end()) || (worst->getObjValue() < iter->getObjValue())) {
+            worst = iter;
+        }
+    }
+    if (!isCloseToElite && (static_cast<int>(elites.size()) >= capacity)
+        && (output.getObjValue() >= worst->getObjValue())) {
+        return false;
+    }
+
+    // replace all worse elites close to output, or the worst one if it is full
+    if (isCloseToElite) {
+        for (std::vector<Output>::iterator iter = elites.begin(); iter != elites.end();) {
+            if (AssignTable::distance( output.getAssignTable(), iter->getAssignTable() ) < minDistance) {
+                iter = elites.erase( iter );
+            } else {
+                ++iter;
+            }
+        }
+        elites.push_back( output );
+    } else if (static_cast<int>(elites.size()) < capacity) {
+        elites.push_back( output );
+    } else {
+        *worst = output;
+    }
+    return true;
+}
+
+NurseRostering::SharedOptima::SharedOptima( const NurseRostering &problem )
+    : nurseNum( problem.scenario->nurseNum ), objValue( DefaultPenalty::FORBIDDEN_MOVE ),
+    sequence( 0 ), secondaryObjValue( DefaultPenalty::FORBIDDEN_MOVE ), findTime( 0 ),
+    assigns( problem.scenario->nurseNum * AssignTable::STRIDE )
+{
+}
+
+bool NurseRostering::SharedOptima::update( const Output &output )
+{
+    if (output.getObjValue() >= getObjValue()) { return false; }
+
+    // lock out other writers by making the sequence odd
+    unsigned seq = sequence.load( memory_order_relaxed );
+    while (((seq & 1) != 0) || !sequence.compare_exchange_weak( seq, seq + 1, memory_order_acquire )) {
+        this_thread::yield();
+        seq = sequence.load( memory_order_relaxed );
+    }
+    atomic_thread_fence( memory_order_release );
+
+    // it may be improved by other writer during waiting
+    bool isUpdated = (output.getObjValue() < objValue.load( memory_order_relaxed ));
+    if (isUpdated) {
+        const AssignTable &assign( output.getAssignTable() );
+        for (NurseID nurse = 0; nurse < nurseNum; ++nurse) {
+            for (int weekday = 0; weekday < AssignTable::STRIDE; ++weekday) {
+                const Assign &a( assign[nurse][weekday] );
+                assigns[nurse * AssignTable::STRIDE + weekday].store(
+                    (static_cast<unsigned char>(a.shift) << 8) | static_cast<unsigned char>(a.skill),
+                    memory_order_relaxed );
+            }
+        }
+        secondaryObjValue.store( output.getSecondaryObjValue(), memory_order_relaxed );
+        findTime.store( output.getFindTime().time_since_epoch().count(), memory_order_relaxed );
+        objValue.store( output.getObjValue(), memory_order_relaxed );
+    }
+
+    sequence.store( seq + 2, memory_order_release );
+    return isUpdated;
+}
+
+bool NurseRostering::SharedOptima::get( Output &output ) const
+{
+    AssignTable assign( nurseNum );
+    ObjValue objVal;
+    double secondaryObjVal;
+    Timer::Clock::rep time;
+
+    for (;;) {
+        unsigned seq = sequence.load( memory_order_acquire );
+        if ((seq & 1) != 0) {
+            this_thread::yield();
+            continue;
+        }
+        for (NurseID nurse = 0; nurse < nurseNum; ++nurse) {
+            for (int weekday = 0; weekday < AssignTable::STRIDE; ++weekday) {
+                int a = assigns[nurse * AssignTable::STRIDE + weekday].load( memory_order_relaxed );
+                assign[nurse][weekday] = Assign( static_cast<signed char>(a >> 8), static_cast<signed char>(a & 0xff) );
+            }
+        }
+        objVal = objValue.load( memory_order_relaxed );
+        secondaryObjVal = secondaryObjValue.load( memory_order_relaxed );
+        time = findTime.load( memory_order_relaxed );
+        atomic_thread_fence( memory_order_acquire );
+        // the snapshot is consistent if no writer has started meanwhile
+        if (sequence.load( memory_order_relaxed ) == seq) { break; }
+    }
+
+    if (objVal >= DefaultPenalty::FORBIDDEN_MOVE) { return false; }
+
+    output = Output( objVal, assign, secondaryObjVal,
+        Timer::TimePoint( Timer::Clock::duration( time ) ) );
+    return true;
+}
+
+NurseRostering::Portfolio::Portfolio( int armNum, int runningNum, Timer::Duration ep )
+    : runningNum( runningNum ), epoch( ep ), isStopped( false ),
+    isRunning( armNum, false ), isSuspended( armNum ), runningEpochNums( armNum, 0 ),
+    improvements( armNum, 0 ), discountedRewards( armNum, 0 ), discountedCounts( armNum, 0 )
+{
+    for (int arm = 0; arm < armNum; ++arm) {
+        isRunning[arm] = (arm < runningNum);
+        isSuspended[arm].store( !isRunning[arm], memory_order_relaxed );
+        if (isRunning[arm]) { ++runningEpochNums[arm]; }
+    }
+}
+
+void NurseRostering::Portfolio::checkpoint( int arm, double improvement )
+{
+    unique_lock<mutex> lock( mtx );
+    improvements[arm] += improvement;
+    while (!isRunning[arm] && !isStopped) {
+        resumeCond.wait( lock );
+    }
+}
+
+void NurseRostering::Portfolio::schedule( const Timer &timer )
+{
+    while (timer.restTime() > epoch) {
+        this_thread::sleep_for( epoch );
+        reallocate();
+    }
+    this_thread::sleep_for( timer.restTime() );
+
+    lock_guard<mutex> lock( mtx );
+    isStopped = true;
+    for (int arm = 0; arm < static_cast<int>(isSuspended.size()); ++arm) {
+        isSuspended[arm].store( false, memory_order_relaxed );
+    }
+    resumeCond.notify_all();
+}
+
+void NurseRostering::Portfolio::reallocate()
+{
+    lock_guard<mutex> lock( mtx );
+
+    int armNum = static_cast<int>(isRunning.size());
+    double totalCount = 0;
+    double maxMeanReward = 0;
+    for (int arm = 0; arm < armNum; ++arm) {
+        discountedRewards[arm] *= DISCOUNT;
+        discountedCounts[arm] *= DISCOUNT;
+        if (isRunning[arm]) {
+            discountedRewards[arm] += min( improvements[arm], 1.0 );
+            discountedCounts[arm] += 1;
+        }
+        improvements[arm] = 0;
+        totalCount += discountedCounts[arm];
+        if ((discountedCounts[arm] > 0) && (discountedRewards[arm] / discountedCounts[arm] > maxMeanReward)) {
+            maxMeanReward = discountedRewards[arm] / discountedCounts[arm];
+        }
+    }
+
+    // the exploration term is scaled to the best mean reward to be
+    // independent of the magnitude of the objective
+    double explorationScale = (maxMeanReward > 0) ? maxMeanReward : 1;
+    vector<double> bounds( armNum );
+    for (int arm = 0; arm < armNum; ++arm) {
+        bounds[arm] = (discountedCounts[arm] > 0)
+            ? (discountedRewards[arm] / discountedCounts[arm] + explorationScale
+            * sqrt( EXPLORATION * log( totalCount ) / discountedCounts[arm] ))
+            : static_cast<double>(DefaultPenalty::FORBIDDEN_MOVE);   // arms never run are tried first
+    }
+
+    class CmpBound
+    {
+    public:
+        CmpBound( const vector<double> &upperBounds ) : bounds( upperBounds ) {}
+        // sort to (greatest ... least), ties are broken by arm index
+        bool operator()( const int &l, const int &r )
+        {
+            return ((bounds[l] > bounds[r]) || ((bounds[l] == bounds[r]) && (l < r)));
+        }
+
+    private:
+        const vector<double> &bounds;
+    } cmpBound( bounds );
+
+    vector<int> arms( armNum );
+    for (int arm = 0; arm < armNum; ++arm) { arms[arm] = arm; }
+    int selectNum = min( runningNum, armNum );
+    partial_sort( arms.begin(), arms.begin() + selectNum, arms.end(), cmpBound );
+
+    isRunning.assign( armNum, false );
+    for (int i = 0; i < selectNum; ++i) {
+        isRunning[arms[i]] = true;
+        ++runningEpochNums[arms[i]];
+    }
+    for (int arm = 0; arm < armNum; ++arm) {
+        isSuspended[arm].store( !isRunning[arm], memory_order_relaxed );
     }
+    resumeCond.notify_all();
 }
@@ -1,9 +1,241 @@
 #include "utility.h"
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 
 using namespace std;
 
 
+//
+TextTokenizer::TextTokenizer( const char *extraDelimiters ) : pos( 0 )
+{
+    fill( isDelimiter, isDelimiter + 256, false );
+    isDelimiter[static_cast<unsigned char>('\0')] = true;
+    isDelimiter[static_cast<unsigned char>(' ')] = true;
+    isDelimiter[static_cast<unsigned char>('\t')] = true;
+    isDelimiter[static_cast<unsigned char>('\r')] = true;
+    isDelimiter[static_cast<unsigned char>('\n')] = true;
+    for (; *extraDelimiters != '\0'; ++extraDelimiters) {
+        isDelimiter[static_cast<unsigned char>(*extraDelimiters)] = true;
+    }
+}
+
+bool TextTokenizer::load( const std::string &filename )
+{
+    ifstream ifs( filename, ios::binary );
+    if (!ifs.is_open()) {
+        return false;
+    }
+
+    ifs.seekg( 0, ios::end );
+    size_t size = static_cast<size_t>(ifs.tellg());
+    ifs.seekg( 0, ios::beg );
+    buf.resize( size + 1 );
+    ifs.read( buf.data(), size );
+    buf[size] = '\0';
+    pos = 0;
+
+    ifs.close();
+    return true;
+}
+
+const char* TextTokenizer::next()
+{
+    size_t size = buf.size() - 1;
+    while ((pos < size) && isDelimiter[static_cast<unsigned char>(buf[pos])]) { ++pos; }
+    if (pos >= size) {
+        return NULL;
+    }
+
+    char *token = buf.data() + pos;
+    while (!isDelimiter[static_cast<unsigned char>(buf[pos])]) { ++pos; }
+    buf[pos] = '\0';   // the last one overwrites the terminator itself
+    return token;
+}
+
+int TextTokenizer::nextInt()
+{
+    const char *token = next();
+    if (token == NULL) {
+        return 0;
+    }
+
+    bool isNegative = (*token == '-');
+    if (isNegative || (*token == '+')) { ++token; }
+    int value = 0;
+    for (; (*token >= '0') && (*token <= '9'); ++token) {
+        value = value * 10 + (*token - '0');
+    }
+    return (isNegative ? -value : value);
+}
+
+//
+#ifdef _WIN32
+MappedFile::MappedFile() : begin( NULL ), length( 0 ),
+fileHandle( INVALID_HANDLE_VALUE ), mappingHandle( NULL )
+{
+}
+#else
+MappedFile::MappedFile() : begin( NULL ), length( 0 )
+{
+}
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open( const std::string &filename )
+{
+    close();
+
+    fileHandle = CreateFileA( filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx( fileHandle, &fileSize )) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    if (length == 0) {  // empty file can not be mapped
+        return true;
+    }
+
+    mappingHandle = CreateFileMappingA( fileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+    if (mappingHandle == NULL) {
+        close();
+        return false;
+    }
+    begin = static_cast<const char *>(MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 ));
+    if (begin == NULL) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (begin != NULL) { UnmapViewOfFile( begin ); }
+    if (mappingHandle != NULL) { CloseHandle( mappingHandle ); }
+    if (fileHandle != INVALID_HANDLE_VALUE) { CloseHandle( fileHandle ); }
+    begin = NULL;
+    length = 0;
+    mappingHandle = NULL;
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+#else
+bool MappedFile::open( const std::string &filename )
+{
+    close();
+
+    int fd = ::open( filename.c_str(), O_RDONLY );
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat( fd, &fileStat ) != 0) {
+        ::close( fd );
+        return false;
+    }
+    length = static_cast<size_t>(fileStat.st_size);
+    if (length > 0) {   // empty file can not be mapped
+        void *addr = mmap( NULL, length, PROT_READ, MAP_SHARED, fd, 0 );
+        if (addr == MAP_FAILED) {
+            length = 0;
+            ::close( fd );
+            return false;
+        }
+        begin = static_cast<const char *>(addr);
+    }
+
+    // the mapping is still valid after the file is closed
+    ::close( fd );
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (begin != NULL) { munmap( const_cast<char *>(begin), length ); }
+    begin = NULL;
+    length = 0;
+}
+#endif
+
+//
+NameTable::NameTable( int capacity ) : usedNum( 0 )
+{
+    size_t size = 4;
+    while (size < static_cast<size_t>(2 * capacity)) { size *= 2; }
+    entries.resize( size );
+}
+
+void NameTable::insert( const std::string &name, int id )
+{
+    if (2 * (usedNum + 1) > entries.size()) {
+        rehash( 2 * entries.size() );
+    }
+
+    unsigned hashValue = hash( name.c_str() );
+    Entry &entry( entries[probe( name.c_str(), hashValue )] );
+    if (!entry.isUsed) {
+        entry.name = name;
+        entry.hashValue = hashValue;
+        entry.isUsed = true;
+        ++usedNum;
+    }
+    entry.id = id;
+}
+
+bool NameTable::find( const char *name, int &id ) const
+{
+    const Entry &entry( entries[probe( name, hash( name ) )] );
+    if (entry.isUsed) {
+        id = entry.id;
+    }
+    return entry.isUsed;
+}
+
+size_t NameTable::probe( const char *name, unsigned hashValue ) const
+{
+    size_t mask = entries.size() - 1;
+    size_t i = hashValue & mask;
+    while (entries[i].isUsed
+        && ((entries[i].hashValue != hashValue) || (entries[i].name != name))) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void NameTable::rehash( size_t capacity )
+{
+    vector<Entry> oldEntries( capacity );
+    oldEntries.swap( entries );
+    for (vector<Entry>::iterator iter = oldEntries.begin(); iter != oldEntries.end(); ++iter) {
+        if (iter->isUsed) {
+            Entry &entry( entries[probe( iter->name.c_str(), iter->hashValue )] );
+            entry = *iter;
+        }
+    }
+}
+
 //
 std::string getLastNoneEmptyLine( const std::string &filename )
 {
@@ -49,6 +281,23 @@ std::string getTime()
     return std::string( timeBuf );
 }
 
+//
+std::string getCanonicalPath( const std::string &path )
+{
+#ifdef _WIN32
+    char *fullPath = _fullpath( NULL, path.c_str(), 0 );
+#else
+    char *fullPath = realpath( path.c_str(), NULL );
+#endif
+    if (fullPath == NULL) {
+        return path;
+    }
+
+    std::string canonicalPath( fullPath );
+    free( fullPath );
+    return canonicalPath;
+}
+
 //
 void errorLog( const std::string &msg )
 {
@@ -60,3 +309,75 @@ void errorLog( const std::string &msg )
 //
 std::mutex logFileMutex;
 
+
+//
+ThreadPool::ThreadPool( int threadNum )
+    : job( NULL ), generation( 0 ), busyWorkerNum( 0 ), isStopped( false )
+{
+    for (int i = 1; i < threadNum; ++i) {
+        threads.push_back( std::thread( &ThreadPool::work, this, i ) );
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( mtx );
+        isStopped = true;
+    }
+    startCond.notify_all();
+    for (std::vector<std::thread>::iterator iter = threads.begin();
+        iter != threads.end(); ++iter) {
+        iter->join();
+    }
+}
+
+void ThreadPool::run( Job &j )
+{
+    {
+        std::unique_lock<std::mutex> lock( mtx );
+        // workers are all occupied if it is called inside a running job,
+        // then the calling thread does all the parts of the job in order
+        if (threads.empty() || (job != NULL)) {
+            lock.unlock();
+            for (int i = 0; i < size(); ++i) { j( i ); }
+            return;
+        }
+        job = &j;
+        busyWorkerNum = static_cast<int>(threads.size());
+        ++generation;
+    }
+    startCond.notify_all();
+
+    j( 0 );
+
+    std::unique_lock<std::mutex> lock( mtx );
+    while (busyWorkerNum > 0) {
+        finishCond.wait( lock );
+    }
+    job = NULL;
+}
+
+void ThreadPool::work( int workerIndex )
+{
+    int finishedGeneration = 0;
+    for (;;) {
+        Job *j;
+        {
+            std::unique_lock<std::mutex> lock( mtx );
+            while (!isStopped && (generation == finishedGeneration)) {
+                startCond.wait( lock );
+            }
+            if (isStopped) { return; }
+            finishedGeneration = generation;
+            j = job;
+        }
+
+        (*j)( workerIndex );
+
+        std::lock_guard<std::mutex> lock( mtx );
+        if (--busyWorkerNum == 0) {
+            finishCond.notify_one();
+        }
+    }
+}